@@ -32,6 +32,9 @@
 #include <errno.h>
 
 #include <nuttx/drivers/ramdisk.h>
+#include <nuttx/fs/fs.h>
+#include <nuttx/fs/ioctl.h>
+#include <nuttx/sched.h>
 
 #include "sim_internal.h"
 
@@ -42,6 +45,105 @@
 #define NSECTORS            2048
 #define LOGICAL_SECTOR_SIZE 512
 
+/****************************************************************************
+ * Private Function Prototypes
+ ****************************************************************************/
+
+#if CONFIG_SIM_BLOCKDEVICE_LATENCY > 0
+static ssize_t sim_blkread(struct inode *inode, unsigned char *buffer,
+                           blkcnt_t start, unsigned int nsectors);
+static ssize_t sim_blkwrite(struct inode *inode,
+                            const unsigned char *buffer,
+                            blkcnt_t start, unsigned int nsectors);
+static int sim_blkgeometry(struct inode *inode,
+                           struct geometry *geometry);
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static const struct block_operations g_sim_blkops =
+{
+  NULL,            /* open */
+  NULL,            /* close */
+  sim_blkread,     /* read */
+  sim_blkwrite,    /* write */
+  sim_blkgeometry, /* geometry */
+  NULL             /* ioctl */
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: sim_blkclip
+ *
+ * Description:
+ *   Wait for the simulated access time and clip the request to the device
+ *
+ ****************************************************************************/
+
+static unsigned int sim_blkclip(blkcnt_t start, unsigned int nsectors)
+{
+  nxsched_usleep(CONFIG_SIM_BLOCKDEVICE_LATENCY);
+
+  if (start >= NSECTORS)
+    {
+      return 0;
+    }
+
+  if (start + nsectors > NSECTORS)
+    {
+      nsectors = NSECTORS - start;
+    }
+
+  return nsectors;
+}
+
+/****************************************************************************
+ * Name: sim_blkread
+ ****************************************************************************/
+
+static ssize_t sim_blkread(struct inode *inode, unsigned char *buffer,
+                           blkcnt_t start, unsigned int nsectors)
+{
+  nsectors = sim_blkclip(start, nsectors);
+  memcpy(buffer, sim_deviceimage() + start * LOGICAL_SECTOR_SIZE,
+         nsectors * LOGICAL_SECTOR_SIZE);
+  return nsectors;
+}
+
+/****************************************************************************
+ * Name: sim_blkwrite
+ ****************************************************************************/
+
+static ssize_t sim_blkwrite(struct inode *inode,
+                            const unsigned char *buffer,
+                            blkcnt_t start, unsigned int nsectors)
+{
+  nsectors = sim_blkclip(start, nsectors);
+  memcpy(sim_deviceimage() + start * LOGICAL_SECTOR_SIZE, buffer,
+         nsectors * LOGICAL_SECTOR_SIZE);
+  return nsectors;
+}
+
+/****************************************************************************
+ * Name: sim_blkgeometry
+ ****************************************************************************/
+
+static int sim_blkgeometry(struct inode *inode,
+                           struct geometry *geometry)
+{
+  memset(geometry, 0, sizeof(*geometry));
+  geometry->geo_available    = true;
+  geometry->geo_writeenabled = true;
+  geometry->geo_nsectors     = NSECTORS;
+  geometry->geo_sectorsize   = LOGICAL_SECTOR_SIZE;
+  return OK;
+}
+#endif
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -55,6 +157,10 @@
 
 void sim_registerblockdevice(void)
 {
+#if CONFIG_SIM_BLOCKDEVICE_LATENCY > 0
+  register_blockdriver("/dev/ram0", &g_sim_blkops, 0666, NULL);
+#else
   ramdisk_register(0, (uint8_t *)sim_deviceimage(), NSECTORS,
                    LOGICAL_SECTOR_SIZE, RDFLAG_WRENABLED | RDFLAG_FUNLINK);
+#endif
 }
@@ -28,6 +28,7 @@
 
 #include <assert.h>
 #include <debug.h>
+#include <errno.h>
 #include <string.h>
 #include <stdbool.h>
 
@@ -600,6 +601,22 @@ struct mallinfo_task mm_mallinfo_task(struct mm_heap_s *heap,
   return info;
 }
 
+/****************************************************************************
+ * Name: mm_magazineinfo
+ *
+ * Description:
+ *   The host heap has no multiple mempool, and so no magazines.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_MM_HEAP_MEMPOOL_MAGAZINE
+int mm_magazineinfo(struct mm_heap_s *heap, int cpu,
+                    struct mempool_magazineinfo_s *info)
+{
+  return -ENOSYS;
+}
+#endif
+
 /****************************************************************************
  * Name: mm_memdump
  *
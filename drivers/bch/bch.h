@@ -42,6 +42,21 @@
 
 #define MAX_OPENCNT       (255)                  /* Limit of uint8_t */
 
+/* Whole sectors are transferred directly between the block driver and the
+ * user buffer, unless the data has to be transformed on the way or the
+ * user buffer doesn't meet the alignment required by the driver.  Then
+ * they go through the sector buffer.
+ */
+
+#if defined(CONFIG_BCH_FORCE_INDIRECT) || defined(CONFIG_BCH_ENCRYPTION)
+#  define BCH_DIRECT(buf)  false
+#elif CONFIG_BCH_BUFFER_ALIGNMENT != 0
+#  define BCH_DIRECT(buf) \
+     (((uintptr_t)(buf) & (CONFIG_BCH_BUFFER_ALIGNMENT - 1)) == 0)
+#else
+#  define BCH_DIRECT(buf)  true
+#endif
+
 /****************************************************************************
  * Public Types
  ****************************************************************************/
@@ -85,6 +100,7 @@ EXTERN const struct file_operations g_bch_fops;
 
 EXTERN int  bchlib_flushsector(FAR struct bchlib_s *bch, bool discard);
 EXTERN int  bchlib_readsector(FAR struct bchlib_s *bch, size_t sector);
+EXTERN int  bchlib_setsector(FAR struct bchlib_s *bch, size_t sector);
 
 #undef EXTERN
 #if defined(__cplusplus)
@@ -42,6 +42,7 @@
 #include <nuttx/fs/fs.h>
 #include <nuttx/fs/ioctl.h>
 #include <nuttx/drivers/drivers.h>
+#include <nuttx/kmalloc.h>
 
 #include "bch.h"
 
@@ -49,6 +50,21 @@
  * Pre-processor Definitions
  ****************************************************************************/
 
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+#ifdef CONFIG_FS_AIORING
+/* A byte transfer forwarded to the block driver in sectors */
+
+struct bch_aio_s
+{
+  struct fs_aio_s ba_lower;         /* Must be first: the sector request */
+  FAR struct fs_aio_s *ba_upper;    /* The byte request of the caller */
+  uint32_t ba_sectsize;             /* Converts sectors back to bytes */
+};
+#endif
+
 /****************************************************************************
  * Private Function Prototypes
  ****************************************************************************/
@@ -67,6 +83,9 @@ static int     bch_poll(FAR struct file *filep, FAR struct pollfd *fds,
 #ifndef CONFIG_DISABLE_PSEUDOFS_OPERATIONS
 static int     bch_unlink(FAR struct inode *inode);
 #endif
+#ifdef CONFIG_FS_AIORING
+static int     bch_submit(FAR struct file *filep, FAR struct fs_aio_s *aio);
+#endif
 
 /****************************************************************************
  * Public Data
@@ -88,6 +107,9 @@ const struct file_operations g_bch_fops =
 #ifndef CONFIG_DISABLE_PSEUDOFS_OPERATIONS
   , bch_unlink /* unlink */
 #endif
+#ifdef CONFIG_FS_AIORING
+  , bch_submit /* submit */
+#endif
 };
 
 /****************************************************************************
@@ -173,6 +195,9 @@ static int bch_close(FAR struct file *filep)
   /* Flush any dirty pages remaining in the cache */
 
   bchlib_flushsector(bch, false);
+#ifdef CONFIG_FS_BLOCKCACHE
+  blockcache_flush(bch->inode);
+#endif
 
   /* Decrement the reference count (I don't use bchlib_decref() because I
    * want the entire close operation to be atomic wrt other driver
@@ -453,6 +478,14 @@ static int bch_ioctl(FAR struct file *filep, int cmd, unsigned long arg)
               break;
             }
 
+#ifdef CONFIG_FS_BLOCKCACHE
+          ret = blockcache_flush(bch->inode);
+          if (ret < 0)
+            {
+              break;
+            }
+#endif
+
           /* Go through */
         }
 
@@ -541,6 +574,118 @@ static int bch_unlink(FAR struct inode *inode)
 }
 #endif
 
+/****************************************************************************
+ * Name: bch_aiodone
+ *
+ * Description:
+ *   Complete the caller's request when the block driver is done.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_FS_AIORING
+static void bch_aiodone(FAR struct fs_aio_s *aio, ssize_t result)
+{
+  FAR struct bch_aio_s *baio = (FAR struct bch_aio_s *)aio;
+  FAR struct fs_aio_s *upper = baio->ba_upper;
+
+  if (result > 0)
+    {
+      result *= baio->ba_sectsize;
+    }
+
+  kmm_free(baio);
+  upper->fa_complete(upper, result);
+}
+
+/****************************************************************************
+ * Name: bch_submit
+ *
+ * Description:
+ *   Hand a transfer of whole sectors straight to the submit method of the
+ *   block driver.  Anything the sector buffer would be needed for is left
+ *   to the synchronous path.
+ *
+ ****************************************************************************/
+
+static int bch_submit(FAR struct file *filep, FAR struct fs_aio_s *aio)
+{
+  FAR struct inode *inode = filep->f_inode;
+  FAR struct bchlib_s *bch;
+  FAR struct bch_aio_s *baio;
+  int ret;
+
+  DEBUGASSERT(inode->i_private);
+  bch = inode->i_private;
+
+  if (bch->inode->u.i_bops->submit == NULL || aio->fa_offset < 0 ||
+      aio->fa_nbytes == 0 || aio->fa_offset % bch->sectsize != 0 ||
+      aio->fa_nbytes % bch->sectsize != 0 || !BCH_DIRECT(aio->fa_buffer))
+    {
+      return -ENOSYS;
+    }
+
+  if (aio->fa_opcode == FS_AIO_WRITE && bch->readonly)
+    {
+      return -EACCES;
+    }
+
+  baio = kmm_malloc(sizeof(struct bch_aio_s));
+  if (baio == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  baio->ba_lower.fa_opcode   = aio->fa_opcode;
+  baio->ba_lower.fa_buffer   = aio->fa_buffer;
+  baio->ba_lower.fa_nbytes   = aio->fa_nbytes / bch->sectsize;
+  baio->ba_lower.fa_offset   = aio->fa_offset / bch->sectsize;
+  baio->ba_lower.fa_complete = bch_aiodone;
+  baio->ba_upper             = aio;
+  baio->ba_sectsize          = bch->sectsize;
+
+  ret = nxmutex_lock(&bch->lock);
+  if (ret < 0)
+    {
+      kmm_free(baio);
+      return ret;
+    }
+
+  /* The transfer bypasses the sector buffer and the block cache, so write
+   * back whatever they hold and drop it.  A read only needs the write back.
+   */
+
+  ret = bchlib_flushsector(bch, true);
+#ifdef CONFIG_FS_BLOCKCACHE
+  if (ret >= 0 && aio->fa_opcode == FS_AIO_READ)
+    {
+      ret = blockcache_flush(bch->inode);
+    }
+  else if (ret >= 0)
+    {
+      ret = blockcache_invalidate(bch->inode);
+    }
+#endif
+
+  nxmutex_unlock(&bch->lock);
+
+  /* Not under the lock: the completion may drop the last reference to the
+   * file and so close it.
+   */
+
+  if (ret >= 0)
+    {
+      ret = bch->inode->u.i_bops->submit(bch->inode, &baio->ba_lower);
+    }
+
+  if (ret < 0)
+    {
+      kmm_free(baio);
+    }
+
+  return ret;
+}
+#endif
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
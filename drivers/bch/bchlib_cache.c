@@ -91,6 +91,29 @@ static int bch_cypher(FAR struct bchlib_s *bch, int encrypt)
 }
 #endif
 
+/****************************************************************************
+ * Name: bchlib_allocbuffer
+ ****************************************************************************/
+
+static int bchlib_allocbuffer(FAR struct bchlib_s *bch)
+{
+  if (bch->buffer == NULL)
+    {
+#if CONFIG_BCH_BUFFER_ALIGNMENT != 0
+      bch->buffer = kmm_memalign(CONFIG_BCH_BUFFER_ALIGNMENT, bch->sectsize);
+#else
+      bch->buffer = kmm_malloc(bch->sectsize);
+#endif
+      if (bch->buffer == NULL)
+        {
+          ferr("Failed to allocate sector buffer\n");
+          return -ENOMEM;
+        }
+    }
+
+  return OK;
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -127,7 +150,8 @@ int bchlib_flushsector(FAR struct bchlib_s *bch, bool discard)
 
       /* Write the sector to the media */
 
-      ret = inode->u.i_bops->write(inode, bch->buffer, bch->sector, 1);
+      ret = blockcache_write(inode, bch->buffer, bch->sector, 1,
+                             bch->sectsize);
       if (ret < 0)
         {
           ferr("Write failed: %zd\n", ret);
@@ -169,20 +193,12 @@ int bchlib_flushsector(FAR struct bchlib_s *bch, bool discard)
 int bchlib_readsector(FAR struct bchlib_s *bch, size_t sector)
 {
   FAR struct inode *inode;
-  ssize_t ret = OK;
+  ssize_t ret;
 
-  if (bch->buffer == NULL)
+  ret = bchlib_allocbuffer(bch);
+  if (ret < 0)
     {
-#if CONFIG_BCH_BUFFER_ALIGNMENT != 0
-      bch->buffer = kmm_memalign(CONFIG_BCH_BUFFER_ALIGNMENT, bch->sectsize);
-#else
-      bch->buffer = kmm_malloc(bch->sectsize);
-#endif
-      if (bch->buffer == NULL)
-        {
-          ferr("Failed to allocate sector buffer\n");
-          return -ENOMEM;
-        }
+      return (int)ret;
     }
 
   if (bch->sector != sector)
@@ -196,7 +212,7 @@ int bchlib_readsector(FAR struct bchlib_s *bch, size_t sector)
           return (int)ret;
         }
 
-      ret = inode->u.i_bops->read(inode, bch->buffer, sector, 1);
+      ret = blockcache_read(inode, bch->buffer, sector, 1, bch->sectsize);
       if (ret < 0)
         {
           ferr("Read failed: %zd\n", ret);
@@ -211,3 +227,40 @@ int bchlib_readsector(FAR struct bchlib_s *bch, size_t sector)
 
   return (int)ret;
 }
+
+/****************************************************************************
+ * Name: bchlib_setsector
+ *
+ * Description:
+ *   Make the sector buffer hold the given sector without reading it from
+ *   the media.  For sectors that are about to be completely overwritten.
+ *
+ * Assumptions:
+ *   Caller must assume mutual exclusion
+ *
+ ****************************************************************************/
+
+int bchlib_setsector(FAR struct bchlib_s *bch, size_t sector)
+{
+  int ret;
+
+  ret = bchlib_allocbuffer(bch);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  if (bch->sector != sector)
+    {
+      ret = bchlib_flushsector(bch, true);
+      if (ret < 0)
+        {
+          ferr("Flush failed: %d\n", ret);
+          return ret;
+        }
+
+      bch->sector = sector;
+    }
+
+  return OK;
+}
@@ -137,10 +137,10 @@ ssize_t bchlib_read(FAR void *handle, FAR char *buffer, off_t offset,
     }
 
   /* Then read all of the full sectors following the partial sector directly
-   * into the user buffer.
+   * into the user buffer, when possible.
    */
 
-  if (len >= bch->sectsize)
+  if (len >= bch->sectsize && BCH_DIRECT(buffer))
     {
       nsectors = len / bch->sectsize;
       if (sector + nsectors > bch->nsectors)
@@ -148,14 +148,23 @@ ssize_t bchlib_read(FAR void *handle, FAR char *buffer, off_t offset,
           nsectors = bch->nsectors - sector;
         }
 
-      ret = bch->inode->u.i_bops->read(bch->inode, (FAR uint8_t *)buffer,
-                                       sector, nsectors);
+      ret = blockcache_read(bch->inode, (FAR uint8_t *)buffer, sector,
+                            nsectors, bch->sectsize);
       if (ret < 0)
         {
           ferr("ERROR: Read failed: %d\n", ret);
           return ret;
         }
 
+      /* The media is stale if the buffered sector is dirty */
+
+      if (bch->dirty && sector <= bch->sector &&
+          bch->sector < sector + nsectors)
+        {
+          memcpy(buffer + (bch->sector - sector) * bch->sectsize,
+                 bch->buffer, bch->sectsize);
+        }
+
       /* Adjust pointers and counts */
 
       sector    += nsectors;
@@ -171,6 +180,32 @@ ssize_t bchlib_read(FAR void *handle, FAR char *buffer, off_t offset,
       len       -= nbytes;
     }
 
+  /* Otherwise, indirectly by using the sector buffer */
+
+  while (len >= bch->sectsize)
+    {
+      ret = bchlib_readsector(bch, sector);
+      if (ret < 0)
+        {
+          return ret;
+        }
+
+      memcpy(buffer, bch->buffer, bch->sectsize);
+
+      /* Adjust pointers and counts */
+
+      sector++;
+      bytesread += bch->sectsize;
+
+      if (sector >= bch->nsectors)
+        {
+          return bytesread;
+        }
+
+      buffer    += bch->sectsize;
+      len       -= bch->sectsize;
+    }
+
   /* Then read any partial final sector */
 
   if (len > 0)
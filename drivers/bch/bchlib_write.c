@@ -56,9 +56,7 @@ ssize_t bchlib_write(FAR void *handle, FAR const char *buffer, off_t offset,
         size_t len)
 {
   FAR struct bchlib_s *bch = (FAR struct bchlib_s *)handle;
-#ifndef CONFIG_BCH_FORCE_INDIRECT
   size_t   nsectors;
-#endif
   size_t   sector;
   uint16_t sectoffset;
   size_t   nbytes;
@@ -123,91 +121,98 @@ ssize_t bchlib_write(FAR void *handle, FAR const char *buffer, off_t offset,
       len          -= nbytes;
     }
 
-  /* Then write all of the full sectors following the partial sector.. */
-
-#ifdef CONFIG_BCH_FORCE_INDIRECT
-
-  /* indirectly by using sector buffer.
+  /* Then write all of the full sectors following the partial sector
+   * directly from the user buffer, when possible.
    */
 
-  while (len > 0)
+  if (len >= bch->sectsize && BCH_DIRECT(buffer))
     {
-      /* Read the sector into the sector buffer */
-
-      ret = bchlib_readsector(bch, sector);
-      if (ret < 0)
+      nsectors = len / bch->sectsize;
+      if (sector + nsectors > bch->nsectors)
         {
-          return ret;
+          nsectors = bch->nsectors - sector;
         }
 
-      /* Copy the data from the user buffer to the sector buffer */
+      if (sector <= bch->sector && bch->sector < sector + nsectors)
+        {
+          /* The buffered sector is about to be overwritten, drop it */
 
-      nbytes = len > bch->sectsize ? bch->sectsize : len;
-      memcpy(bch->buffer, buffer, nbytes);
-      bch->dirty = true;
+          bch->dirty  = false;
+          bch->sector = (size_t)-1;
+        }
+      else
+        {
+          /* Flush the dirty sector to keep the sector sequence */
+
+          ret = bchlib_flushsector(bch, false);
+          if (ret < 0)
+            {
+              ferr("ERROR: Flush failed: %d\n", ret);
+              return ret;
+            }
+        }
 
-      /* Write the sector back to the block device */
+      /* Write the contiguous sectors */
 
-      ret = bchlib_flushsector(bch, false);
+      ret = blockcache_write(bch->inode, (FAR uint8_t *)buffer, sector,
+                             nsectors, bch->sectsize);
       if (ret < 0)
         {
-          ferr("ERROR: Flush failed: %d\n", ret);
+          ferr("ERROR: Write failed: %d\n", ret);
           return ret;
         }
 
       /* Adjust pointers and counts */
 
-      buffer       += nbytes;
-      len          -= nbytes;
+      sector       += nsectors;
+      nbytes        = nsectors * bch->sectsize;
       byteswritten += nbytes;
-      sector++;
-    }
-#else
 
-  /* directly from the user buffer.
-   */
-
-  if (len >= bch->sectsize)
-    {
-      nsectors = len / bch->sectsize;
-      if (sector + nsectors > bch->nsectors)
+      if (sector >= bch->nsectors)
         {
-          nsectors = bch->nsectors - sector;
+          return byteswritten;
         }
 
-      /* Flush the dirty sector to keep the sector sequence */
+      buffer    += nbytes;
+      len       -= nbytes;
+    }
 
-      ret = bchlib_flushsector(bch, sector <= bch->sector &&
-                               bch->sector < (sector + nsectors));
+  /* Otherwise, indirectly by using the sector buffer.  Whole sectors are
+   * not read from the media before they are overwritten.
+   */
+
+  while (len >= bch->sectsize)
+    {
+      ret = bchlib_setsector(bch, sector);
       if (ret < 0)
         {
-          ferr("ERROR: Flush failed: %d\n", ret);
           return ret;
         }
 
-      /* Write the contiguous sectors */
+      memcpy(bch->buffer, buffer, bch->sectsize);
+      bch->dirty = true;
+
+      /* Write the sector back to the block device */
 
-      ret = bch->inode->u.i_bops->write(bch->inode, (FAR uint8_t *)buffer,
-                                        sector, nsectors);
+      ret = bchlib_flushsector(bch, false);
       if (ret < 0)
         {
-          ferr("ERROR: Write failed: %d\n", ret);
+          ferr("ERROR: Flush failed: %d\n", ret);
           return ret;
         }
 
       /* Adjust pointers and counts */
 
-      sector       += nsectors;
-      nbytes        = nsectors * bch->sectsize;
-      byteswritten += nbytes;
+      sector++;
+      byteswritten += bch->sectsize;
 
       if (sector >= bch->nsectors)
         {
           return byteswritten;
         }
 
-      buffer    += nbytes;
-      len       -= nbytes;
+      buffer       += bch->sectsize;
+      len          -= bch->sectsize;
     }
 
   /* Then write any partial final sector */
@@ -231,7 +236,6 @@ ssize_t bchlib_write(FAR void *handle, FAR const char *buffer, off_t offset,
 
       byteswritten += len;
     }
-#endif /* CONFIG_BCH_FORCE_INDIRECT */
 
   return byteswritten;
 }
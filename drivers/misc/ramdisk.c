@@ -99,6 +99,9 @@ static int     rd_ioctl(FAR struct inode *inode, int cmd,
 #ifndef CONFIG_DISABLE_PSEUDOFS_OPERATIONS
 static int     rd_unlink(FAR struct inode *inode);
 #endif
+#ifdef CONFIG_FS_AIORING
+static int     rd_submit(FAR struct inode *inode, FAR struct fs_aio_s *aio);
+#endif
 
 /****************************************************************************
  * Private Data
@@ -120,6 +123,9 @@ static const struct block_operations g_bops =
 #ifndef CONFIG_DISABLE_PSEUDOFS_OPERATIONS
   , rd_unlink  /* unlink   */
 #endif
+#ifdef CONFIG_FS_AIORING
+  , rd_submit  /* submit   */
+#endif
 };
 
 /****************************************************************************
@@ -396,6 +402,40 @@ static int rd_unlink(FAR struct inode *inode)
 }
 #endif
 
+/****************************************************************************
+ * Name: rd_submit
+ *
+ * Description:
+ *   Start an asynchronous transfer.  A RAM disk transfer is a memory copy
+ *   that never sleeps, so it is done and completed before returning.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_FS_AIORING
+static int rd_submit(FAR struct inode *inode, FAR struct fs_aio_s *aio)
+{
+  ssize_t ret;
+
+  if (aio->fa_offset < 0)
+    {
+      return -ENOSYS;
+    }
+
+  if (aio->fa_opcode == FS_AIO_READ)
+    {
+      ret = rd_read(inode, aio->fa_buffer, aio->fa_offset, aio->fa_nbytes);
+    }
+  else
+    {
+      ret = rd_write(inode, aio->fa_buffer, aio->fa_offset,
+                     aio->fa_nbytes);
+    }
+
+  aio->fa_complete(aio, ret);
+  return OK;
+}
+#endif
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
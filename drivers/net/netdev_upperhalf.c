@@ -738,6 +738,28 @@ static int netdev_upper_loop(int argc, FAR char *argv[])
 }
 #endif
 
+/****************************************************************************
+ * Name: netdev_upper_post_work
+ *
+ * Description:
+ *   Wake up the work thread serving the given CPU.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NETDEV_WORK_THREAD
+static void netdev_upper_post_work(FAR struct netdev_upperhalf_s *upper,
+                                   int cpu)
+{
+  int semcount;
+
+  if (nxsem_get_value(&upper->sem[cpu], &semcount) == OK &&
+      semcount <= 0)
+    {
+      nxsem_post(&upper->sem[cpu]);
+    }
+}
+#endif
+
 /****************************************************************************
  * Name: netdev_upper_queue_work
  *
@@ -755,17 +777,10 @@ static inline void netdev_upper_queue_work(FAR struct net_driver_s *dev)
 
 #ifdef CONFIG_NETDEV_WORK_THREAD
 #  ifdef CONFIG_NETDEV_RSS
-  int cpu = this_cpu();
+  netdev_upper_post_work(upper, this_cpu());
 #  else
-  const int cpu = 0;
+  netdev_upper_post_work(upper, 0);
 #  endif
-  int semcount;
-
-  if (nxsem_get_value(&upper->sem[cpu], &semcount) == OK &&
-      semcount <= 0)
-    {
-      nxsem_post(&upper->sem[cpu]);
-    }
 #else
   if (work_available(&upper->work))
     {
@@ -1350,6 +1365,28 @@ void netdev_lower_rxready(FAR struct netdev_lowerhalf_s *dev)
 #endif
 }
 
+/****************************************************************************
+ * Name: netdev_lower_rxready_cpu
+ *
+ * Description:
+ *   Notifies the networking layer that an RX packet is ready to read on a
+ *   receive queue that is served by the work thread of the given CPU.
+ *
+ * Input Parameters:
+ *   dev - The lower half device driver structure
+ *   cpu - The CPU whose work thread should receive the packet
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NETDEV_RSS
+void netdev_lower_rxready_cpu(FAR struct netdev_lowerhalf_s *dev, int cpu)
+{
+#if CONFIG_NETDEV_WORK_THREAD_POLLING_PERIOD == 0
+  netdev_upper_post_work(dev->netdev.d_private, cpu);
+#endif
+}
+#endif
+
 /****************************************************************************
  * Name: netdev_lower_txdone
  *
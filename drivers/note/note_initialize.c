@@ -30,6 +30,7 @@
 #include <nuttx/note/note_driver.h>
 #include <nuttx/note/noteram_driver.h>
 #include <nuttx/note/notectl_driver.h>
+#include <nuttx/note/noteperfetto_driver.h>
 #include <nuttx/note/notesnap_driver.h>
 #include <nuttx/note/notestream_driver.h>
 #include <nuttx/segger/note_rtt.h>
@@ -167,6 +168,15 @@ int note_initialize(void)
     }
 #endif
 
+#ifdef CONFIG_DRIVERS_NOTEPERFETTO
+  ret = noteperfetto_register(CONFIG_DRIVERS_NOTEPERFETTO_PATH);
+  if (ret < 0)
+    {
+      serr("noteperfetto_register failed %d\n", ret);
+      return ret;
+    }
+#endif
+
 #ifdef CONFIG_NOTE_RTT
   ret = notertt_register();
   if (ret < 0)
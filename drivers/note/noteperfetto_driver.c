@@ -0,0 +1,987 @@
+/****************************************************************************
+ * drivers/note/noteperfetto_driver.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <errno.h>
+
+#include <nuttx/clock.h>
+#include <nuttx/kmalloc.h>
+#include <nuttx/spinlock.h>
+#include <nuttx/streams.h>
+#include <nuttx/wqueue.h>
+#include <nuttx/note/note_driver.h>
+#include <nuttx/note/noteperfetto_driver.h>
+
+#ifdef CONFIG_SCHED_INSTRUMENTATION_SYSCALL
+#  ifdef CONFIG_LIB_SYSCALL
+#    include <syscall.h>
+#  else
+#    define CONFIG_LIB_SYSCALL
+#    include <syscall.h>
+#    undef CONFIG_LIB_SYSCALL
+#  endif
+#endif
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Largest packet: a note is at most 255 bytes, plus the packet framing */
+
+#define NOTEPERFETTO_PACKET_MAX       384
+
+/* Room kept after a string field for the fields that follow it */
+
+#define NOTEPERFETTO_PACKET_SLACK     32
+
+#define NOTEPERFETTO_STRING_END(drv)  ((drv)->packet + \
+                                       NOTEPERFETTO_PACKET_MAX - \
+                                       NOTEPERFETTO_PACKET_SLACK)
+
+#define NOTEPERFETTO_WORK_DELAY \
+  MSEC2TICK(CONFIG_DRIVERS_NOTEPERFETTO_WORK_DELAY)
+
+/* Room for a task name, or for a formatted pointer or IRQ name */
+
+#define NOTEPERFETTO_NAME_MAX         (CONFIG_TASK_NAME_SIZE + 24)
+
+/* Protobuf wire types */
+
+#define PB_VARINT                     0
+#define PB_LENGTH                     2
+
+/* Field numbers from perfetto/trace/trace.proto and trace_packet.proto */
+
+#define TRACE_PACKET                  1
+
+#define PACKET_TIMESTAMP              8
+#define PACKET_SEQUENCE_ID            10
+#define PACKET_TRACK_EVENT            11
+#define PACKET_INTERNED_DATA          12
+#define PACKET_SEQUENCE_FLAGS         13
+#define PACKET_TRACK_DESCRIPTOR       60
+
+#define SEQ_INCREMENTAL_STATE_CLEARED 1
+#define SEQ_NEEDS_INCREMENTAL_STATE   2
+
+#define TRACK_UUID                    1
+#define TRACK_NAME                    2
+#define TRACK_THREAD                  4
+#define TRACK_COUNTER                 8
+
+#define THREAD_PID                    1
+#define THREAD_TID                    2
+#define THREAD_NAME                   5
+
+#define EVENT_TYPE                    9
+#define EVENT_NAME_IID                10
+#define EVENT_TRACK_UUID              11
+#define EVENT_NAME                    23
+#define EVENT_COUNTER_VALUE           30
+
+#define EVENT_TYPE_SLICE_BEGIN        1
+#define EVENT_TYPE_SLICE_END          2
+#define EVENT_TYPE_INSTANT            3
+#define EVENT_TYPE_COUNTER            4
+
+#define INTERNED_EVENT_NAMES          2
+#define EVENT_NAME_ENTRY_IID          1
+#define EVENT_NAME_ENTRY_NAME         2
+
+/* The one packet sequence this driver writes */
+
+#define NOTEPERFETTO_SEQUENCE_ID      1
+
+/* Track UUIDs: one track per CPU, per thread and per counter name */
+
+#define NOTEPERFETTO_CPU_TRACK(cpu)   ((uint64_t)(cpu) + 1)
+#define NOTEPERFETTO_THREAD_TRACK(pid) (0x100 + (uint64_t)(pid))
+#define NOTEPERFETTO_COUNTER_TRACK(h) (0x1000000 + (uint64_t)(h))
+
+/* Interned event name IDs */
+
+#define NOTEPERFETTO_TASK_IID(pid)    ((uint32_t)(pid) + 1)
+#define NOTEPERFETTO_IRQ_IID(irq)     (0x100000 + (uint32_t)(irq))
+#define NOTEPERFETTO_SYSCALL_IID(nr)  (0x200000 + (uint32_t)(nr))
+
+/* Keys of the cache remembering what has already been written */
+
+#define NOTEPERFETTO_KEY_TASK         1
+#define NOTEPERFETTO_KEY_IRQ          2
+#define NOTEPERFETTO_KEY_SYSCALL      3
+#define NOTEPERFETTO_KEY_CPU          4
+#define NOTEPERFETTO_KEY_THREAD       5
+#define NOTEPERFETTO_KEY_COUNTER      6
+
+#define NOTEPERFETTO_KEY(kind, id)    (((uint32_t)(kind) << 24) | \
+                                       ((uint32_t)(id) & 0xffffff))
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+struct noteperfetto_driver_s
+{
+  struct note_driver_s driver;
+  struct lib_fileoutstream_s filestream;
+  struct work_s work;                          /* Writes the buffer out */
+  spinlock_t lock;
+  bool started;                                /* First packet written */
+  size_t head;                                 /* Next byte to be filled */
+  size_t tail;                                 /* Next byte to be written */
+  uint32_t interned[CONFIG_DRIVERS_NOTEPERFETTO_NINTERNED];
+  uint8_t packet[NOTEPERFETTO_PACKET_MAX];
+#if defined(CONFIG_SCHED_INSTRUMENTATION_DUMP) && \
+    !defined(CONFIG_DRIVERS_NOTE_STRIP_FORMAT)
+  char text[NOTEPERFETTO_PACKET_MAX];          /* Formatted printf note */
+#endif
+  uint8_t buffer[CONFIG_DRIVERS_NOTEPERFETTO_BUFSIZE];
+};
+
+/****************************************************************************
+ * Private Function Prototypes
+ ****************************************************************************/
+
+static void noteperfetto_add(FAR struct note_driver_s *driver,
+                             FAR const void *note, size_t notelen);
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static const struct note_driver_ops_s g_noteperfetto_ops =
+{
+  noteperfetto_add
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: pb_varint
+ ****************************************************************************/
+
+static FAR uint8_t *pb_varint(FAR uint8_t *p, uint64_t value)
+{
+  while (value >= 0x80)
+    {
+      *p++ = (uint8_t)value | 0x80;
+      value >>= 7;
+    }
+
+  *p++ = (uint8_t)value;
+  return p;
+}
+
+/****************************************************************************
+ * Name: pb_uint
+ ****************************************************************************/
+
+static FAR uint8_t *pb_uint(FAR uint8_t *p, uint32_t field, uint64_t value)
+{
+  p = pb_varint(p, (field << 3) | PB_VARINT);
+  return pb_varint(p, value);
+}
+
+/****************************************************************************
+ * Name: pb_string
+ *
+ * Description:
+ *   Write a string field.  The string is truncated to what fits before
+ *   end, along with its tag and a length of up to two bytes.
+ *
+ ****************************************************************************/
+
+static FAR uint8_t *pb_string(FAR uint8_t *p, FAR const uint8_t *end,
+                              uint32_t field, FAR const char *str,
+                              size_t len)
+{
+  size_t room = end - p > 4 ? end - p - 4 : 0;
+
+  if (len > room)
+    {
+      len = room;
+    }
+
+  p = pb_varint(p, (field << 3) | PB_LENGTH);
+  p = pb_varint(p, len);
+  memcpy(p, str, len);
+  return p + len;
+}
+
+/****************************************************************************
+ * Name: pb_begin
+ *
+ * Description:
+ *   Start a nested message.  Two bytes are reserved for its length, which
+ *   is filled in by pb_end() once the message is complete.
+ *
+ ****************************************************************************/
+
+static FAR uint8_t *pb_begin(FAR uint8_t *p, uint32_t field,
+                             FAR uint8_t **msg)
+{
+  p = pb_varint(p, (field << 3) | PB_LENGTH);
+  *msg = p;
+  return p + 2;
+}
+
+/****************************************************************************
+ * Name: pb_end
+ *
+ * Description:
+ *   Complete a nested message started by pb_begin().  Short messages have
+ *   their body moved down so that the length takes a single byte.
+ *
+ ****************************************************************************/
+
+static FAR uint8_t *pb_end(FAR uint8_t *p, FAR uint8_t *msg)
+{
+  size_t len = p - msg - 2;
+
+  if (len < 0x80)
+    {
+      msg[0] = (uint8_t)len;
+      memmove(msg + 1, msg + 2, len);
+      return p - 1;
+    }
+
+  DEBUGASSERT(len < 0x4000);
+  msg[0] = (uint8_t)len | 0x80;
+  msg[1] = (uint8_t)(len >> 7);
+  return p;
+}
+
+/****************************************************************************
+ * Name: noteperfetto_slot
+ ****************************************************************************/
+
+static inline FAR uint32_t *
+noteperfetto_slot(FAR struct noteperfetto_driver_s *drv, uint32_t key)
+{
+  return &drv->interned[(key ^ (key >> 24)) %
+                        CONFIG_DRIVERS_NOTEPERFETTO_NINTERNED];
+}
+
+/****************************************************************************
+ * Name: noteperfetto_interned
+ *
+ * Description:
+ *   Return true if the descriptor or name identified by key has already
+ *   been written, and remember it otherwise.  The cache is direct mapped,
+ *   so an evicted entry is simply written again.
+ *
+ ****************************************************************************/
+
+static bool noteperfetto_interned(FAR struct noteperfetto_driver_s *drv,
+                                  uint32_t key)
+{
+  FAR uint32_t *slot = noteperfetto_slot(drv, key);
+
+  if (*slot == key)
+    {
+      return true;
+    }
+
+  *slot = key;
+  return false;
+}
+
+/****************************************************************************
+ * Name: noteperfetto_forget
+ ****************************************************************************/
+
+static void noteperfetto_forget(FAR struct noteperfetto_driver_s *drv,
+                                uint32_t key)
+{
+  FAR uint32_t *slot = noteperfetto_slot(drv, key);
+
+  if (*slot == key)
+    {
+      *slot = 0;
+    }
+}
+
+/****************************************************************************
+ * Name: noteperfetto_open
+ *
+ * Description:
+ *   Start a TracePacket in the packet buffer.  The first packet of the
+ *   stream also resets the interning state of the reader.
+ *
+ ****************************************************************************/
+
+static FAR uint8_t *noteperfetto_open(FAR struct noteperfetto_driver_s *drv,
+                                      uint64_t timestamp, FAR uint8_t **msg)
+{
+  FAR uint8_t *p = drv->packet;
+
+  p = pb_begin(p, TRACE_PACKET, msg);
+  p = pb_uint(p, PACKET_TIMESTAMP, timestamp);
+  p = pb_uint(p, PACKET_SEQUENCE_ID, NOTEPERFETTO_SEQUENCE_ID);
+  if (!drv->started)
+    {
+      drv->started = true;
+      p = pb_uint(p, PACKET_SEQUENCE_FLAGS, SEQ_INCREMENTAL_STATE_CLEARED);
+    }
+  else
+    {
+      p = pb_uint(p, PACKET_SEQUENCE_FLAGS, SEQ_NEEDS_INCREMENTAL_STATE);
+    }
+
+  return p;
+}
+
+/****************************************************************************
+ * Name: noteperfetto_close
+ *
+ * Description:
+ *   Complete the TracePacket and append it to the buffer, from which the
+ *   work queue writes it out.  If there is no room the packet is dropped
+ *   and the interning state starts over, since later packets may refer to
+ *   what it carried.
+ *
+ ****************************************************************************/
+
+static void noteperfetto_close(FAR struct noteperfetto_driver_s *drv,
+                               FAR uint8_t *p, FAR uint8_t *msg)
+{
+  size_t used;
+  size_t len;
+  size_t n;
+
+  p    = pb_end(p, msg);
+  len  = p - drv->packet;
+  used = drv->head >= drv->tail ? drv->head - drv->tail :
+         drv->head + CONFIG_DRIVERS_NOTEPERFETTO_BUFSIZE - drv->tail;
+
+  if (len >= CONFIG_DRIVERS_NOTEPERFETTO_BUFSIZE - used)
+    {
+      memset(drv->interned, 0, sizeof(drv->interned));
+      drv->started = false;
+      return;
+    }
+
+  n = CONFIG_DRIVERS_NOTEPERFETTO_BUFSIZE - drv->head;
+  n = n < len ? n : len;
+
+  memcpy(drv->buffer + drv->head, drv->packet, n);
+  memcpy(drv->buffer, drv->packet + n, len - n);
+
+  drv->head += len;
+  if (drv->head >= CONFIG_DRIVERS_NOTEPERFETTO_BUFSIZE)
+    {
+      drv->head -= CONFIG_DRIVERS_NOTEPERFETTO_BUFSIZE;
+    }
+}
+
+/****************************************************************************
+ * Name: noteperfetto_work
+ *
+ * Description:
+ *   Write the buffered packets out, without holding the driver lock.  Only
+ *   what is buffered on entry is written: writing may block and generate
+ *   notes of its own, which are left to the next run.
+ *
+ *   The work runs periodically rather than being queued by
+ *   noteperfetto_add(), which is called from the context switch path
+ *   where work_queue() must not be called.
+ *
+ ****************************************************************************/
+
+static void noteperfetto_work(FAR void *arg)
+{
+  FAR struct noteperfetto_driver_s *drv = arg;
+  irqstate_t flags;
+  size_t head;
+  size_t tail;
+  size_t len;
+
+  flags = spin_lock_irqsave_notrace(&drv->lock);
+  head  = drv->head;
+  tail  = drv->tail;
+  spin_unlock_irqrestore_notrace(&drv->lock, flags);
+
+  while (tail != head)
+    {
+      len = head > tail ? head - tail :
+            CONFIG_DRIVERS_NOTEPERFETTO_BUFSIZE - tail;
+
+      lib_stream_puts(&drv->filestream.common, drv->buffer + tail, len);
+
+      tail += len;
+      if (tail >= CONFIG_DRIVERS_NOTEPERFETTO_BUFSIZE)
+        {
+          tail = 0;
+        }
+
+      flags = spin_lock_irqsave_notrace(&drv->lock);
+      drv->tail = tail;
+      spin_unlock_irqrestore_notrace(&drv->lock, flags);
+    }
+
+  work_queue(LPWORK, &drv->work, noteperfetto_work, drv,
+             NOTEPERFETTO_WORK_DELAY);
+}
+
+/****************************************************************************
+ * Name: noteperfetto_taskname
+ *
+ * Description:
+ *   Copy the name of a task to buf.  This enters a critical section, so it
+ *   must not be called with the driver lock held.
+ *
+ ****************************************************************************/
+
+static size_t noteperfetto_taskname(pid_t pid, FAR char *buf, size_t len)
+{
+#if CONFIG_DRIVERS_NOTE_TASKNAME_BUFSIZE > 0
+  FAR const char *name = note_get_taskname(pid);
+
+  if (name != NULL && name[0] != '\0')
+    {
+      strlcpy(buf, name, len);
+      return strlen(buf);
+    }
+#endif
+
+  return snprintf(buf, len, "pid %d", pid);
+}
+
+/****************************************************************************
+ * Name: noteperfetto_cpu_track
+ ****************************************************************************/
+
+static void noteperfetto_cpu_track(FAR struct noteperfetto_driver_s *drv,
+                                   uint64_t timestamp, int cpu)
+{
+  FAR uint8_t *packet;
+  FAR uint8_t *track;
+  FAR uint8_t *p;
+  char name[16];
+
+  if (noteperfetto_interned(drv,
+                            NOTEPERFETTO_KEY(NOTEPERFETTO_KEY_CPU, cpu)))
+    {
+      return;
+    }
+
+  p = noteperfetto_open(drv, timestamp, &packet);
+  p = pb_begin(p, PACKET_TRACK_DESCRIPTOR, &track);
+  p = pb_uint(p, TRACK_UUID, NOTEPERFETTO_CPU_TRACK(cpu));
+  p = pb_string(p, NOTEPERFETTO_STRING_END(drv), TRACK_NAME, name,
+                snprintf(name, sizeof(name), "CPU %d", cpu));
+  p = pb_end(p, track);
+  noteperfetto_close(drv, p, packet);
+}
+
+/****************************************************************************
+ * Name: noteperfetto_thread_track
+ ****************************************************************************/
+
+static void noteperfetto_thread_track(FAR struct noteperfetto_driver_s *drv,
+                                      uint64_t timestamp, pid_t pid,
+                                      FAR const char *name, size_t namelen)
+{
+  FAR uint8_t *packet;
+  FAR uint8_t *thread;
+  FAR uint8_t *track;
+  FAR uint8_t *p;
+
+  if (noteperfetto_interned(drv,
+                            NOTEPERFETTO_KEY(NOTEPERFETTO_KEY_THREAD, pid)))
+    {
+      return;
+    }
+
+  p = noteperfetto_open(drv, timestamp, &packet);
+  p = pb_begin(p, PACKET_TRACK_DESCRIPTOR, &track);
+  p = pb_uint(p, TRACK_UUID, NOTEPERFETTO_THREAD_TRACK(pid));
+  p = pb_begin(p, TRACK_THREAD, &thread);
+  p = pb_uint(p, THREAD_PID, pid);
+  p = pb_uint(p, THREAD_TID, pid);
+  p = pb_string(p, NOTEPERFETTO_STRING_END(drv), THREAD_NAME, name,
+                namelen);
+  p = pb_end(p, thread);
+  p = pb_end(p, track);
+  noteperfetto_close(drv, p, packet);
+}
+
+/****************************************************************************
+ * Name: noteperfetto_event
+ *
+ * Description:
+ *   Write one TrackEvent.  If key is non-zero the name is interned under
+ *   iid the first time it is seen and referenced by iid afterwards;
+ *   otherwise the name, if any, is written inline.
+ *
+ ****************************************************************************/
+
+static void noteperfetto_event(FAR struct noteperfetto_driver_s *drv,
+                               uint64_t timestamp, uint64_t track,
+                               uint8_t type, uint32_t key, uint32_t iid,
+                               FAR const char *name, size_t namelen)
+{
+  FAR uint8_t *interned;
+  FAR uint8_t *packet;
+  FAR uint8_t *event;
+  FAR uint8_t *entry;
+  FAR uint8_t *p;
+
+  p = noteperfetto_open(drv, timestamp, &packet);
+
+  if (key != 0 && !noteperfetto_interned(drv, key))
+    {
+      p = pb_begin(p, PACKET_INTERNED_DATA, &interned);
+      p = pb_begin(p, INTERNED_EVENT_NAMES, &entry);
+      p = pb_uint(p, EVENT_NAME_ENTRY_IID, iid);
+      p = pb_string(p, NOTEPERFETTO_STRING_END(drv), EVENT_NAME_ENTRY_NAME,
+                    name, namelen);
+      p = pb_end(p, entry);
+      p = pb_end(p, interned);
+    }
+
+  p = pb_begin(p, PACKET_TRACK_EVENT, &event);
+  p = pb_uint(p, EVENT_TYPE, type);
+  p = pb_uint(p, EVENT_TRACK_UUID, track);
+  if (key != 0)
+    {
+      p = pb_uint(p, EVENT_NAME_IID, iid);
+    }
+  else if (name != NULL)
+    {
+      p = pb_string(p, NOTEPERFETTO_STRING_END(drv), EVENT_NAME, name,
+                    namelen);
+    }
+
+  p = pb_end(p, event);
+  noteperfetto_close(drv, p, packet);
+}
+
+#ifdef CONFIG_SCHED_INSTRUMENTATION_DUMP
+#  ifndef CONFIG_DRIVERS_NOTE_STRIP_FORMAT
+/****************************************************************************
+ * Name: noteperfetto_printf
+ *
+ * Description:
+ *   Format a printf note into the text buffer and return its length.  A
+ *   note recorded without its format string shows the format address
+ *   followed by the arguments.
+ *
+ ****************************************************************************/
+
+static size_t noteperfetto_printf(FAR struct noteperfetto_driver_s *drv,
+                                  FAR const struct note_printf_s *npt)
+{
+  struct lib_memoutstream_s stream;
+
+  lib_memoutstream(&stream, drv->text, sizeof(drv->text));
+  if (npt->npt_type == 0)
+    {
+      lib_bsprintf(&stream.common, npt->npt_fmt, npt->npt_data);
+    }
+  else
+    {
+      size_t count = NOTE_PRINTF_GET_COUNT(npt->npt_type);
+      char fmt[64];
+      size_t i;
+
+      fmt[0] = '\0';
+      lib_sprintf(&stream.common, "%p", npt->npt_fmt);
+      for (i = 0; i < count; i++)
+        {
+          switch (NOTE_PRINTF_GET_TYPE(npt->npt_type, i))
+            {
+              case NOTE_PRINTF_UINT32:
+                strlcat(fmt, " %u", sizeof(fmt));
+                break;
+
+              case NOTE_PRINTF_UINT64:
+                strlcat(fmt, " %llu", sizeof(fmt));
+                break;
+
+              case NOTE_PRINTF_STRING:
+                strlcat(fmt, " %s", sizeof(fmt));
+                break;
+
+              case NOTE_PRINTF_DOUBLE:
+                strlcat(fmt, " %f", sizeof(fmt));
+                break;
+            }
+        }
+
+      lib_bsprintf(&stream.common, fmt, npt->npt_data);
+    }
+
+  return stream.common.nput;
+}
+#  endif
+
+/****************************************************************************
+ * Name: noteperfetto_counter
+ ****************************************************************************/
+
+static void noteperfetto_counter(FAR struct noteperfetto_driver_s *drv,
+                                 uint64_t timestamp,
+                                 FAR const struct note_counter_s *counter)
+{
+  FAR uint8_t *packet;
+  FAR uint8_t *track;
+  FAR uint8_t *event;
+  FAR uint8_t *desc;
+  FAR uint8_t *p;
+  size_t namelen = strnlen(counter->name, sizeof(counter->name));
+  uint32_t hash = 0;
+  size_t i;
+
+  for (i = 0; i < namelen; i++)
+    {
+      hash = hash * 31 + (uint8_t)counter->name[i];
+    }
+
+  hash &= 0xffffff;
+
+  if (!noteperfetto_interned(drv,
+                       NOTEPERFETTO_KEY(NOTEPERFETTO_KEY_COUNTER, hash)))
+    {
+      p = noteperfetto_open(drv, timestamp, &packet);
+      p = pb_begin(p, PACKET_TRACK_DESCRIPTOR, &track);
+      p = pb_uint(p, TRACK_UUID, NOTEPERFETTO_COUNTER_TRACK(hash));
+      p = pb_string(p, NOTEPERFETTO_STRING_END(drv), TRACK_NAME,
+                    counter->name, namelen);
+      p = pb_begin(p, TRACK_COUNTER, &desc);
+      p = pb_end(p, desc);
+      p = pb_end(p, track);
+      noteperfetto_close(drv, p, packet);
+    }
+
+  p = noteperfetto_open(drv, timestamp, &packet);
+  p = pb_begin(p, PACKET_TRACK_EVENT, &event);
+  p = pb_uint(p, EVENT_TYPE, EVENT_TYPE_COUNTER);
+  p = pb_uint(p, EVENT_TRACK_UUID, NOTEPERFETTO_COUNTER_TRACK(hash));
+  p = pb_uint(p, EVENT_COUNTER_VALUE, (uint64_t)(int64_t)counter->value);
+  p = pb_end(p, event);
+  noteperfetto_close(drv, p, packet);
+}
+#endif
+
+/****************************************************************************
+ * Name: noteperfetto_add
+ *
+ * Description:
+ *   Translate one note into Perfetto TracePackets and buffer them for the
+ *   periodic work to write out.  No I/O is done here, since that would
+ *   block and generate notes with the driver lock held, and no work is
+ *   queued, since this runs in the context switch path.  Notes without a
+ *   Perfetto equivalent are dropped.
+ *
+ ****************************************************************************/
+
+static void noteperfetto_add(FAR struct note_driver_s *driver,
+                             FAR const void *note, size_t notelen)
+{
+  FAR struct noteperfetto_driver_s *drv =
+    (FAR struct noteperfetto_driver_s *)driver;
+  FAR const struct note_common_s *nc = note;
+  char taskname[NOTEPERFETTO_NAME_MAX];
+#if defined(CONFIG_SCHED_INSTRUMENTATION_IRQHANDLER) || \
+    defined(CONFIG_SCHED_INSTRUMENTATION_DUMP)
+  char name[NOTEPERFETTO_NAME_MAX];
+#endif
+  size_t tasklen = 0;
+  struct timespec ts;
+  uint64_t timestamp;
+  irqstate_t flags;
+  pid_t pid = nc->nc_pid;
+#ifdef CONFIG_SMP
+  int cpu = nc->nc_cpu;
+#else
+  int cpu = 0;
+#endif
+
+  perf_convert(nc->nc_systime, &ts);
+  timestamp = (uint64_t)ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+
+  /* Look the task name up before taking the lock, and only when it has
+   * not been written yet.  If the entry is evicted in between, the PID is
+   * used as the name instead.
+   */
+
+  if (nc->nc_type != NOTE_START && nc->nc_type != NOTE_STOP &&
+      nc->nc_type != NOTE_IRQ_ENTER && nc->nc_type != NOTE_IRQ_LEAVE &&
+      (*noteperfetto_slot(drv, NOTEPERFETTO_KEY(NOTEPERFETTO_KEY_TASK,
+                                                pid)) !=
+       NOTEPERFETTO_KEY(NOTEPERFETTO_KEY_TASK, pid) ||
+       *noteperfetto_slot(drv, NOTEPERFETTO_KEY(NOTEPERFETTO_KEY_THREAD,
+                                                pid)) !=
+       NOTEPERFETTO_KEY(NOTEPERFETTO_KEY_THREAD, pid)))
+    {
+      tasklen = noteperfetto_taskname(pid, taskname, sizeof(taskname));
+    }
+
+  flags = spin_lock_irqsave_notrace(&drv->lock);
+
+  if (tasklen == 0)
+    {
+      tasklen = snprintf(taskname, sizeof(taskname), "pid %d", pid);
+    }
+
+  switch (nc->nc_type)
+    {
+      case NOTE_START:
+
+        /* The PID may be reused by a task with another name */
+
+        noteperfetto_forget(drv,
+                            NOTEPERFETTO_KEY(NOTEPERFETTO_KEY_TASK, pid));
+        noteperfetto_forget(drv,
+                            NOTEPERFETTO_KEY(NOTEPERFETTO_KEY_THREAD, pid));
+        break;
+
+#ifdef CONFIG_SCHED_INSTRUMENTATION_SWITCH
+      case NOTE_RESUME:
+        noteperfetto_cpu_track(drv, timestamp, cpu);
+        noteperfetto_event(drv, timestamp, NOTEPERFETTO_CPU_TRACK(cpu),
+                           EVENT_TYPE_SLICE_BEGIN,
+                           NOTEPERFETTO_KEY(NOTEPERFETTO_KEY_TASK, pid),
+                           NOTEPERFETTO_TASK_IID(pid), taskname, tasklen);
+        break;
+
+      case NOTE_SUSPEND:
+#endif
+      case NOTE_STOP:
+        noteperfetto_cpu_track(drv, timestamp, cpu);
+        noteperfetto_event(drv, timestamp, NOTEPERFETTO_CPU_TRACK(cpu),
+                           EVENT_TYPE_SLICE_END, 0, 0, NULL, 0);
+        break;
+
+#ifdef CONFIG_SCHED_INSTRUMENTATION_IRQHANDLER
+      case NOTE_IRQ_ENTER:
+        {
+          FAR const struct note_irqhandler_s *nih = note;
+
+          noteperfetto_cpu_track(drv, timestamp, cpu);
+          noteperfetto_event(drv, timestamp, NOTEPERFETTO_CPU_TRACK(cpu),
+                             EVENT_TYPE_SLICE_BEGIN,
+                             NOTEPERFETTO_KEY(NOTEPERFETTO_KEY_IRQ,
+                                              nih->nih_irq),
+                             NOTEPERFETTO_IRQ_IID(nih->nih_irq), name,
+                             snprintf(name, sizeof(name), "irq %d",
+                                      nih->nih_irq));
+        }
+        break;
+
+      case NOTE_IRQ_LEAVE:
+        noteperfetto_cpu_track(drv, timestamp, cpu);
+        noteperfetto_event(drv, timestamp, NOTEPERFETTO_CPU_TRACK(cpu),
+                           EVENT_TYPE_SLICE_END, 0, 0, NULL, 0);
+        break;
+#endif
+
+#ifdef CONFIG_SCHED_INSTRUMENTATION_SYSCALL
+      case NOTE_SYSCALL_ENTER:
+        {
+          FAR const struct note_syscall_enter_s *nsc = note;
+          FAR const char *func;
+
+          if (nsc->nsc_nr < CONFIG_SYS_RESERVED ||
+              nsc->nsc_nr >= SYS_maxsyscall)
+            {
+              break;
+            }
+
+          func = g_funcnames[nsc->nsc_nr - CONFIG_SYS_RESERVED];
+          noteperfetto_thread_track(drv, timestamp, pid,
+                                    taskname, tasklen);
+          noteperfetto_event(drv, timestamp,
+                             NOTEPERFETTO_THREAD_TRACK(pid),
+                             EVENT_TYPE_SLICE_BEGIN,
+                             NOTEPERFETTO_KEY(NOTEPERFETTO_KEY_SYSCALL,
+                                              nsc->nsc_nr),
+                             NOTEPERFETTO_SYSCALL_IID(nsc->nsc_nr),
+                             func, strlen(func));
+        }
+        break;
+
+      case NOTE_SYSCALL_LEAVE:
+        {
+          FAR const struct note_syscall_leave_s *nsc = note;
+
+          if (nsc->nsc_nr < CONFIG_SYS_RESERVED ||
+              nsc->nsc_nr >= SYS_maxsyscall)
+            {
+              break;
+            }
+
+          noteperfetto_thread_track(drv, timestamp, pid,
+                                    taskname, tasklen);
+          noteperfetto_event(drv, timestamp,
+                             NOTEPERFETTO_THREAD_TRACK(pid),
+                             EVENT_TYPE_SLICE_END, 0, 0, NULL, 0);
+        }
+        break;
+#endif
+
+#ifdef CONFIG_SCHED_INSTRUMENTATION_DUMP
+#  ifndef CONFIG_DRIVERS_NOTE_STRIP_FORMAT
+      case NOTE_DUMP_PRINTF:
+        {
+          FAR const struct note_printf_s *npt = note;
+
+          noteperfetto_thread_track(drv, timestamp, pid,
+                                    taskname, tasklen);
+          noteperfetto_event(drv, timestamp,
+                             NOTEPERFETTO_THREAD_TRACK(pid),
+                             EVENT_TYPE_INSTANT, 0, 0, drv->text,
+                             noteperfetto_printf(drv, npt));
+        }
+        break;
+#  endif
+
+      case NOTE_DUMP_BEGIN:
+      case NOTE_DUMP_MARK:
+        {
+          FAR const struct note_event_s *nev = note;
+          FAR const char *str = (FAR const char *)nev->nev_data;
+          size_t len = nc->nc_length - SIZEOF_NOTE_EVENT(0);
+
+          if (len == 0)
+            {
+              str = name;
+              len = snprintf(name, sizeof(name), "%p",
+                             (FAR void *)nev->nev_ip);
+            }
+
+          noteperfetto_thread_track(drv, timestamp, pid,
+                                    taskname, tasklen);
+          noteperfetto_event(drv, timestamp,
+                             NOTEPERFETTO_THREAD_TRACK(pid),
+                             nc->nc_type == NOTE_DUMP_BEGIN ?
+                             EVENT_TYPE_SLICE_BEGIN : EVENT_TYPE_INSTANT,
+                             0, 0, str, strnlen(str, len));
+        }
+        break;
+
+      case NOTE_DUMP_END:
+        noteperfetto_thread_track(drv, timestamp, pid,
+                                    taskname, tasklen);
+        noteperfetto_event(drv, timestamp, NOTEPERFETTO_THREAD_TRACK(pid),
+                           EVENT_TYPE_SLICE_END, 0, 0, NULL, 0);
+        break;
+
+      case NOTE_DUMP_COUNTER:
+        {
+          FAR const struct note_event_s *nev = note;
+
+          noteperfetto_counter(drv, timestamp,
+                      (FAR const struct note_counter_s *)nev->nev_data);
+        }
+        break;
+#endif
+
+      default:
+        break;
+    }
+
+  spin_unlock_irqrestore_notrace(&drv->lock, flags);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: noteperfetto_register
+ *
+ * Description:
+ *   Register a note driver that translates the notes into a Perfetto trace
+ *   and writes it to the given file or character device.
+ *
+ * Input Parameters:
+ *   filename - The file or device the trace is written to
+ *
+ * Returned Value:
+ *   Zero on success.  A negated errno value is returned on a failure.
+ *
+ ****************************************************************************/
+
+int noteperfetto_register(FAR const char *filename)
+{
+  FAR struct noteperfetto_driver_s *drv;
+#ifdef CONFIG_SCHED_INSTRUMENTATION_FILTER
+  size_t len = strlen(filename) + 1;
+#else
+  size_t len = 0;
+#endif
+  int ret;
+
+  drv = kmm_zalloc(sizeof(struct noteperfetto_driver_s) + len);
+  if (drv == NULL)
+    {
+      return -ENOMEM;
+    }
+
+#ifdef CONFIG_SCHED_INSTRUMENTATION_FILTER
+  memcpy(drv + 1, filename, len);
+  drv->driver.name = (FAR const char *)(drv + 1);
+  drv->driver.filter.mode.flag =
+                      CONFIG_SCHED_INSTRUMENTATION_FILTER_DEFAULT_MODE;
+
+#  ifdef CONFIG_SMP
+  drv->driver.filter.mode.cpuset =
+                      CONFIG_SCHED_INSTRUMENTATION_CPUSET;
+#  endif
+
+#endif
+
+  drv->driver.ops = &g_noteperfetto_ops;
+  spin_lock_init(&drv->lock);
+  ret = lib_fileoutstream_open(&drv->filestream, filename,
+                               O_WRONLY | O_CREAT | O_TRUNC, 0666);
+  if (ret < 0)
+    {
+      kmm_free(drv);
+      return ret;
+    }
+
+  ret = note_driver_register(&drv->driver);
+  if (ret < 0)
+    {
+      lib_fileoutstream_close(&drv->filestream);
+      kmm_free(drv);
+      return ret;
+    }
+
+  return work_queue(LPWORK, &drv->work, noteperfetto_work, drv,
+                    NOTEPERFETTO_WORK_DELAY);
+}
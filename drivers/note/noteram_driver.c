@@ -76,12 +76,35 @@
  * Private Types
  ****************************************************************************/
 
+#ifdef CONFIG_DRIVERS_NOTERAM_PERCPU
+/* With per-CPU buffers each CPU owns one slice of ni_buffer.  Only the
+ * owning CPU moves head and tail, which are free running and reduced
+ * modulo the slice size, so notes are added without taking any lock.  A
+ * reader detects a note overwritten while it was being copied by checking
+ * the tail again afterwards.
+ */
+
+struct noteram_ring_s
+{
+  volatile unsigned int head;     /* Next free position, owning CPU only */
+  volatile unsigned int tail;     /* Oldest note, owning CPU only */
+  volatile unsigned int read;     /* Next unread note, reader only */
+  volatile unsigned int clearreq; /* Clear requests posted by the reader */
+  unsigned int clearack;          /* Clear requests handled by the CPU */
+  volatile bool overflow;         /* Stopped recording, buffer was full */
+  volatile unsigned int dropped;  /* Notes lost to overwrite or overflow */
+};
+#endif
+
 struct noteram_driver_s
 {
   struct note_driver_s driver;
   FAR uint8_t *ni_buffer;
   size_t ni_bufsize;
   unsigned int ni_overwrite;
+#ifdef CONFIG_DRIVERS_NOTERAM_PERCPU
+  FAR struct noteram_ring_s *ni_ring;
+#endif
   volatile unsigned int ni_head;
   volatile unsigned int ni_tail;
   volatile unsigned int ni_read;
@@ -149,6 +172,10 @@ locate_data(DRIVERS_NOTERAM_SECTION)
 #endif
 uint8_t g_ramnote_buffer[CONFIG_DRIVERS_NOTERAM_BUFSIZE];
 
+#ifdef CONFIG_DRIVERS_NOTERAM_PERCPU
+static struct noteram_ring_s g_noteram_ring[NCPUS];
+#endif
+
 static const struct note_driver_ops_s g_noteram_ops =
 {
   noteram_add
@@ -177,9 +204,12 @@ struct noteram_driver_s g_noteram_driver =
   g_ramnote_buffer,
   CONFIG_DRIVERS_NOTERAM_BUFSIZE,
 #ifdef CONFIG_DRIVERS_NOTERAM_DEFAULT_NOOVERWRITE
-  NOTERAM_MODE_OVERWRITE_DISABLE
+  NOTERAM_MODE_OVERWRITE_DISABLE,
 #else
-  NOTERAM_MODE_OVERWRITE_ENABLE
+  NOTERAM_MODE_OVERWRITE_ENABLE,
+#endif
+#ifdef CONFIG_DRIVERS_NOTERAM_PERCPU
+  g_noteram_ring
 #endif
 };
 
@@ -187,6 +217,223 @@ struct noteram_driver_s g_noteram_driver =
  * Private Functions
  ****************************************************************************/
 
+#ifdef CONFIG_DRIVERS_NOTERAM_PERCPU
+/****************************************************************************
+ * Name: noteram_ring_size
+ *
+ * Description:
+ *   Return the size of the slice of the note buffer owned by each CPU.  It
+ *   is rounded down to a power of two so that the free running positions
+ *   stay valid when they wrap around.
+ *
+ ****************************************************************************/
+
+static inline unsigned int
+noteram_ring_size(FAR struct noteram_driver_s *drv)
+{
+  unsigned int size = drv->ni_bufsize / NCPUS;
+
+  while ((size & (size - 1)) != 0)
+    {
+      size &= size - 1;
+    }
+
+  return size;
+}
+
+/****************************************************************************
+ * Name: noteram_buffer_clear
+ *
+ * Description:
+ *   Clear all contents of the per-CPU buffers.  Only the owning CPU may
+ *   move its tail, so the request is handled when that CPU adds its next
+ *   note; until then the reader simply skips everything already recorded.
+ *
+ * Input Parameters:
+ *   None.
+ *
+ * Returned Value:
+ *   None.
+ *
+ ****************************************************************************/
+
+static void noteram_buffer_clear(FAR struct noteram_driver_s *drv)
+{
+  FAR struct noteram_ring_s *ring;
+  int cpu;
+
+  for (cpu = 0; cpu < NCPUS; cpu++)
+    {
+      ring = &drv->ni_ring[cpu];
+      ring->read = ring->head;
+      ring->clearreq++;
+    }
+
+  if (drv->ni_overwrite == NOTERAM_MODE_OVERWRITE_OVERFLOW)
+    {
+      drv->ni_overwrite = NOTERAM_MODE_OVERWRITE_DISABLE;
+    }
+}
+
+/****************************************************************************
+ * Name: noteram_unread_length
+ *
+ * Description:
+ *   Return the number of unread bytes in all of the per-CPU buffers.
+ *
+ * Input Parameters:
+ *   drv - The noteram driver
+ *
+ * Returned Value:
+ *   Length of unread data.
+ *
+ ****************************************************************************/
+
+static unsigned int noteram_unread_length(FAR struct noteram_driver_s *drv)
+{
+  FAR struct noteram_ring_s *ring;
+  unsigned int length = 0;
+  unsigned int read;
+  unsigned int tail;
+  int cpu;
+
+  for (cpu = 0; cpu < NCPUS; cpu++)
+    {
+      ring = &drv->ni_ring[cpu];
+      read = ring->read;
+      tail = ring->tail;
+      if ((int)(read - tail) < 0)
+        {
+          read = tail;
+        }
+
+      length += ring->head - read;
+    }
+
+  return length;
+}
+
+/****************************************************************************
+ * Name: noteram_ring_copy
+ *
+ * Description:
+ *   Copy the oldest unread note of one CPU to the user buffer.  If the note
+ *   is overwritten while it is being copied, the copy is retried from the
+ *   new tail.
+ *
+ * Input Parameters:
+ *   drv     - The noteram driver
+ *   cpu     - The CPU whose buffer is read
+ *   buffer  - Location to return the next note (or its first bytes)
+ *   buflen  - The length of the user provided buffer
+ *   consume - True to advance the read position past the note
+ *
+ * Returned Value:
+ *   The length of the note, zero if the buffer is empty, or -EFBIG if the
+ *   note was consumed but did not fit in the user buffer.
+ *
+ ****************************************************************************/
+
+static ssize_t noteram_ring_copy(FAR struct noteram_driver_s *drv, int cpu,
+                                 FAR uint8_t *buffer, size_t buflen,
+                                 bool consume)
+{
+  FAR struct noteram_ring_s *ring = &drv->ni_ring[cpu];
+  unsigned int size = noteram_ring_size(drv);
+  FAR const uint8_t *base = drv->ni_buffer + cpu * size;
+  unsigned int head;
+  unsigned int read;
+  unsigned int tail;
+  size_t notelen;
+  size_t copylen;
+  size_t space;
+
+  do
+    {
+      head = ring->head;
+      UP_DMB();
+
+      read = ring->read;
+      tail = ring->tail;
+      if ((int)(read - tail) < 0)
+        {
+          read = tail;
+        }
+
+      if (read == head)
+        {
+          return 0;
+        }
+
+      notelen = base[read & (size - 1)];
+      copylen = notelen < buflen ? notelen : buflen;
+      space = size - (read & (size - 1));
+      space = space < copylen ? space : copylen;
+      memcpy(buffer, base + (read & (size - 1)), space);
+      memcpy(buffer + space, base, copylen - space);
+      UP_DMB();
+    }
+  while ((int)(read - ring->tail) < 0);
+
+  if (consume)
+    {
+      ring->read = read + NOTE_ALIGN(notelen);
+      if (buflen < notelen)
+        {
+          return -EFBIG;
+        }
+    }
+
+  return notelen;
+}
+
+/****************************************************************************
+ * Name: noteram_get
+ *
+ * Description:
+ *   Remove the oldest note from the per-CPU buffers, merging the CPUs in
+ *   timestamp order.
+ *
+ * Input Parameters:
+ *   buffer - Location to return the next note
+ *   buflen - The length of the user provided buffer
+ *
+ * Returned Value:
+ *   On success, the positive, non-zero length of the return note is
+ *   provided.  Zero is returned only if all of the buffers are empty.  A
+ *   negated errno value is returned in the event of any failure.
+ *
+ ****************************************************************************/
+
+static ssize_t noteram_get(FAR struct noteram_driver_s *drv,
+                           FAR uint8_t *buffer, size_t buflen)
+{
+  struct note_common_s note;
+  clock_t systime = 0;
+  int next = -1;
+  int cpu;
+
+  DEBUGASSERT(buffer != NULL);
+
+  for (cpu = 0; cpu < NCPUS; cpu++)
+    {
+      if (noteram_ring_copy(drv, cpu, (FAR uint8_t *)&note,
+                            sizeof(note), false) > 0 &&
+          (next < 0 || (sclock_t)(note.nc_systime - systime) < 0))
+        {
+          systime = note.nc_systime;
+          next = cpu;
+        }
+    }
+
+  if (next < 0)
+    {
+      return 0;
+    }
+
+  return noteram_ring_copy(drv, next, buffer, buflen, true);
+}
+#else
 /****************************************************************************
  * Name: noteram_buffer_clear
  *
@@ -419,6 +666,7 @@ static ssize_t noteram_get(FAR struct noteram_driver_s *drv,
 
   return notelen;
 }
+#endif
 
 /****************************************************************************
  * Name: noteram_open
@@ -429,10 +677,25 @@ static int noteram_open(FAR struct file *filep)
   FAR struct noteram_dump_context_s *ctx;
   FAR struct noteram_driver_s *drv = (FAR struct noteram_driver_s *)
                                      filep->f_inode->i_private;
+#ifdef CONFIG_DRIVERS_NOTERAM_PERCPU
+  int cpu;
+#endif
 
   /* Reset the read index of the circular buffer */
 
+#ifdef CONFIG_DRIVERS_NOTERAM_PERCPU
+  for (cpu = 0; cpu < NCPUS; cpu++)
+    {
+      FAR struct noteram_ring_s *ring = &drv->ni_ring[cpu];
+
+      if (ring->clearreq == ring->clearack)
+        {
+          ring->read = ring->tail;
+        }
+    }
+#else
   drv->ni_read = drv->ni_tail;
+#endif
   ctx = kmm_zalloc(sizeof(*ctx));
   if (ctx == NULL)
     {
@@ -537,6 +800,22 @@ static int noteram_ioctl(FAR struct file *filep, int cmd, unsigned long arg)
         else
           {
             *(FAR unsigned int *)arg = drv->ni_overwrite;
+#ifdef CONFIG_DRIVERS_NOTERAM_PERCPU
+            if (drv->ni_overwrite == NOTERAM_MODE_OVERWRITE_DISABLE)
+              {
+                int cpu;
+
+                for (cpu = 0; cpu < NCPUS; cpu++)
+                  {
+                    if (drv->ni_ring[cpu].overflow)
+                      {
+                        *(FAR unsigned int *)arg =
+                          NOTERAM_MODE_OVERWRITE_OVERFLOW;
+                      }
+                  }
+              }
+#endif
+
             ret = OK;
           }
         break;
@@ -596,6 +875,33 @@ static int noteram_ioctl(FAR struct file *filep, int cmd, unsigned long arg)
           }
         break;
 
+#ifdef CONFIG_DRIVERS_NOTERAM_PERCPU
+      /* NOTERAM_GETDROPPED
+       *      - Get the number of notes lost by each CPU
+       *        Argument: A writable pointer to an array of
+       *                  CONFIG_SMP_NCPUS unsigned int
+       */
+
+      case NOTERAM_GETDROPPED:
+        if (arg == 0)
+          {
+            ret = -EINVAL;
+          }
+        else
+          {
+            FAR unsigned int *dropped = (FAR unsigned int *)arg;
+            int cpu;
+
+            for (cpu = 0; cpu < NCPUS; cpu++)
+              {
+                dropped[cpu] = drv->ni_ring[cpu].dropped;
+              }
+
+            ret = OK;
+          }
+        break;
+#endif
+
       default:
           break;
     }
@@ -688,6 +994,93 @@ errout:
  *
  ****************************************************************************/
 
+#ifdef CONFIG_DRIVERS_NOTERAM_PERCPU
+static void noteram_add(FAR struct note_driver_s *driver,
+                        FAR const void *note, size_t notelen)
+{
+  FAR struct noteram_driver_s *drv = (FAR struct noteram_driver_s *)driver;
+  FAR struct noteram_ring_s *ring;
+  FAR uint8_t *base;
+  unsigned int size = noteram_ring_size(drv);
+  unsigned int clearreq;
+  unsigned int head;
+  unsigned int tail;
+  unsigned int ndx;
+  size_t space;
+  irqstate_t flags;
+  int cpu;
+
+  /* Only this CPU writes to its ring, so disabling the local interrupts is
+   * all that is needed to serialize the writers.
+   */
+
+  flags = up_irq_save();
+  cpu = this_cpu();
+  ring = &drv->ni_ring[cpu];
+  base = drv->ni_buffer + cpu * size;
+  head = ring->head;
+  tail = ring->tail;
+
+  /* Handle a clear request posted by the reader */
+
+  clearreq = ring->clearreq;
+  if (clearreq != ring->clearack)
+    {
+      tail = head;
+      ring->tail = tail;
+      ring->overflow = false;
+      ring->clearack = clearreq;
+    }
+
+  if (drv->ni_overwrite == NOTERAM_MODE_OVERWRITE_OVERFLOW ||
+      (drv->ni_overwrite == NOTERAM_MODE_OVERWRITE_DISABLE &&
+       ring->overflow))
+    {
+      ring->dropped++;
+      up_irq_restore(flags);
+      return;
+    }
+
+  DEBUGASSERT(note != NULL && notelen < size);
+
+  if (size - (head - tail) < NOTE_ALIGN(notelen))
+    {
+      if (drv->ni_overwrite == NOTERAM_MODE_OVERWRITE_DISABLE)
+        {
+          /* Stop recording if not in overwrite mode */
+
+          ring->overflow = true;
+          ring->dropped++;
+          up_irq_restore(flags);
+          return;
+        }
+
+      /* Drop the oldest notes, and publish the new tail before their space
+       * is reused so that a concurrent reader can tell.
+       */
+
+      do
+        {
+          tail += NOTE_ALIGN(base[tail & (size - 1)]);
+          ring->dropped++;
+        }
+      while (size - (head - tail) < NOTE_ALIGN(notelen));
+
+      ring->tail = tail;
+      UP_DMB();
+    }
+
+  ndx = head & (size - 1);
+  space = size - ndx;
+  space = space < notelen ? space : notelen;
+  memcpy(base + ndx, note, space);
+  memcpy(base, (FAR const uint8_t *)note + space, notelen - space);
+  UP_DMB();
+  ring->head = head + NOTE_ALIGN(notelen);
+  up_irq_restore(flags);
+  poll_notify(&drv->pfd, 1, POLLIN);
+}
+#else
 static void noteram_add(FAR struct note_driver_s *driver,
                         FAR const void *note, size_t notelen)
 {
@@ -740,6 +1133,7 @@ static void noteram_add(FAR struct note_driver_s *driver,
   spin_unlock_irqrestore_notrace(&drv->lock, flags);
   poll_notify(&drv->pfd, 1, POLLIN);
 }
+#endif
 
 /****************************************************************************
  * Name: noteram_dump_init_context
@@ -1344,18 +1738,23 @@ noteram_initialize(FAR const char *devpath, size_t bufsize, bool overwrite)
   size_t len = strlen(devpath) + 1;
 #else
   size_t len = 0;
+#endif
+#ifdef CONFIG_DRIVERS_NOTERAM_PERCPU
+  size_t ringlen = NCPUS * sizeof(struct noteram_ring_s);
+#else
+  size_t ringlen = 0;
 #endif
   int ret;
 
-  drv = kmm_malloc(sizeof(*drv) + len + bufsize);
+  drv = kmm_malloc(sizeof(*drv) + ringlen + len + bufsize);
   if (drv == NULL)
     {
       return NULL;
     }
 #ifdef CONFIG_SCHED_INSTRUMENTATION_FILTER
 
-  memcpy(drv + 1, devpath, len);
-  drv->driver.name = (FAR const char *)(drv + 1);
+  memcpy((FAR uint8_t *)(drv + 1) + ringlen, devpath, len);
+  drv->driver.name = (FAR const char *)(drv + 1) + ringlen;
   drv->driver.filter.mode.flag =
                       CONFIG_SCHED_INSTRUMENTATION_FILTER_DEFAULT_MODE;
 
@@ -1368,8 +1767,12 @@ noteram_initialize(FAR const char *devpath, size_t bufsize, bool overwrite)
 
   drv->driver.ops = &g_noteram_ops;
   drv->ni_bufsize = bufsize;
-  drv->ni_buffer = (FAR uint8_t *)(drv + 1) + len;
+  drv->ni_buffer = (FAR uint8_t *)(drv + 1) + ringlen + len;
   drv->ni_overwrite = overwrite;
+#ifdef CONFIG_DRIVERS_NOTERAM_PERCPU
+  drv->ni_ring = (FAR struct noteram_ring_s *)(drv + 1);
+  memset(drv->ni_ring, 0, ringlen);
+#endif
   drv->ni_head = 0;
   drv->ni_tail = 0;
   drv->ni_read = 0;
@@ -229,6 +229,55 @@ void syslog_add_intbuffer(FAR const char *buffer, size_t buflen);
 void syslog_flush_intbuffer(bool force);
 #endif
 
+/****************************************************************************
+ * Name: syslog_deferred_initialize
+ *
+ * Description:
+ *   Start the thread that drains the per-CPU rings to the channels.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SYSLOG_DEFERRED
+void syslog_deferred_initialize(void);
+#endif
+
+/****************************************************************************
+ * Name: syslog_deferred_write
+ *
+ * Description:
+ *   Copy the data to the ring of the calling CPU, to be written to the
+ *   channels later by the drain thread.
+ *
+ * Input Parameters:
+ *   buffer - The buffer containing the data to be output
+ *   buflen - The number of bytes in the buffer
+ *
+ * Returned Value:
+ *   true if the data was queued or dropped; false if it must be written to
+ *   the channels directly.
+ *
+ * Assumptions:
+ *   May be called from any context.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SYSLOG_DEFERRED
+bool syslog_deferred_write(FAR const char *buffer, size_t buflen);
+#endif
+
+/****************************************************************************
+ * Name: syslog_deferred_flush
+ *
+ * Description:
+ *   Write everything left in the per-CPU rings to the channels, using the
+ *   force() method of the channels.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SYSLOG_DEFERRED
+void syslog_deferred_flush(void);
+#endif
+
 /****************************************************************************
  * Name: syslog_write_foreach
  *
@@ -0,0 +1,491 @@
+/****************************************************************************
+ * drivers/syslog/syslog_deferred.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sched.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+
+#include <nuttx/arch.h>
+#include <nuttx/atomic.h>
+#include <nuttx/clock.h>
+#include <nuttx/init.h>
+#include <nuttx/irq.h>
+#include <nuttx/kthread.h>
+#include <nuttx/semaphore.h>
+#include <nuttx/spinlock.h>
+#include <nuttx/syslog/syslog.h>
+
+#include "syslog.h"
+
+#ifdef CONFIG_SYSLOG_DEFERRED
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define NCPUS             CONFIG_SMP_NCPUS
+
+#define DEFERRED_BUFSIZE  CONFIG_SYSLOG_DEFERRED_BUFSIZE
+#define DEFERRED_MASK     (DEFERRED_BUFSIZE - 1)
+
+#if (DEFERRED_BUFSIZE & DEFERRED_MASK) != 0
+#  error CONFIG_SYSLOG_DEFERRED_BUFSIZE must be a power of two
+#endif
+
+/* A line still incomplete after this long is written out as it is */
+
+#define DEFERRED_TIMEOUT  MSEC2TICK(100)
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* The ring of one CPU.  head and tail are free running and only masked
+ * when indexing the buffer: head is only written by the owning CPU with
+ * interrupts disabled, tail only by the drain side with the lock held.
+ */
+
+struct syslog_ring_s
+{
+  volatile unsigned int head;     /* Next free byte, owning CPU only */
+  volatile unsigned int tail;     /* Next byte to drain, drain side only */
+  volatile unsigned int dropped;  /* Bytes lost, owning CPU only */
+  unsigned int reported;          /* Lost bytes reported, drain side only */
+  char buffer[DEFERRED_BUFSIZE];
+};
+
+struct syslog_deferred_s
+{
+  struct syslog_ring_s ring[NCPUS];
+  spinlock_t lock;                /* Serializes the drain side */
+  sem_t sem;                      /* Wakes up the drain thread */
+  atomic_t waiting;               /* The drain thread wants a post */
+  volatile bool running;          /* The drain thread has been started */
+  char batch[CONFIG_SYSLOG_DEFERRED_BATCHSIZE];
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static struct syslog_deferred_s g_syslog_deferred;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: syslog_deferred_take
+ *
+ * Description:
+ *   Return the number of bytes at the tail of a ring that may be drained,
+ *   at most maxlen: the complete lines, or everything if partial is true.
+ *   A line longer than maxlen is drained in pieces.
+ *
+ * Assumptions:
+ *   The drain lock is held.
+ *
+ ****************************************************************************/
+
+static size_t syslog_deferred_take(FAR struct syslog_ring_s *ring,
+                                   size_t maxlen, bool partial,
+                                   FAR bool *pending)
+{
+  unsigned int head = ring->head;
+  unsigned int tail = ring->tail;
+  size_t avail;
+  size_t len;
+  size_t n;
+
+  UP_DMB();
+
+  avail = head - tail;
+  len = avail < maxlen ? avail : maxlen;
+
+  if (!partial)
+    {
+      for (n = len; n > 0; n--)
+        {
+          if (ring->buffer[(tail + n - 1) & DEFERRED_MASK] == '\n')
+            {
+              break;
+            }
+        }
+
+      if (n > 0 || avail <= maxlen)
+        {
+          len = n;
+        }
+    }
+
+  *pending |= len < avail;
+  return len;
+}
+
+/****************************************************************************
+ * Name: syslog_deferred_copy
+ *
+ * Description:
+ *   Copy len bytes from the tail of a ring and release them.
+ *
+ * Assumptions:
+ *   The drain lock is held.
+ *
+ ****************************************************************************/
+
+static void syslog_deferred_copy(FAR struct syslog_ring_s *ring,
+                                 FAR char *buffer, size_t len)
+{
+  unsigned int tail = ring->tail;
+  size_t offset = tail & DEFERRED_MASK;
+  size_t first = DEFERRED_BUFSIZE - offset;
+
+  if (first > len)
+    {
+      first = len;
+    }
+
+  memcpy(buffer, &ring->buffer[offset], first);
+  memcpy(buffer + first, ring->buffer, len - first);
+
+  UP_DMB();
+  ring->tail = tail + len;
+}
+
+/****************************************************************************
+ * Name: syslog_deferred_lost
+ *
+ * Description:
+ *   Return the number of bytes lost since the last call.
+ *
+ * Assumptions:
+ *   The drain lock is held.
+ *
+ ****************************************************************************/
+
+static unsigned int syslog_deferred_lost(FAR struct syslog_ring_s *ring)
+{
+  unsigned int dropped = ring->dropped;
+  unsigned int lost = dropped - ring->reported;
+
+  ring->reported = dropped;
+  return lost;
+}
+
+/****************************************************************************
+ * Name: syslog_deferred_notice
+ *
+ * Description:
+ *   Tell that bytes were lost on a CPU.
+ *
+ ****************************************************************************/
+
+static void syslog_deferred_notice(int cpu, unsigned int lost, bool force)
+{
+  char notice[48];
+  int len;
+
+  if (lost > 0)
+    {
+      len = snprintf(notice, sizeof(notice),
+                     "[CPU%d] syslog: %u bytes dropped\n", cpu, lost);
+      syslog_write_foreach(notice, len, force);
+    }
+}
+
+/****************************************************************************
+ * Name: syslog_deferred_drain
+ *
+ * Description:
+ *   Write one batch from each ring to the channels.  Returns the number of
+ *   bytes written; *pending is set if bytes are left in a ring.
+ *
+ ****************************************************************************/
+
+static size_t syslog_deferred_drain(FAR struct syslog_deferred_s *defer,
+                                    bool partial, FAR bool *pending)
+{
+  FAR struct syslog_ring_s *ring;
+  irqstate_t flags;
+  unsigned int lost;
+  size_t total = 0;
+  size_t len;
+  int cpu;
+
+  for (cpu = 0; cpu < NCPUS; cpu++)
+    {
+      ring = &defer->ring[cpu];
+
+      /* Only the copy is done with the lock held, the write may block */
+
+      flags = spin_lock_irqsave(&defer->lock);
+      len = syslog_deferred_take(ring, sizeof(defer->batch), partial,
+                                 pending);
+      syslog_deferred_copy(ring, defer->batch, len);
+      lost = syslog_deferred_lost(ring);
+      spin_unlock_irqrestore(&defer->lock, flags);
+
+      if (len > 0)
+        {
+          syslog_write_foreach(defer->batch, len, false);
+          total += len;
+        }
+
+      syslog_deferred_notice(cpu, lost, false);
+    }
+
+  return total;
+}
+
+/****************************************************************************
+ * Name: syslog_deferred_thread
+ *
+ * Description:
+ *   The drain thread.  It sleeps until a CPU adds to an empty ring, and
+ *   waits at most DEFERRED_TIMEOUT for an incomplete line.
+ *
+ ****************************************************************************/
+
+static int syslog_deferred_thread(int argc, FAR char *argv[])
+{
+  FAR struct syslog_deferred_s *defer = &g_syslog_deferred;
+  bool partial = false;
+  bool pending;
+  int ret;
+
+  for (; ; )
+    {
+      /* Ask for a post before looking at the rings, so that a message
+       * added after the rings were found empty is not missed.
+       */
+
+      atomic_set(&defer->waiting, 1);
+      UP_DMB();
+
+      pending = false;
+      if (syslog_deferred_drain(defer, partial, &pending) > 0)
+        {
+          partial = false;
+          continue;
+        }
+
+      if (pending)
+        {
+          ret = nxsem_tickwait(&defer->sem, DEFERRED_TIMEOUT);
+          partial = ret == -ETIMEDOUT;
+        }
+      else
+        {
+          nxsem_wait_uninterruptible(&defer->sem);
+          partial = false;
+        }
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: syslog_deferred_initialize
+ *
+ * Description:
+ *   Start the thread that drains the rings.  Until it is started, SYSLOG
+ *   output is written to the channels directly.
+ *
+ ****************************************************************************/
+
+void syslog_deferred_initialize(void)
+{
+  FAR struct syslog_deferred_s *defer = &g_syslog_deferred;
+  int pid;
+
+  nxsem_init(&defer->sem, 0, 0);
+
+  pid = kthread_create("syslogd", CONFIG_SYSLOG_DEFERRED_PRIORITY,
+                       CONFIG_SYSLOG_DEFERRED_STACKSIZE,
+                       syslog_deferred_thread, NULL);
+  if (pid < 0)
+    {
+      nxsem_destroy(&defer->sem);
+      return;
+    }
+
+  defer->running = true;
+}
+
+/****************************************************************************
+ * Name: syslog_deferred_write
+ *
+ * Description:
+ *   Copy the data to the ring of this CPU.  No lock is taken: the ring is
+ *   only written by this CPU and interrupts are disabled for the copy.
+ *   If the ring is full, the data is dropped and counted.
+ *
+ * Input Parameters:
+ *   buffer - The buffer containing the data to be output
+ *   buflen - The number of bytes in the buffer
+ *
+ * Returned Value:
+ *   true if the data was taken care of; false if it must be written to the
+ *   channels directly: before the drain thread runs, after a panic, or
+ *   when the calling task cannot be preempted.  The last case covers the
+ *   report of an assertion, which runs with the scheduler locked and would
+ *   otherwise fill the ring before the drain thread could run.
+ *
+ ****************************************************************************/
+
+bool syslog_deferred_write(FAR const char *buffer, size_t buflen)
+{
+  FAR struct syslog_deferred_s *defer = &g_syslog_deferred;
+  FAR struct syslog_ring_s *ring;
+  irqstate_t flags;
+  unsigned int head;
+  size_t offset;
+  size_t first;
+
+  if (!defer->running || g_nx_initstate == OSINIT_PANIC ||
+      (!up_interrupt_context() && sched_lockcount() > 0))
+    {
+      return false;
+    }
+
+  flags = up_irq_save();
+
+  ring = &defer->ring[this_cpu()];
+  head = ring->head;
+
+  if (buflen > DEFERRED_BUFSIZE - (head - ring->tail))
+    {
+      ring->dropped += buflen;
+      up_irq_restore(flags);
+      return true;
+    }
+
+  offset = head & DEFERRED_MASK;
+  first = DEFERRED_BUFSIZE - offset;
+  if (first > buflen)
+    {
+      first = buflen;
+    }
+
+  memcpy(&ring->buffer[offset], buffer, first);
+  memcpy(ring->buffer, buffer + first, buflen - first);
+
+  /* Publish the data before the new head, and the new head before looking
+   * at the drain thread's request.
+   */
+
+  UP_DMB();
+  ring->head = head + buflen;
+  UP_DMB();
+
+  up_irq_restore(flags);
+
+  if (atomic_read(&defer->waiting) != 0 &&
+      atomic_xchg(&defer->waiting, 0) != 0)
+    {
+      nxsem_post(&defer->sem);
+    }
+
+  return true;
+}
+
+/****************************************************************************
+ * Name: syslog_deferred_flush
+ *
+ * Description:
+ *   Write everything left in the rings with the force() method of the
+ *   channels.  Used by syslog_flush(), e.g. when the system crashes.
+ *
+ ****************************************************************************/
+
+void syslog_deferred_flush(void)
+{
+  FAR struct syslog_deferred_s *defer = &g_syslog_deferred;
+  FAR struct syslog_ring_s *ring;
+  irqstate_t flags;
+  unsigned int tail;
+  size_t offset;
+  size_t first;
+  size_t len;
+  bool pending = false;
+  int cpu;
+
+  /* The force() methods do not block, so the data is written straight
+   * from the rings with the lock held.  After a crash the lock may be held
+   * by a CPU that will never release it, or by this one, so the rings are
+   * skipped rather than waited for.
+   */
+
+  if (g_nx_initstate == OSINIT_PANIC)
+    {
+      if (!spin_trylock_irqsave(&defer->lock, flags))
+        {
+          return;
+        }
+    }
+  else
+    {
+      flags = spin_lock_irqsave(&defer->lock);
+    }
+
+  for (cpu = 0; cpu < NCPUS; cpu++)
+    {
+      ring = &defer->ring[cpu];
+      len  = syslog_deferred_take(ring, DEFERRED_BUFSIZE, true, &pending);
+      tail = ring->tail;
+
+      offset = tail & DEFERRED_MASK;
+      first = DEFERRED_BUFSIZE - offset;
+      if (first > len)
+        {
+          first = len;
+        }
+
+      if (len > 0)
+        {
+          syslog_write_foreach(&ring->buffer[offset], first, true);
+          syslog_write_foreach(ring->buffer, len - first, true);
+        }
+
+      UP_DMB();
+      ring->tail = tail + len;
+
+      syslog_deferred_notice(cpu, syslog_deferred_lost(ring), true);
+    }
+
+  spin_unlock_irqrestore(&defer->lock, flags);
+}
+
+#endif /* CONFIG_SYSLOG_DEFERRED */
@@ -239,7 +239,18 @@ ssize_t syslog_write_foreach(FAR const char *buffer,
 
 ssize_t syslog_write(FAR const char *buffer, size_t buflen)
 {
-  bool force = !syslog_safe_to_block();
+  bool force;
+
+#ifdef CONFIG_SYSLOG_DEFERRED
+  /* Leave the output to the drain thread, from any context */
+
+  if (syslog_deferred_write(buffer, buflen))
+    {
+      return buflen;
+    }
+#endif
+
+  force = !syslog_safe_to_block();
 
 #ifdef CONFIG_SYSLOG_INTBUFFER
   if (force)
@@ -25,14 +25,18 @@
  ****************************************************************************/
 
 #include <debug.h>
+#include <endian.h>
 #include <errno.h>
 #include <stdint.h>
 #include <string.h>
 
+#include <nuttx/arch.h>
 #include <nuttx/compiler.h>
 #include <nuttx/kmalloc.h>
 #include <nuttx/net/ip.h>
 #include <nuttx/net/netdev_lowerhalf.h>
+#include <nuttx/sched.h>
+#include <nuttx/semaphore.h>
 #include <nuttx/virtio/virtio.h>
 #include <nuttx/net/wifi_sim.h>
 
@@ -45,6 +49,18 @@
 /* Virtio net feature bits */
 
 #define VIRTIO_NET_F_MAC      5
+#define VIRTIO_NET_F_CTRL_VQ  17
+#define VIRTIO_NET_F_MQ       22
+
+/* Virtio net control virtqueue commands */
+
+#define VIRTIO_NET_CTRL_MQ    4
+#define VIRTIO_NET_CTRL_MQ_VQ_PAIRS_SET 0
+#define VIRTIO_NET_OK         0
+
+/* How long to wait for the device to answer a control command */
+
+#define VIRTIO_NET_CTRL_TIMEOUT 1000000 /* Microseconds */
 
 /* Virtio net header size and packet buffer size */
 
@@ -58,6 +74,26 @@
 #define VIRTIO_NET_TX         1
 #define VIRTIO_NET_NUM        2
 
+/* The virtqueues are laid out as rx0, tx0, rx1, tx1, ..., followed by the
+ * control virtqueue after the last pair offered by the device.
+ */
+
+#define VIRTIO_NET_QUEUE_NUM  CONFIG_DRIVERS_VIRTIO_NET_QUEUE_NUM
+#define VIRTIO_NET_VQ(p, t)   ((p) * VIRTIO_NET_NUM + (t))
+#define VIRTIO_NET_PAIR(vq)   ((vq)->vq_queue_index / VIRTIO_NET_NUM)
+
+/* The RX pairs drained by the caller of virtio_net_recv(): with RSS every
+ * CPU has its own netdev work thread and drains only its own pairs.
+ */
+
+#ifdef CONFIG_NETDEV_RSS
+#  define VIRTIO_NET_PAIR_FIRST this_cpu()
+#  define VIRTIO_NET_PAIR_STEP  CONFIG_SMP_NCPUS
+#else
+#  define VIRTIO_NET_PAIR_FIRST 0
+#  define VIRTIO_NET_PAIR_STEP  1
+#endif
+
 #define VIRTIO_NET_MAX_PKT_SIZE \
     ((CONFIG_NET_LL_GUARDSIZE - ETH_HDRLEN) + VIRTIO_NET_BUFSIZE)
 #define VIRTIO_NET_MAX_NIOB \
@@ -99,6 +135,16 @@ begin_packed_struct struct virtio_net_config_s
   uint32_t supported_hash_types;
 } end_packed_struct;
 
+/* Control virtqueue command to set the number of active queue pairs */
+
+begin_packed_struct struct virtio_net_ctrl_mq_s
+{
+  uint8_t  class;                            /* VIRTIO_NET_CTRL_MQ */
+  uint8_t  cmd;                              /* VIRTIO_NET_CTRL_MQ_VQ_* */
+  uint16_t pairs;                            /* Number of queue pairs */
+  uint8_t  ack;                              /* VIRTIO_NET_OK on success */
+} end_packed_struct;
+
 struct virtio_net_priv_s
 {
 #ifdef CONFIG_DRIVERS_WIFI_SIM
@@ -112,12 +158,16 @@ struct virtio_net_priv_s
   struct netdev_lowerhalf_s lower;     /* The netdev lowerhalf */
 #endif
 
-  spinlock_t                lock[VIRTIO_NET_NUM];
+  spinlock_t                lock[VIRTIO_NET_QUEUE_NUM][VIRTIO_NET_NUM];
 
   /* Virtio device information */
 
   FAR struct virtio_device *vdev;      /* Virtio device pointer */
-  int                       bufnum;    /* TX and RX Buffer number */
+  int                       bufnum;    /* Buffer number per virtqueue */
+  int                       npairs;    /* Active RX/TX virtqueue pairs */
+#if VIRTIO_NET_QUEUE_NUM > 1
+  sem_t                     ctrlsem;   /* Control command completion */
+#endif
 };
 
 /* Virtio Link Layer Header, follow shows the iob buffer layout:
@@ -211,7 +261,7 @@ static uint8_t g_netdev_num = 0;
 
 static int virtio_net_addbuffer(FAR struct netdev_lowerhalf_s *dev,
                                 FAR struct virtqueue *vq, FAR netpkt_t *pkt,
-                                unsigned int vq_id)
+                                int pair, unsigned int vq_id)
 {
   FAR struct virtio_net_priv_s *priv = (FAR struct virtio_net_priv_s *)dev;
   FAR struct virtio_net_llhdr_s *hdr;
@@ -265,16 +315,17 @@ static int virtio_net_addbuffer(FAR struct netdev_lowerhalf_s *dev,
       iov_cnt++;
     }
 
-  vrtinfo("Fill vq=%u, hdr=%p, count=%d\n", vq_id, hdr, iov_cnt);
+  vrtinfo("Fill pair=%d, vq=%u, hdr=%p, count=%d\n",
+          pair, vq_id, hdr, iov_cnt);
   if (vq_id == VIRTIO_NET_RX)
     {
       return virtqueue_add_buffer_lock(vq, vb, 0, iov_cnt, hdr,
-                                       &priv->lock[vq_id]);
+                                       &priv->lock[pair][vq_id]);
     }
   else
     {
       return virtqueue_add_buffer_lock(vq, vb, iov_cnt, 0, hdr,
-                                       &priv->lock[vq_id]);
+                                       &priv->lock[pair][vq_id]);
     }
 }
 
@@ -282,15 +333,25 @@ static int virtio_net_addbuffer(FAR struct netdev_lowerhalf_s *dev,
  * Name: virtio_net_rxfill
  ****************************************************************************/
 
-static void virtio_net_rxfill(FAR struct netdev_lowerhalf_s *dev)
+static void virtio_net_rxfill(FAR struct netdev_lowerhalf_s *dev, int pair)
 {
   FAR struct virtio_net_priv_s *priv = (FAR struct virtio_net_priv_s *)dev;
-  FAR struct virtqueue *vq = priv->vdev->vrings_info[VIRTIO_NET_RX].vq;
+  FAR struct virtqueue *vq =
+    priv->vdev->vrings_info[VIRTIO_NET_VQ(pair, VIRTIO_NET_RX)].vq;
   FAR netpkt_t *pkt;
   int i;
 
   for (i = 0; i < priv->bufnum; i++)
     {
+      /* The RX quota is shared by all the pairs and may be more than one
+       * virtqueue can hold, so stop when it runs out of descriptors.
+       */
+
+      if (vq->vq_free_cnt < VIRTIO_NET_MAX_NIOB + 1)
+        {
+          break;
+        }
+
       /* IOB Offload, Alloc buffer from RX netpkt */
 
       pkt = netpkt_alloc(dev, NETPKT_RX);
@@ -312,12 +373,12 @@ static void virtio_net_rxfill(FAR struct netdev_lowerhalf_s *dev)
 
       /* Add buffer to RX virtqueue */
 
-      virtio_net_addbuffer(dev, vq, pkt, VIRTIO_NET_RX);
+      virtio_net_addbuffer(dev, vq, pkt, pair, VIRTIO_NET_RX);
     }
 
   if (i > 0)
     {
-      virtqueue_kick_lock(vq, &priv->lock[VIRTIO_NET_RX]);
+      virtqueue_kick_lock(vq, &priv->lock[pair][VIRTIO_NET_RX]);
     }
 }
 
@@ -328,22 +389,28 @@ static void virtio_net_rxfill(FAR struct netdev_lowerhalf_s *dev)
 static void virtio_net_txfree(FAR struct netdev_lowerhalf_s *dev)
 {
   FAR struct virtio_net_priv_s *priv = (FAR struct virtio_net_priv_s *)dev;
-  FAR struct virtqueue *vq = priv->vdev->vrings_info[VIRTIO_NET_TX].vq;
   FAR struct virtio_net_llhdr_s *hdr;
+  FAR struct virtqueue *vq;
+  int pair;
 
-  while (1)
+  for (pair = 0; pair < priv->npairs; pair++)
     {
-      /* Get buffer from tx virtqueue */
+      vq = priv->vdev->vrings_info[VIRTIO_NET_VQ(pair, VIRTIO_NET_TX)].vq;
 
-      hdr = virtqueue_get_buffer_lock(vq, NULL, NULL,
-                                      &priv->lock[VIRTIO_NET_TX]);
-      if (hdr == NULL)
+      while (1)
         {
-          break;
-        }
+          /* Get buffer from tx virtqueue */
 
-      netpkt_free(dev, hdr->pkt, NETPKT_TX);
-      vrtinfo("Free, hdr: %p, pkt: %p\n", hdr, hdr->pkt);
+          hdr = virtqueue_get_buffer_lock(vq, NULL, NULL,
+                                          &priv->lock[pair][VIRTIO_NET_TX]);
+          if (hdr == NULL)
+            {
+              break;
+            }
+
+          netpkt_free(dev, hdr->pkt, NETPKT_TX);
+          vrtinfo("Free, hdr: %p, pkt: %p\n", hdr, hdr->pkt);
+        }
     }
 }
 
@@ -354,6 +421,7 @@ static void virtio_net_txfree(FAR struct netdev_lowerhalf_s *dev)
 static int virtio_net_ifup(FAR struct netdev_lowerhalf_s *dev)
 {
   FAR struct virtio_net_priv_s *priv = (FAR struct virtio_net_priv_s *)dev;
+  int pair;
 
 #ifdef CONFIG_NET_IPv4
   vrtinfo("Bringing up: %u.%u.%u.%u\n",
@@ -370,9 +438,13 @@ static int virtio_net_ifup(FAR struct netdev_lowerhalf_s *dev)
 
   /* Prepare interrupt and packets for receiving */
 
-  virtqueue_enable_cb_lock(priv->vdev->vrings_info[VIRTIO_NET_RX].vq,
-                           &priv->lock[VIRTIO_NET_RX]);
-  virtio_net_rxfill(dev);
+  for (pair = 0; pair < priv->npairs; pair++)
+    {
+      virtqueue_enable_cb_lock(
+        priv->vdev->vrings_info[VIRTIO_NET_VQ(pair, VIRTIO_NET_RX)].vq,
+        &priv->lock[pair][VIRTIO_NET_RX]);
+      virtio_net_rxfill(dev, pair);
+    }
 
 #ifdef CONFIG_DRIVERS_WIFI_SIM
   if (priv->lower.wifi == NULL)
@@ -395,10 +467,11 @@ static int virtio_net_ifdown(FAR struct netdev_lowerhalf_s *dev)
 
   /* Disable the Ethernet interrupt */
 
-  for (i = 0; i < VIRTIO_NET_NUM; i++)
+  for (i = 0; i < priv->npairs * VIRTIO_NET_NUM; i++)
     {
       virtqueue_disable_cb_lock(priv->vdev->vrings_info[i].vq,
-                                &priv->lock[i]);
+                                &priv->lock[i / VIRTIO_NET_NUM]
+                                           [i % VIRTIO_NET_NUM]);
     }
 
 #ifdef CONFIG_DRIVERS_WIFI_SIM
@@ -422,7 +495,15 @@ static int virtio_net_send(FAR struct netdev_lowerhalf_s *dev,
                            FAR netpkt_t *pkt)
 {
   FAR struct virtio_net_priv_s *priv = (FAR struct virtio_net_priv_s *)dev;
-  FAR struct virtqueue *vq = priv->vdev->vrings_info[VIRTIO_NET_TX].vq;
+  FAR struct virtqueue *vq;
+  int pair;
+
+  /* Send on the pair of the current CPU, a device with VIRTIO_NET_F_MQ
+   * then delivers the packets of this flow to the same pair.
+   */
+
+  pair = this_cpu() % priv->npairs;
+  vq   = priv->vdev->vrings_info[VIRTIO_NET_VQ(pair, VIRTIO_NET_TX)].vq;
 
   /* Check the send length */
 
@@ -434,8 +515,8 @@ static int virtio_net_send(FAR struct netdev_lowerhalf_s *dev,
 
   /* Add buffer to vq and notify the other side */
 
-  virtio_net_addbuffer(dev, vq, pkt, VIRTIO_NET_TX);
-  virtqueue_kick_lock(vq, &priv->lock[VIRTIO_NET_TX]);
+  virtio_net_addbuffer(dev, vq, pkt, pair, VIRTIO_NET_TX);
+  virtqueue_kick_lock(vq, &priv->lock[pair][VIRTIO_NET_TX]);
 
   /* Try return Netpkt TX buffer to upper-half. */
 
@@ -445,54 +526,81 @@ static int virtio_net_send(FAR struct netdev_lowerhalf_s *dev,
 
   if (netdev_lower_quota_load(dev, NETPKT_TX) <= 0)
     {
-      virtqueue_enable_cb_lock(vq, &priv->lock[VIRTIO_NET_TX]);
+      virtqueue_enable_cb_lock(vq, &priv->lock[pair][VIRTIO_NET_TX]);
     }
 
   return OK;
 }
 
 /****************************************************************************
- * Name: virtio_net_recv
+ * Name: virtio_net_recv_pair
  ****************************************************************************/
 
-static netpkt_t *virtio_net_recv(FAR struct netdev_lowerhalf_s *dev)
+static netpkt_t *virtio_net_recv_pair(FAR struct netdev_lowerhalf_s *dev,
+                                      int pair)
 {
   FAR struct virtio_net_priv_s *priv = (FAR struct virtio_net_priv_s *)dev;
-  FAR struct virtqueue *vq = priv->vdev->vrings_info[VIRTIO_NET_RX].vq;
+  FAR struct virtqueue *vq =
+    priv->vdev->vrings_info[VIRTIO_NET_VQ(pair, VIRTIO_NET_RX)].vq;
+  FAR spinlock_t *lock = &priv->lock[pair][VIRTIO_NET_RX];
   FAR struct virtio_net_llhdr_s *hdr;
   irqstate_t flags;
   uint32_t len;
 
   /* Fill the free Netpkt RX buffer to the RX virtqueue */
 
-  virtio_net_rxfill(dev);
+  virtio_net_rxfill(dev, pair);
 
   /* Get received buffer form RX virtqueue */
 
-  flags = spin_lock_irqsave(&priv->lock[VIRTIO_NET_RX]);
+  flags = spin_lock_irqsave(lock);
   hdr = virtqueue_get_buffer(vq, &len, NULL);
   if (hdr == NULL)
     {
       /* If we have no buffer left, enable RX callback. */
 
       virtqueue_enable_cb(vq);
-      spin_unlock_irqrestore(&priv->lock[VIRTIO_NET_RX], flags);
+      spin_unlock_irqrestore(lock, flags);
 
-      vrtinfo("get NULL buffer\n");
+      vrtinfo("get NULL buffer, pair=%d\n", pair);
       return NULL;
     }
   else
     {
-      spin_unlock_irqrestore(&priv->lock[VIRTIO_NET_RX], flags);
+      spin_unlock_irqrestore(lock, flags);
     }
 
   /* Set the received pkt length */
 
   netpkt_setdatalen(dev, hdr->pkt, len - VIRTIO_NET_HDRSIZE);
-  vrtinfo("Recv, hdr=%p, pkt=%p, len=%" PRIu32 "\n", hdr, hdr->pkt, len);
+  vrtinfo("Recv, pair=%d, hdr=%p, pkt=%p, len=%" PRIu32 "\n",
+          pair, hdr, hdr->pkt, len);
   return hdr->pkt;
 }
 
+/****************************************************************************
+ * Name: virtio_net_recv
+ ****************************************************************************/
+
+static netpkt_t *virtio_net_recv(FAR struct netdev_lowerhalf_s *dev)
+{
+  FAR struct virtio_net_priv_s *priv = (FAR struct virtio_net_priv_s *)dev;
+  FAR netpkt_t *pkt;
+  int pair;
+
+  for (pair = VIRTIO_NET_PAIR_FIRST; pair < priv->npairs;
+       pair += VIRTIO_NET_PAIR_STEP)
+    {
+      pkt = virtio_net_recv_pair(dev, pair);
+      if (pkt != NULL)
+        {
+          return pkt;
+        }
+    }
+
+  return NULL;
+}
+
 #ifdef CONFIG_NET_MCASTGROUP
 /****************************************************************************
  * Name: virtio_net_addmac
@@ -523,6 +631,17 @@ static int virtio_net_rmmac(FAR struct netdev_lowerhalf_s *dev,
 static int virtio_net_ioctl(FAR struct netdev_lowerhalf_s *dev,
                             int cmd, unsigned long arg)
 {
+#ifdef CONFIG_NETDEV_RSS
+  /* Nothing to program: replies are sent from the receiving CPU, so the
+   * automatic steering of the device already follows the flow.
+   */
+
+  if (cmd == SIOCNOTIFYRECVCPU)
+    {
+      return OK;
+    }
+#endif
+
   return -ENOTTY;
 }
 #endif
@@ -534,9 +653,11 @@ static int virtio_net_ioctl(FAR struct netdev_lowerhalf_s *dev,
 static void virtio_net_rxready(FAR struct virtqueue *vq)
 {
   FAR struct virtio_net_priv_s *priv = vq->vq_dev->priv;
+  int pair = VIRTIO_NET_PAIR(vq);
 
-  virtqueue_disable_cb_lock(vq, &priv->lock[VIRTIO_NET_RX]);
-  netdev_lower_rxready((FAR struct netdev_lowerhalf_s *)priv);
+  virtqueue_disable_cb_lock(vq, &priv->lock[pair][VIRTIO_NET_RX]);
+  netdev_lower_rxready_cpu((FAR struct netdev_lowerhalf_s *)priv,
+                           pair % CONFIG_SMP_NCPUS);
 }
 
 /****************************************************************************
@@ -547,10 +668,99 @@ static void virtio_net_txdone(FAR struct virtqueue *vq)
 {
   FAR struct virtio_net_priv_s *priv = vq->vq_dev->priv;
 
-  virtqueue_disable_cb_lock(vq, &priv->lock[VIRTIO_NET_TX]);
+  virtqueue_disable_cb_lock(vq, &priv->lock[VIRTIO_NET_PAIR(vq)]
+                                           [VIRTIO_NET_TX]);
   netdev_lower_txdone((FAR struct netdev_lowerhalf_s *)priv);
 }
 
+/****************************************************************************
+ * Name: virtio_net_ctrldone
+ ****************************************************************************/
+
+#if VIRTIO_NET_QUEUE_NUM > 1
+static void virtio_net_ctrldone(FAR struct virtqueue *vq)
+{
+  FAR struct virtio_net_priv_s *priv = vq->vq_dev->priv;
+
+  /* Only one control command is in flight at a time */
+
+  if (virtqueue_get_buffer(vq, NULL, NULL) != NULL)
+    {
+      nxsem_post(&priv->ctrlsem);
+    }
+}
+#endif
+
+/****************************************************************************
+ * Name: virtio_net_set_pairs
+ *
+ * Description:
+ *   Ask the device to spread the received packets over 'pairs' queue pairs
+ *   through the control virtqueue.
+ *
+ ****************************************************************************/
+
+#if VIRTIO_NET_QUEUE_NUM > 1
+static int virtio_net_set_pairs(FAR struct virtio_net_priv_s *priv,
+                                FAR struct virtqueue *vq, int pairs)
+{
+  FAR struct virtio_device *vdev = priv->vdev;
+  FAR struct virtio_net_ctrl_mq_s *ctrl;
+  struct virtqueue_buf vb[3];
+  int ret;
+
+  ctrl = virtio_zalloc_buf(vdev, sizeof(*ctrl), 16);
+  if (ctrl == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  ctrl->class = VIRTIO_NET_CTRL_MQ;
+  ctrl->cmd   = VIRTIO_NET_CTRL_MQ_VQ_PAIRS_SET;
+  ctrl->pairs = htole16(pairs);
+  ctrl->ack   = ~VIRTIO_NET_OK;
+
+  /* Buffer 0: the command header, buffer 1: the number of pairs,
+   * buffer 2: the ack written by the device.
+   */
+
+  vb[0].buf = &ctrl->class;
+  vb[0].len = offsetof(struct virtio_net_ctrl_mq_s, pairs);
+  vb[1].buf = &ctrl->pairs;
+  vb[1].len = sizeof(ctrl->pairs);
+  vb[2].buf = &ctrl->ack;
+  vb[2].len = sizeof(ctrl->ack);
+
+  ret = virtqueue_add_buffer(vq, vb, 2, 1, ctrl);
+  if (ret < 0)
+    {
+      goto out;
+    }
+
+  virtqueue_kick(vq);
+
+  /* virtio_net_ctrldone() reclaims the buffer and posts ctrlsem */
+
+  ret = nxsem_tickwait_uninterruptible(&priv->ctrlsem,
+                                       USEC2TICK(VIRTIO_NET_CTRL_TIMEOUT));
+  if (ret < 0)
+    {
+      /* The device still owns the buffer and may write the ack into it
+       * later, so it cannot be freed.
+       */
+
+      vrterr("Control command timed out\n");
+      return ret;
+    }
+
+  ret = ctrl->ack == VIRTIO_NET_OK ? OK : -EIO;
+
+out:
+  virtio_free_buf(vdev, ctrl);
+  return ret;
+}
+#endif
+
 /****************************************************************************
  * Name: virtio_net_init
  ****************************************************************************/
@@ -558,28 +768,86 @@ static void virtio_net_txdone(FAR struct virtqueue *vq)
 static int virtio_net_init(FAR struct virtio_net_priv_s *priv,
                            FAR struct virtio_device *vdev)
 {
-  FAR const char *vqnames[VIRTIO_NET_NUM];
-  vq_callback callbacks[VIRTIO_NET_NUM];
+  FAR const char **vqnames;
+  FAR vq_callback *callbacks;
+  uint16_t maxpairs = 1;
+  int nvqs;
   int ret;
+  int i;
+
+  for (i = 0; i < VIRTIO_NET_QUEUE_NUM; i++)
+    {
+      spin_lock_init(&priv->lock[i][VIRTIO_NET_RX]);
+      spin_lock_init(&priv->lock[i][VIRTIO_NET_TX]);
+    }
+
+#if VIRTIO_NET_QUEUE_NUM > 1
+  nxsem_init(&priv->ctrlsem, 0, 0);
+#endif
 
-  spin_lock_init(&priv->lock[VIRTIO_NET_RX]);
-  spin_lock_init(&priv->lock[VIRTIO_NET_TX]);
   priv->vdev = vdev;
+  priv->npairs = 1;
   vdev->priv = priv;
 
   /* Initialize the virtio device */
 
   virtio_set_status(vdev, VIRTIO_CONFIG_STATUS_DRIVER);
   virtio_negotiate_features(vdev, (1UL << VIRTIO_NET_F_MAC) |
+#if VIRTIO_NET_QUEUE_NUM > 1
+                                  (1UL << VIRTIO_NET_F_CTRL_VQ) |
+                                  (1UL << VIRTIO_NET_F_MQ) |
+#endif
                                   (1UL << VIRTIO_F_ANY_LAYOUT), NULL);
   virtio_set_status(vdev, VIRTIO_CONFIG_FEATURES_OK);
 
-  vqnames[VIRTIO_NET_RX]   = "virtio_net_rx";
-  vqnames[VIRTIO_NET_TX]   = "virtio_net_tx";
-  callbacks[VIRTIO_NET_RX] = virtio_net_rxready;
-  callbacks[VIRTIO_NET_TX] = virtio_net_txdone;
-  ret = virtio_create_virtqueues(vdev, 0, VIRTIO_NET_NUM, vqnames,
-                                 callbacks, NULL);
+  /* The control virtqueue follows the last pair offered by the device, so
+   * all of them are created even if only the first ones are used.
+   */
+
+  nvqs = VIRTIO_NET_NUM;
+  if (virtio_has_feature(vdev, VIRTIO_NET_F_CTRL_VQ) &&
+      virtio_has_feature(vdev, VIRTIO_NET_F_MQ))
+    {
+      virtio_read_config_member(vdev, struct virtio_net_config_s,
+                                max_virtqueue_pairs, &maxpairs);
+      maxpairs = MAX(maxpairs, 1);
+      nvqs = maxpairs * VIRTIO_NET_NUM + 1;
+    }
+
+  vqnames = kmm_malloc(nvqs * (sizeof(*vqnames) + sizeof(*callbacks)));
+  if (vqnames == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  callbacks = (FAR vq_callback *)(vqnames + nvqs);
+  for (i = 0; i < nvqs; i++)
+    {
+      if (i == maxpairs * VIRTIO_NET_NUM)
+        {
+          vqnames[i]   = "virtio_net_ctrl";
+#if VIRTIO_NET_QUEUE_NUM > 1
+          callbacks[i] = virtio_net_ctrldone;
+#else
+          callbacks[i] = NULL;
+#endif
+        }
+      else if (i % VIRTIO_NET_NUM == VIRTIO_NET_RX)
+        {
+          vqnames[i]   = "virtio_net_rx";
+          callbacks[i] = i < VIRTIO_NET_QUEUE_NUM * VIRTIO_NET_NUM ?
+                         virtio_net_rxready : NULL;
+        }
+      else
+        {
+          vqnames[i]   = "virtio_net_tx";
+          callbacks[i] = i < VIRTIO_NET_QUEUE_NUM * VIRTIO_NET_NUM ?
+                         virtio_net_txdone : NULL;
+        }
+    }
+
+  ret = virtio_create_virtqueues(vdev, 0, nvqs, vqnames, callbacks, NULL);
+  kmm_free(vqnames);
   if (ret < 0)
     {
       vrterr("virtio_device_create_virtqueue failed, ret=%d\n", ret);
@@ -588,6 +856,25 @@ static int virtio_net_init(FAR struct virtio_net_priv_s *priv,
 
   virtio_set_status(vdev, VIRTIO_CONFIG_STATUS_DRIVER_OK);
 
+#if VIRTIO_NET_QUEUE_NUM > 1
+  if (maxpairs > 1)
+    {
+      FAR struct virtqueue *vq =
+        vdev->vrings_info[maxpairs * VIRTIO_NET_NUM].vq;
+      int pairs = MIN(maxpairs, VIRTIO_NET_QUEUE_NUM);
+
+      ret = virtio_net_set_pairs(priv, vq, pairs);
+      if (ret < 0)
+        {
+          vrtwarn("Set %d queue pairs failed, ret=%d\n", pairs, ret);
+        }
+      else
+        {
+          priv->npairs = pairs;
+        }
+    }
+#endif
+
 #if CONFIG_DRIVERS_VIRTIO_NET_BUFNUM > 0
   priv->bufnum = CONFIG_DRIVERS_VIRTIO_NET_BUFNUM;
 #else
@@ -595,7 +882,8 @@ static int virtio_net_init(FAR struct virtio_net_priv_s *priv,
    * 1/4 for the TX netpkts, 1/4 for the RX netpkts.
    */
 
-  priv->bufnum = CONFIG_IOB_NBUFFERS / VIRTIO_NET_MAX_NIOB / 4;
+  priv->bufnum = CONFIG_IOB_NBUFFERS / VIRTIO_NET_MAX_NIOB / 4 /
+                 priv->npairs;
 #endif
   priv->bufnum = MIN(vdev->vrings_info[VIRTIO_NET_RX].info.num_descs /
                      (VIRTIO_NET_MAX_NIOB + 1), priv->bufnum);
@@ -668,8 +956,8 @@ static int virtio_net_probe(FAR struct virtio_device *vdev)
   /* Initialize the netdev lower half */
 
   netdev = (FAR struct netdev_lowerhalf_s *)priv;
-  netdev->quota[NETPKT_RX] = priv->bufnum;
-  netdev->quota[NETPKT_TX] = priv->bufnum;
+  netdev->quota[NETPKT_RX] = priv->bufnum * priv->npairs;
+  netdev->quota[NETPKT_TX] = priv->bufnum * priv->npairs;
   netdev->ops = &g_virtio_net_ops;
 
 #ifdef CONFIG_DRIVERS_WIFI_SIM
@@ -734,6 +1022,9 @@ static void virtio_net_remove(FAR struct virtio_device *vdev)
 #ifdef CONFIG_DRIVERS_WIFI_SIM
   g_netdev_num--;
   wifi_sim_remove(&priv->lower);
+#endif
+#if VIRTIO_NET_QUEUE_NUM > 1
+  nxsem_destroy(&priv->ctrlsem);
 #endif
   kmm_free(priv);
 }
@@ -0,0 +1,683 @@
+/****************************************************************************
+ * fs/aio/aio_ring.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/aioring.h>
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+#include <debug.h>
+
+#include <nuttx/atomic.h>
+#include <nuttx/clock.h>
+#include <nuttx/fs/fs.h>
+#include <nuttx/kmalloc.h>
+#include <nuttx/kthread.h>
+#include <nuttx/mutex.h>
+#include <nuttx/nuttx.h>
+#include <nuttx/queue.h>
+#include <nuttx/semaphore.h>
+
+#ifdef CONFIG_FS_AIORING
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* The ring indices are plain integers in the user ABI */
+
+#define AIORING_INDEX(p) ((FAR atomic_t *)(p))
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+struct aioring_ctx_s;
+
+/* One request taken from the submission queue.  The entry is copied so
+ * that the application may reuse its slot as soon as it is consumed.
+ */
+
+struct aioring_req_s
+{
+  sq_entry_t req_link;                 /* Pending or free list */
+  FAR struct aioring_ctx_s *req_ctx;   /* The ring of the request */
+  FAR struct file *req_filep;          /* Referenced file, if any */
+  struct aioring_sqe_s req_sqe;        /* Copy of the submission entry */
+  struct fs_aio_s req_aio;             /* Passed to the driver submit() */
+};
+
+/* The system side of one ring */
+
+struct aioring_ctx_s
+{
+  sq_entry_t ctx_link;                 /* Supports a list of rings */
+  FAR struct aioring_s *ctx_ring;      /* The shared ring */
+  mutex_t ctx_lock;                    /* Serializes completions */
+  sem_t ctx_waitsem;                   /* Posted on completion */
+  uint16_t ctx_nwaiters;               /* Threads waiting on ctx_waitsem */
+  uint32_t ctx_wakeseq;                /* Counts the wake-ups of waiters */
+  uint32_t ctx_inflight;               /* Requests not completed yet */
+  sq_queue_t ctx_free;                 /* Free request containers */
+  struct aioring_req_s ctx_reqs[1];    /* 'entries' request containers */
+};
+
+#define SIZEOF_AIORING_CTX_S(n) \
+  (sizeof(struct aioring_ctx_s) + ((n) - 1) * sizeof(struct aioring_req_s))
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* Requests from all rings waiting for a worker thread, and the list of
+ * registered rings.  Both are protected by g_aioring_lock.
+ */
+
+static sq_queue_t g_aioring_pending;
+static sq_queue_t g_aioring_list;
+static mutex_t g_aioring_lock = NXMUTEX_INITIALIZER;
+
+/* Counts the requests in g_aioring_pending */
+
+static sem_t g_aioring_sem = SEM_INITIALIZER(0);
+
+static bool g_aioring_started;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: aioring_complete
+ *
+ * Description:
+ *   Post the result of a request to the completion queue and recycle the
+ *   request container.
+ *
+ ****************************************************************************/
+
+static void aioring_complete(FAR struct aioring_req_s *req, ssize_t result)
+{
+  FAR struct aioring_ctx_s *ctx = req->req_ctx;
+  FAR struct aioring_s *ring = ctx->ctx_ring;
+  FAR struct aioring_cqe_s *cqe;
+  uint32_t tail;
+
+  if (req->req_filep != NULL)
+    {
+      file_put(req->req_filep);
+      req->req_filep = NULL;
+    }
+
+  nxmutex_lock(&ctx->ctx_lock);
+
+  /* aioring_submit() keeps the number of requests in flight plus the
+   * unconsumed completions within the ring size, so there is room.
+   */
+
+  tail = atomic_read(AIORING_INDEX(&ring->cq_tail));
+  cqe  = &ring->cqes[tail & (ring->entries - 1)];
+
+  cqe->cqe_userdata = req->req_sqe.sqe_userdata;
+  cqe->cqe_result   = result;
+  atomic_set_release(AIORING_INDEX(&ring->cq_tail), tail + 1);
+
+  sq_addlast(&req->req_link, &ctx->ctx_free);
+  ctx->ctx_inflight--;
+
+  if (ctx->ctx_nwaiters > 0)
+    {
+      ctx->ctx_wakeseq++;
+      do
+        {
+          nxsem_post(&ctx->ctx_waitsem);
+        }
+      while (--ctx->ctx_nwaiters > 0);
+    }
+
+  nxmutex_unlock(&ctx->ctx_lock);
+}
+
+/****************************************************************************
+ * Name: aioring_aiodone
+ ****************************************************************************/
+
+static void aioring_aiodone(FAR struct fs_aio_s *aio, ssize_t result)
+{
+  aioring_complete(container_of(aio, struct aioring_req_s, req_aio),
+                   result);
+}
+
+/****************************************************************************
+ * Name: aioring_async
+ *
+ * Description:
+ *   Start a read or write with the submit() method of the driver or
+ *   socket, so that no worker thread is tied up waiting for it.
+ *
+ * Returned Value:
+ *   OK if the request was started; -ENOSYS if it must be run by a worker
+ *   thread; any other negated errno if it failed.
+ *
+ ****************************************************************************/
+
+static int aioring_async(FAR struct aioring_req_s *req)
+{
+  FAR struct aioring_sqe_s *sqe = &req->req_sqe;
+  FAR struct inode *inode = req->req_filep->f_inode;
+
+  if ((sqe->sqe_opcode != AIORING_OP_READ &&
+       sqe->sqe_opcode != AIORING_OP_WRITE) ||
+      inode == NULL || INODE_IS_MOUNTPT(inode) ||
+      inode->u.i_ops == NULL || inode->u.i_ops->submit == NULL)
+    {
+      return -ENOSYS;
+    }
+
+  req->req_aio.fa_opcode   = sqe->sqe_opcode == AIORING_OP_READ ?
+                             FS_AIO_READ : FS_AIO_WRITE;
+  req->req_aio.fa_buffer   = sqe->sqe_buf;
+  req->req_aio.fa_nbytes   = sqe->sqe_nbytes;
+  req->req_aio.fa_offset   = sqe->sqe_offset;
+  req->req_aio.fa_complete = aioring_aiodone;
+
+  return inode->u.i_ops->submit(req->req_filep, &req->req_aio);
+}
+
+/****************************************************************************
+ * Name: aioring_execute
+ ****************************************************************************/
+
+static ssize_t aioring_execute(FAR struct aioring_req_s *req)
+{
+  FAR struct aioring_sqe_s *sqe = &req->req_sqe;
+
+  switch (sqe->sqe_opcode)
+    {
+      case AIORING_OP_NOP:
+        return 0;
+
+      case AIORING_OP_READ:
+        if (sqe->sqe_offset < 0)
+          {
+            return file_read(req->req_filep, sqe->sqe_buf,
+                             sqe->sqe_nbytes);
+          }
+
+        return file_pread(req->req_filep, sqe->sqe_buf, sqe->sqe_nbytes,
+                          sqe->sqe_offset);
+
+      case AIORING_OP_WRITE:
+        if (sqe->sqe_offset < 0)
+          {
+            return file_write(req->req_filep, sqe->sqe_buf,
+                              sqe->sqe_nbytes);
+          }
+
+        return file_pwrite(req->req_filep, sqe->sqe_buf, sqe->sqe_nbytes,
+                           sqe->sqe_offset);
+
+      case AIORING_OP_FSYNC:
+        return file_fsync(req->req_filep);
+
+      default:
+        return -EINVAL;
+    }
+}
+
+/****************************************************************************
+ * Name: aioring_worker
+ *
+ * Description:
+ *   The AIO ring worker threads.  Several requests, from any ring, are in
+ *   progress at the same time, one per thread.
+ *
+ ****************************************************************************/
+
+static int aioring_worker(int argc, FAR char *argv[])
+{
+  FAR struct aioring_req_s *req;
+
+  for (; ; )
+    {
+      nxsem_wait_uninterruptible(&g_aioring_sem);
+
+      nxmutex_lock(&g_aioring_lock);
+      req = (FAR struct aioring_req_s *)sq_remfirst(&g_aioring_pending);
+      nxmutex_unlock(&g_aioring_lock);
+
+      DEBUGASSERT(req != NULL);
+      aioring_complete(req, aioring_execute(req));
+    }
+
+  return 0;
+}
+
+/****************************************************************************
+ * Name: aioring_start
+ *
+ * Description:
+ *   Start the worker threads.  Called with g_aioring_lock held.
+ *
+ ****************************************************************************/
+
+static int aioring_start(void)
+{
+  int ret;
+  int i;
+
+  if (g_aioring_started)
+    {
+      return OK;
+    }
+
+  for (i = 0; i < CONFIG_FS_AIORING_NTHREADS; i++)
+    {
+      ret = kthread_create("aioring", CONFIG_FS_AIORING_PRIORITY,
+                           CONFIG_FS_AIORING_STACKSIZE, aioring_worker,
+                           NULL);
+      if (ret < 0)
+        {
+          ferr("ERROR: Failed to start worker %d: %d\n", i, ret);
+
+          /* Keep going with the threads already started, if any */
+
+          if (i == 0)
+            {
+              return ret;
+            }
+
+          break;
+        }
+    }
+
+  g_aioring_started = true;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: aioring_context
+ *
+ * Description:
+ *   Return the system side of a registered ring, or NULL.
+ *
+ ****************************************************************************/
+
+static FAR struct aioring_ctx_s *aioring_context(FAR struct aioring_s *ring)
+{
+  FAR sq_entry_t *entry;
+
+  if (ring == NULL)
+    {
+      return NULL;
+    }
+
+  nxmutex_lock(&g_aioring_lock);
+  for (entry = sq_peek(&g_aioring_list); entry; entry = sq_next(entry))
+    {
+      if (entry == ring->priv)
+        {
+          break;
+        }
+    }
+
+  nxmutex_unlock(&g_aioring_lock);
+  return (FAR struct aioring_ctx_s *)entry;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: aioring_setup
+ *
+ * Description:
+ *   Register a ring with the system.  'entries', 'sqes' and 'cqes' must
+ *   already be set up; the indices are reset.
+ *
+ * Returned Value:
+ *   Zero on success; -1 with errno set on failure.
+ *
+ ****************************************************************************/
+
+int aioring_setup(FAR struct aioring_s *ring)
+{
+  FAR struct aioring_ctx_s *ctx;
+  uint32_t i;
+  int ret;
+
+  if (ring == NULL || ring->sqes == NULL || ring->cqes == NULL ||
+      ring->entries == 0 || (ring->entries & (ring->entries - 1)) != 0)
+    {
+      ret = -EINVAL;
+      goto errout;
+    }
+
+  ctx = kmm_zalloc(SIZEOF_AIORING_CTX_S(ring->entries));
+  if (ctx == NULL)
+    {
+      ret = -ENOMEM;
+      goto errout;
+    }
+
+  ctx->ctx_ring = ring;
+  nxmutex_init(&ctx->ctx_lock);
+  nxsem_init(&ctx->ctx_waitsem, 0, 0);
+
+  for (i = 0; i < ring->entries; i++)
+    {
+      ctx->ctx_reqs[i].req_ctx = ctx;
+      sq_addlast(&ctx->ctx_reqs[i].req_link, &ctx->ctx_free);
+    }
+
+  atomic_set(AIORING_INDEX(&ring->sq_head), 0);
+  atomic_set(AIORING_INDEX(&ring->sq_tail), 0);
+  atomic_set(AIORING_INDEX(&ring->cq_head), 0);
+  atomic_set(AIORING_INDEX(&ring->cq_tail), 0);
+  ring->priv = ctx;
+
+  nxmutex_lock(&g_aioring_lock);
+  ret = aioring_start();
+  if (ret >= 0)
+    {
+      sq_addlast(&ctx->ctx_link, &g_aioring_list);
+    }
+
+  nxmutex_unlock(&g_aioring_lock);
+
+  if (ret < 0)
+    {
+      ring->priv = NULL;
+      nxsem_destroy(&ctx->ctx_waitsem);
+      nxmutex_destroy(&ctx->ctx_lock);
+      kmm_free(ctx);
+      goto errout;
+    }
+
+  return OK;
+
+errout:
+  set_errno(-ret);
+  return ERROR;
+}
+
+/****************************************************************************
+ * Name: aioring_submit
+ *
+ * Description:
+ *   Start all requests queued since the last call.  The whole batch is
+ *   handed to the worker threads at once.
+ *
+ * Returned Value:
+ *   The number of requests started; -1 with errno set on failure.
+ *
+ ****************************************************************************/
+
+int aioring_submit(FAR struct aioring_s *ring)
+{
+  FAR struct aioring_ctx_s *ctx;
+  FAR struct aioring_req_s *req;
+  sq_queue_t batch;
+  uint32_t head;
+  uint32_t tail;
+  uint32_t used;
+  int nsubmit = 0;
+  int nqueued = 0;
+  int ret;
+
+  ctx = aioring_context(ring);
+  if (ctx == NULL)
+    {
+      set_errno(EINVAL);
+      return ERROR;
+    }
+
+  sq_init(&batch);
+  head = atomic_read(AIORING_INDEX(&ring->sq_head));
+  tail = atomic_read_acquire(AIORING_INDEX(&ring->sq_tail));
+
+  while (head != tail)
+    {
+      /* Never have more requests in flight than there is room left in
+       * the completion queue.
+       */
+
+      nxmutex_lock(&ctx->ctx_lock);
+      used = ctx->ctx_inflight +
+             (uint32_t)atomic_read(AIORING_INDEX(&ring->cq_tail)) -
+             (uint32_t)atomic_read_acquire(AIORING_INDEX(&ring->cq_head));
+      req  = NULL;
+      if (used < ring->entries)
+        {
+          req = (FAR struct aioring_req_s *)sq_remfirst(&ctx->ctx_free);
+          ctx->ctx_inflight++;
+        }
+
+      nxmutex_unlock(&ctx->ctx_lock);
+
+      if (req == NULL)
+        {
+          break;
+        }
+
+      memcpy(&req->req_sqe, &ring->sqes[head & (ring->entries - 1)],
+             sizeof(struct aioring_sqe_s));
+      head++;
+      nsubmit++;
+
+      /* Take a reference to the file in the context of the caller, since
+       * the worker threads do not share its descriptors.
+       */
+
+      req->req_filep = NULL;
+      if (req->req_sqe.sqe_opcode != AIORING_OP_NOP)
+        {
+          ret = file_get(req->req_sqe.sqe_fd, &req->req_filep);
+          if (ret < 0)
+            {
+              req->req_filep = NULL;
+              aioring_complete(req, ret);
+              continue;
+            }
+
+          /* Drivers and sockets that can start the transfer without
+           * blocking complete it on their own.
+           */
+
+          ret = aioring_async(req);
+          if (ret != -ENOSYS)
+            {
+              if (ret < 0)
+                {
+                  aioring_complete(req, ret);
+                }
+
+              continue;
+            }
+        }
+
+      sq_addlast(&req->req_link, &batch);
+      nqueued++;
+    }
+
+  atomic_set_release(AIORING_INDEX(&ring->sq_head), head);
+
+  if (nqueued > 0)
+    {
+      nxmutex_lock(&g_aioring_lock);
+      sq_cat(&batch, &g_aioring_pending);
+      nxmutex_unlock(&g_aioring_lock);
+
+      while (nqueued-- > 0)
+        {
+          nxsem_post(&g_aioring_sem);
+        }
+    }
+
+  return nsubmit;
+}
+
+/****************************************************************************
+ * Name: aioring_wait
+ *
+ * Description:
+ *   Wait until at least 'ncomplete' completions are available, or until
+ *   'timeout' milliseconds have elapsed.  A negative timeout waits
+ *   forever.  The wait also ends when no request is left in flight.
+ *
+ * Returned Value:
+ *   The number of completions available; -1 with errno set on failure.
+ *
+ ****************************************************************************/
+
+int aioring_wait(FAR struct aioring_s *ring, unsigned int ncomplete,
+                 int timeout)
+{
+  FAR struct aioring_ctx_s *ctx;
+  clock_t deadline = 0;
+  clock_t now;
+  uint32_t navail;
+  uint32_t seq;
+  int ret = OK;
+
+  ctx = aioring_context(ring);
+  if (ctx == NULL)
+    {
+      set_errno(EINVAL);
+      return ERROR;
+    }
+
+  if (timeout >= 0)
+    {
+      deadline = clock_systime_ticks() + MSEC2TICK(timeout);
+    }
+
+  nxmutex_lock(&ctx->ctx_lock);
+  for (; ; )
+    {
+      navail = (uint32_t)atomic_read(AIORING_INDEX(&ring->cq_tail)) -
+               (uint32_t)atomic_read(AIORING_INDEX(&ring->cq_head));
+      if (navail >= ncomplete || ctx->ctx_inflight == 0)
+        {
+          break;
+        }
+
+      ctx->ctx_nwaiters++;
+      seq = ctx->ctx_wakeseq;
+      nxmutex_unlock(&ctx->ctx_lock);
+
+      if (timeout < 0)
+        {
+          ret = nxsem_wait(&ctx->ctx_waitsem);
+        }
+      else
+        {
+          now = clock_systime_ticks();
+          ret = now < deadline ?
+                nxsem_tickwait(&ctx->ctx_waitsem, deadline - now) :
+                -ETIMEDOUT;
+        }
+
+      nxmutex_lock(&ctx->ctx_lock);
+      if (ret < 0)
+        {
+          /* Either no completion has counted this waiter yet, so take it
+           * off the count, or one has posted for it since the wait ended,
+           * so consume that post before it wakes a later wait.
+           */
+
+          if (ctx->ctx_wakeseq == seq)
+            {
+              ctx->ctx_nwaiters--;
+            }
+          else
+            {
+              nxsem_trywait(&ctx->ctx_waitsem);
+            }
+
+          break;
+        }
+    }
+
+  nxmutex_unlock(&ctx->ctx_lock);
+
+  if (ret < 0)
+    {
+      set_errno(-ret);
+      return ERROR;
+    }
+
+  return navail;
+}
+
+/****************************************************************************
+ * Name: aioring_destroy
+ *
+ * Description:
+ *   Wait for the requests in flight to complete, then unregister the ring.
+ *
+ * Returned Value:
+ *   Zero on success; -1 with errno set on failure.
+ *
+ ****************************************************************************/
+
+int aioring_destroy(FAR struct aioring_s *ring)
+{
+  FAR struct aioring_ctx_s *ctx;
+
+  ctx = aioring_context(ring);
+  if (ctx == NULL)
+    {
+      set_errno(EINVAL);
+      return ERROR;
+    }
+
+  nxmutex_lock(&g_aioring_lock);
+  sq_rem(&ctx->ctx_link, &g_aioring_list);
+  nxmutex_unlock(&g_aioring_lock);
+
+  nxmutex_lock(&ctx->ctx_lock);
+  while (ctx->ctx_inflight > 0)
+    {
+      ctx->ctx_nwaiters++;
+      nxmutex_unlock(&ctx->ctx_lock);
+      nxsem_wait_uninterruptible(&ctx->ctx_waitsem);
+      nxmutex_lock(&ctx->ctx_lock);
+    }
+
+  nxmutex_unlock(&ctx->ctx_lock);
+
+  ring->priv = NULL;
+  nxsem_destroy(&ctx->ctx_waitsem);
+  nxmutex_destroy(&ctx->ctx_lock);
+  kmm_free(ctx);
+  return OK;
+}
+
+#endif /* CONFIG_FS_AIORING */
@@ -0,0 +1,686 @@
+/****************************************************************************
+ * fs/driver/fs_blockcache.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+#include <debug.h>
+#include <errno.h>
+
+#include <nuttx/fs/fs.h>
+#include <nuttx/list.h>
+#include <nuttx/mutex.h>
+#include <nuttx/spinlock.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define BLOCKCACHE_BLOCKSIZE CONFIG_FS_BLOCKCACHE_BLOCKSIZE
+#define BLOCKCACHE_NBLOCKS   CONFIG_FS_BLOCKCACHE_NBLOCKS
+
+/* Number of hash chains, must be a power of two */
+
+#define BLOCKCACHE_NHASH     32
+
+#define BLOCKCACHE_HASH(inode, sector) \
+  ((((uintptr_t)(inode) >> 4) ^ (uintptr_t)(sector)) & \
+   (BLOCKCACHE_NHASH - 1))
+
+/* Number of device locks, must be a power of two */
+
+#define BLOCKCACHE_NDEVLOCKS 8
+
+#define BLOCKCACHE_DEVLOCK(inode) \
+  (&g_devlock[((uintptr_t)(inode) >> 4) & (BLOCKCACHE_NDEVLOCKS - 1)])
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+struct blockcache_block_s
+{
+  struct list_node  lru;     /* LRU list node, most recently used first */
+  struct list_node  hash;    /* Hash chain node, valid if inode != NULL */
+  FAR struct inode *inode;   /* Block driver, NULL if the block is free */
+  blkcnt_t          sector;  /* Sector held by the block */
+  bool              dirty;   /* The sector is not yet written back */
+  bool              busy;    /* Data transfer in progress, do not evict */
+  uint8_t           data[BLOCKCACHE_BLOCKSIZE];
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static struct blockcache_block_s g_blocks[BLOCKCACHE_NBLOCKS];
+static struct list_node g_hash[BLOCKCACHE_NHASH];
+static struct list_node g_lru = LIST_INITIAL_VALUE(g_lru);
+
+/* g_lock protects the LRU list, the hash chains, the state of the blocks
+ * and the statistics.  It is only held for short list operations and
+ * copies, never across a transfer.
+ *
+ * g_devlock[] serializes the cached accesses to a block driver: a block
+ * is only filled, modified or written back with the lock of its driver
+ * held.  Block drivers share these locks by the hash of their inode, so
+ * transfers to different drivers normally proceed in parallel.  Bulk
+ * reads that bypass the cache hold no lock at all.
+ */
+
+static spinlock_t g_lock = SP_UNLOCKED;
+static mutex_t g_devlock[BLOCKCACHE_NDEVLOCKS];
+static bool g_initialized;
+
+static uint32_t g_hits;
+static uint32_t g_misses;
+static uint32_t g_writebacks;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: blockcache_devlock
+ *
+ * Description:
+ *   Return the lock of a block driver.  The first call puts all the blocks
+ *   on the LRU list and initializes the locks.
+ *
+ ****************************************************************************/
+
+static FAR mutex_t *blockcache_devlock(FAR struct inode *inode)
+{
+  irqstate_t flags;
+  int i;
+
+  flags = spin_lock_irqsave(&g_lock);
+  if (!g_initialized)
+    {
+      for (i = 0; i < BLOCKCACHE_NHASH; i++)
+        {
+          list_initialize(&g_hash[i]);
+        }
+
+      for (i = 0; i < BLOCKCACHE_NBLOCKS; i++)
+        {
+          list_add_tail(&g_lru, &g_blocks[i].lru);
+        }
+
+      for (i = 0; i < BLOCKCACHE_NDEVLOCKS; i++)
+        {
+          nxmutex_init(&g_devlock[i]);
+        }
+
+      g_initialized = true;
+    }
+
+  spin_unlock_irqrestore(&g_lock, flags);
+  return BLOCKCACHE_DEVLOCK(inode);
+}
+
+/****************************************************************************
+ * Name: blockcache_lookup
+ ****************************************************************************/
+
+static FAR struct blockcache_block_s *
+blockcache_lookup(FAR struct inode *inode, blkcnt_t sector)
+{
+  FAR struct blockcache_block_s *blk;
+
+  list_for_every_entry(&g_hash[BLOCKCACHE_HASH(inode, sector)], blk,
+                       struct blockcache_block_s, hash)
+    {
+      if (blk->inode == inode && blk->sector == sector)
+        {
+          return blk;
+        }
+    }
+
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: blockcache_touch
+ *
+ * Description:
+ *   Move a block to the head of the LRU list.
+ *
+ ****************************************************************************/
+
+static inline void blockcache_touch(FAR struct blockcache_block_s *blk)
+{
+  list_delete(&blk->lru);
+  list_add_head(&g_lru, &blk->lru);
+}
+
+/****************************************************************************
+ * Name: blockcache_release
+ *
+ * Description:
+ *   Drop the sector held by a block and make it the next one to reuse.
+ *
+ ****************************************************************************/
+
+static void blockcache_release(FAR struct blockcache_block_s *blk)
+{
+  if (blk->inode != NULL)
+    {
+      list_delete(&blk->hash);
+      blk->inode = NULL;
+    }
+
+  blk->dirty = false;
+  blk->busy  = false;
+  list_delete(&blk->lru);
+  list_add_tail(&g_lru, &blk->lru);
+}
+
+/****************************************************************************
+ * Name: blockcache_writeback
+ *
+ * Description:
+ *   Write a dirty block back to its driver.  Called with g_lock and the
+ *   lock of the driver held.  g_lock is released during the transfer.
+ *
+ ****************************************************************************/
+
+static int blockcache_writeback(FAR struct blockcache_block_s *blk,
+                                FAR irqstate_t *flags)
+{
+  FAR struct inode *inode = blk->inode;
+  ssize_t ret;
+
+  blk->busy = true;
+  spin_unlock_irqrestore(&g_lock, *flags);
+
+  ret = inode->u.i_bops->write(inode, blk->data, blk->sector, 1);
+
+  *flags = spin_lock_irqsave(&g_lock);
+  blk->busy = false;
+
+  if (ret < 0)
+    {
+      ferr("ERROR: Write back of sector %" PRIuOFF " failed: %zd\n",
+           (off_t)blk->sector, ret);
+      return (int)ret;
+    }
+
+  blk->dirty = false;
+  g_writebacks++;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: blockcache_alloc
+ *
+ * Description:
+ *   Assign the least recently used block to a sector, writing back its
+ *   previous content if needed.  Called with g_lock and 'devlock', the
+ *   lock of 'inode', held.  The returned block is busy and its data is not
+ *   valid yet.  NULL is returned if no block can be reused now.
+ *
+ ****************************************************************************/
+
+static FAR struct blockcache_block_s *
+blockcache_alloc(FAR mutex_t *devlock, FAR struct inode *inode,
+                 blkcnt_t sector, FAR irqstate_t *flags)
+{
+  FAR struct blockcache_block_s *blk;
+  FAR mutex_t *lock;
+  int ret;
+
+  list_for_every_entry_reverse(&g_lru, blk, struct blockcache_block_s, lru)
+    {
+      if (blk->busy)
+        {
+          continue;
+        }
+
+      if (blk->dirty)
+        {
+          /* Writing back a block of another driver needs that driver's
+           * lock.  Do not wait for it, just look further.
+           */
+
+          lock = BLOCKCACHE_DEVLOCK(blk->inode);
+          if (lock != devlock && nxmutex_trylock(lock) < 0)
+            {
+              continue;
+            }
+
+          /* g_lock is dropped during the write back, but the block is
+           * busy and its driver is locked, so it is still the same block
+           * afterwards.  Keep it busy until the other driver is unlocked,
+           * which must not happen with g_lock held.
+           */
+
+          ret = blockcache_writeback(blk, flags);
+          if (lock != devlock)
+            {
+              blk->busy = true;
+              spin_unlock_irqrestore(&g_lock, *flags);
+              nxmutex_unlock(lock);
+              *flags = spin_lock_irqsave(&g_lock);
+              blk->busy = false;
+            }
+
+          if (ret < 0)
+            {
+              return NULL;
+            }
+        }
+
+      if (blk->inode != NULL)
+        {
+          list_delete(&blk->hash);
+        }
+
+      blk->inode  = inode;
+      blk->sector = sector;
+      blk->busy   = true;
+      list_add_head(&g_hash[BLOCKCACHE_HASH(inode, sector)], &blk->hash);
+      blockcache_touch(blk);
+      return blk;
+    }
+
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: blockcache_flush_devlock
+ *
+ * Description:
+ *   Write back the dirty blocks that belong to 'devlock', of 'inode' only
+ *   unless it is NULL.  Called with 'devlock' held.
+ *
+ ****************************************************************************/
+
+static int blockcache_flush_devlock(FAR mutex_t *devlock,
+                                    FAR struct inode *inode)
+{
+  irqstate_t flags;
+  int result = OK;
+  int ret;
+  int i;
+
+  flags = spin_lock_irqsave(&g_lock);
+
+  for (i = 0; i < BLOCKCACHE_NBLOCKS; i++)
+    {
+      FAR struct blockcache_block_s *blk = &g_blocks[i];
+
+      if (blk->dirty && !blk->busy &&
+          BLOCKCACHE_DEVLOCK(blk->inode) == devlock &&
+          (inode == NULL || blk->inode == inode))
+        {
+          ret = blockcache_writeback(blk, &flags);
+          if (ret < 0)
+            {
+              result = ret;
+            }
+        }
+    }
+
+  spin_unlock_irqrestore(&g_lock, flags);
+  return result;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: blockcache_read
+ ****************************************************************************/
+
+ssize_t blockcache_read(FAR struct inode *inode, FAR unsigned char *buffer,
+                        blkcnt_t start, unsigned int nsectors,
+                        size_t sectsize)
+{
+  FAR struct blockcache_block_s *blk;
+  FAR mutex_t *devlock;
+  irqstate_t flags;
+  unsigned int nmiss;
+  unsigned int i;
+  ssize_t ret;
+
+  if (sectsize != BLOCKCACHE_BLOCKSIZE)
+    {
+      return inode->u.i_bops->read(inode, buffer, start, nsectors);
+    }
+
+  devlock = blockcache_devlock(inode);
+  ret = nxmutex_lock(devlock);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  for (i = 0; i < nsectors; i += nmiss)
+    {
+      flags = spin_lock_irqsave(&g_lock);
+
+      blk = blockcache_lookup(inode, start + i);
+      if (blk != NULL)
+        {
+          memcpy(buffer, blk->data, BLOCKCACHE_BLOCKSIZE);
+          blockcache_touch(blk);
+          buffer += BLOCKCACHE_BLOCKSIZE;
+          g_hits++;
+          nmiss = 1;
+          spin_unlock_irqrestore(&g_lock, flags);
+          continue;
+        }
+
+      /* Count the sectors missing from the cache */
+
+      nmiss = 1;
+      while (i + nmiss < nsectors &&
+             blockcache_lookup(inode, start + i + nmiss) == NULL)
+        {
+          nmiss++;
+        }
+
+      /* Only cache single sectors, bulk data would just evict the
+       * metadata that is worth keeping.
+       */
+
+      blk = NULL;
+      if (nmiss == 1)
+        {
+          blk = blockcache_alloc(devlock, inode, start + i, &flags);
+        }
+
+      spin_unlock_irqrestore(&g_lock, flags);
+
+      if (blk != NULL)
+        {
+          ret = inode->u.i_bops->read(inode, blk->data, start + i, 1);
+
+          flags = spin_lock_irqsave(&g_lock);
+          if (ret == 1)
+            {
+              memcpy(buffer, blk->data, BLOCKCACHE_BLOCKSIZE);
+              blk->busy = false;
+            }
+          else
+            {
+              blockcache_release(blk);
+            }
+
+          spin_unlock_irqrestore(&g_lock, flags);
+        }
+      else
+        {
+          /* None of these sectors is cached, so the bulk transfer does not
+           * need to hold the lock of the driver.
+           */
+
+          nxmutex_unlock(devlock);
+          ret = inode->u.i_bops->read(inode, buffer, start + i, nmiss);
+          if (nxmutex_lock(devlock) < 0)
+            {
+              /* Report what has been transferred without the lock */
+
+              return ret < 0 ? ret : (ssize_t)(i + ret);
+            }
+        }
+
+      if (ret < 0)
+        {
+          goto errout_with_lock;
+        }
+
+      flags = spin_lock_irqsave(&g_lock);
+      g_misses += ret;
+      spin_unlock_irqrestore(&g_lock, flags);
+
+      if (ret < (ssize_t)nmiss)
+        {
+          /* Short read, report what has been transferred */
+
+          ret += i;
+          goto errout_with_lock;
+        }
+
+      buffer += nmiss * BLOCKCACHE_BLOCKSIZE;
+    }
+
+  ret = nsectors;
+
+errout_with_lock:
+  nxmutex_unlock(devlock);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: blockcache_write
+ ****************************************************************************/
+
+ssize_t blockcache_write(FAR struct inode *inode,
+                         FAR const unsigned char *buffer, blkcnt_t start,
+                         unsigned int nsectors, size_t sectsize)
+{
+  FAR struct blockcache_block_s *blk;
+  FAR mutex_t *devlock;
+  irqstate_t flags;
+  ssize_t ret;
+  ssize_t i;
+
+  if (sectsize != BLOCKCACHE_BLOCKSIZE)
+    {
+      return inode->u.i_bops->write(inode, buffer, start, nsectors);
+    }
+
+  devlock = blockcache_devlock(inode);
+  ret = nxmutex_lock(devlock);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  if (nsectors == 1)
+    {
+      flags = spin_lock_irqsave(&g_lock);
+
+      blk = blockcache_lookup(inode, start);
+      if (blk == NULL)
+        {
+          blk = blockcache_alloc(devlock, inode, start, &flags);
+        }
+      else
+        {
+          blk->busy = true;
+          blockcache_touch(blk);
+        }
+
+      spin_unlock_irqrestore(&g_lock, flags);
+
+      if (blk != NULL)
+        {
+          memcpy(blk->data, buffer, BLOCKCACHE_BLOCKSIZE);
+#ifdef CONFIG_FS_BLOCKCACHE_WRITEBACK
+          ret = 1;
+#else
+          ret = inode->u.i_bops->write(inode, blk->data, start, 1);
+#endif
+
+          flags = spin_lock_irqsave(&g_lock);
+          if (ret == 1)
+            {
+#ifdef CONFIG_FS_BLOCKCACHE_WRITEBACK
+              blk->dirty = true;
+#endif
+              blk->busy = false;
+            }
+          else
+            {
+              blockcache_release(blk);
+            }
+
+          spin_unlock_irqrestore(&g_lock, flags);
+          goto out_with_lock;
+        }
+    }
+
+  /* Write through and refresh any cached copies */
+
+  ret = inode->u.i_bops->write(inode, buffer, start, nsectors);
+
+  flags = spin_lock_irqsave(&g_lock);
+  for (i = 0; i < ret; i++)
+    {
+      blk = blockcache_lookup(inode, start + i);
+      if (blk != NULL)
+        {
+          memcpy(blk->data, buffer + i * BLOCKCACHE_BLOCKSIZE,
+                 BLOCKCACHE_BLOCKSIZE);
+          blk->dirty = false;
+        }
+    }
+
+  spin_unlock_irqrestore(&g_lock, flags);
+
+out_with_lock:
+  nxmutex_unlock(devlock);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: blockcache_flush
+ ****************************************************************************/
+
+int blockcache_flush(FAR struct inode *inode)
+{
+  FAR mutex_t *devlock;
+  int result = OK;
+  int ret;
+  int i;
+
+  /* Without an inode, flush all the drivers, one lock at a time */
+
+  devlock = blockcache_devlock(inode);
+  for (i = 0; i < BLOCKCACHE_NDEVLOCKS; i++)
+    {
+      if (inode == NULL)
+        {
+          devlock = &g_devlock[i];
+        }
+
+      ret = nxmutex_lock(devlock);
+      if (ret < 0)
+        {
+          return ret;
+        }
+
+      ret = blockcache_flush_devlock(devlock, inode);
+      nxmutex_unlock(devlock);
+
+      if (ret < 0)
+        {
+          result = ret;
+        }
+
+      if (inode != NULL)
+        {
+          break;
+        }
+    }
+
+  return result;
+}
+
+/****************************************************************************
+ * Name: blockcache_invalidate
+ ****************************************************************************/
+
+int blockcache_invalidate(FAR struct inode *inode)
+{
+  FAR mutex_t *devlock;
+  irqstate_t flags;
+  int ret;
+  int i;
+
+  devlock = blockcache_devlock(inode);
+  ret = nxmutex_lock(devlock);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  ret = blockcache_flush_devlock(devlock, inode);
+
+  flags = spin_lock_irqsave(&g_lock);
+
+  for (i = 0; i < BLOCKCACHE_NBLOCKS; i++)
+    {
+      if (g_blocks[i].inode == inode)
+        {
+          blockcache_release(&g_blocks[i]);
+        }
+    }
+
+  spin_unlock_irqrestore(&g_lock, flags);
+  nxmutex_unlock(devlock);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: blockcache_getstats
+ ****************************************************************************/
+
+void blockcache_getstats(FAR struct blockcache_stats_s *stats)
+{
+  irqstate_t flags;
+  int i;
+
+  memset(stats, 0, sizeof(*stats));
+  stats->nblocks = BLOCKCACHE_NBLOCKS;
+
+  flags = spin_lock_irqsave(&g_lock);
+
+  for (i = 0; i < BLOCKCACHE_NBLOCKS; i++)
+    {
+      if (g_blocks[i].inode != NULL)
+        {
+          stats->nused++;
+        }
+
+      if (g_blocks[i].dirty)
+        {
+          stats->ndirty++;
+        }
+    }
+
+  stats->hits       = g_hits;
+  stats->misses     = g_misses;
+  stats->writebacks = g_writebacks;
+
+  spin_unlock_irqrestore(&g_lock, flags);
+}
@@ -82,6 +82,10 @@ int close_blockdriver(FAR struct inode *inode)
    * if needed.
    */
 
+#ifdef CONFIG_FS_BLOCKCACHE
+  blockcache_invalidate(inode);
+#endif
+
   if (inode->u.i_bops->close)
     {
       ret = inode->u.i_bops->close(inode);
@@ -891,6 +891,10 @@ struct fat_mountpt_s
   uint8_t  fs_fatsecperclus;       /* MBR: Sectors per allocation unit: 2**n, n=0..7 */
   uint8_t *fs_buffer;              /* This is an allocated buffer to hold one
                                     * sector from the device */
+#ifdef CONFIG_FAT_FREEMAP
+  uint32_t *fs_freemap;            /* One bit per FAT entry, set if in use.
+                                    * NULL until the FAT has been scanned */
+#endif
 };
 
 /* This structure represents on open file under the mountpoint.  An instance
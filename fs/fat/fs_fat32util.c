@@ -32,6 +32,7 @@
 #include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <time.h>
 #include <assert.h>
 #include <errno.h>
@@ -44,10 +45,137 @@
 #include "inode/inode.h"
 #include "fs_fat32.h"
 
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* The free cluster bitmap covers the FAT entries 0 .. fs_nclusters + 1 */
+
+#define FAT_FREEMAP_NWORDS(fs) (((fs)->fs_nclusters + 2 + 31) >> 5)
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
 
+#ifdef CONFIG_FAT_FREEMAP
+
+/****************************************************************************
+ * Name: fat_buildfreemap
+ *
+ * Description:
+ *   Scan the whole FAT into the free cluster bitmap, allocating it if
+ *   needed, and recompute the free cluster count.
+ *
+ ****************************************************************************/
+
+static int fat_buildfreemap(FAR struct fat_mountpt_s *fs)
+{
+  uint32_t nfreeclusters = 0;
+  uint32_t nwords = FAT_FREEMAP_NWORDS(fs);
+  uint32_t cluster;
+  uint32_t bits;
+  off_t    next;
+
+  if (fs->fs_freemap == NULL)
+    {
+      fs->fs_freemap = fs_heap_malloc(nwords * sizeof(uint32_t));
+      if (fs->fs_freemap == NULL)
+        {
+          return -ENOMEM;
+        }
+    }
+
+  /* The reserved entries and the padding at the end are never free */
+
+  memset(fs->fs_freemap, 0, nwords * sizeof(uint32_t));
+  fs->fs_freemap[0] = 3;
+
+  bits = (fs->fs_nclusters + 2) & 31;
+  if (bits != 0)
+    {
+      fs->fs_freemap[nwords - 1] |= ~0u << bits;
+    }
+
+  for (cluster = 2; cluster < fs->fs_nclusters + 2; cluster++)
+    {
+      next = fat_getcluster(fs, cluster);
+      if (next < 0)
+        {
+          fs_heap_free(fs->fs_freemap);
+          fs->fs_freemap = NULL;
+          return (int)next;
+        }
+      else if (next == 0)
+        {
+          nfreeclusters++;
+        }
+      else
+        {
+          fs->fs_freemap[cluster >> 5] |= 1u << (cluster & 31);
+        }
+    }
+
+  fs->fs_fsifreecount = nfreeclusters;
+  if (fs->fs_type == FSTYPE_FAT32)
+    {
+      fs->fs_fsidirty = true;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: fat_freemapalloc
+ *
+ * Description:
+ *   Find a free cluster after 'startcluster' in the free cluster bitmap.
+ *   The cluster following 'startcluster' is preferred so that files grow
+ *   contiguously, then the search goes on a word of 32 clusters at a
+ *   time, wrapping around at the end of the volume.
+ *
+ * Returned Value:
+ *   The free cluster number, or zero if there is none.
+ *
+ ****************************************************************************/
+
+static uint32_t fat_freemapalloc(FAR struct fat_mountpt_s *fs,
+                                 uint32_t startcluster)
+{
+  FAR uint32_t *map = fs->fs_freemap;
+  uint32_t nwords = FAT_FREEMAP_NWORDS(fs);
+  uint32_t cluster = startcluster + 1;
+  uint32_t word;
+  uint32_t i;
+
+  if (cluster >= fs->fs_nclusters + 2)
+    {
+      cluster = 2;
+    }
+
+  if ((map[cluster >> 5] & (1u << (cluster & 31))) == 0)
+    {
+      return cluster;
+    }
+
+  word = cluster >> 5;
+  for (i = 0; i <= nwords; i++)
+    {
+      if (map[word] != 0xffffffff)
+        {
+          return (word << 5) + ffs(~map[word]) - 1;
+        }
+
+      if (++word >= nwords)
+        {
+          word = 0;
+        }
+    }
+
+  return 0;
+}
+
+#endif /* CONFIG_FAT_FREEMAP */
+
 /****************************************************************************
  * Name: fat_checkfsinfo
  *
@@ -728,8 +856,9 @@ int fat_hwread(struct fat_mountpt_s *fs, uint8_t *buffer,  off_t sector,
       struct inode *inode = fs->fs_blkdriver;
       if (inode && inode->u.i_bops && inode->u.i_bops->read)
         {
-          ssize_t nsectorsread = inode->u.i_bops->read(inode, buffer,
-                                                       sector, nsectors);
+          ssize_t nsectorsread = blockcache_read(inode, buffer, sector,
+                                                 nsectors,
+                                                 fs->fs_hwsectorsize);
           if (nsectorsread == nsectors)
             {
               ret = OK;
@@ -762,7 +891,8 @@ int fat_hwwrite(struct fat_mountpt_s *fs, uint8_t *buffer, off_t sector,
       if (inode && inode->u.i_bops && inode->u.i_bops->write)
         {
           ssize_t nsectorswritten =
-              inode->u.i_bops->write(inode, buffer, sector, nsectors);
+              blockcache_write(inode, buffer, sector, nsectors,
+                               fs->fs_hwsectorsize);
 
           if (nsectorswritten == nsectors)
             {
@@ -1100,6 +1230,22 @@ int fat_putcluster(struct fat_mountpt_s *fs, uint32_t clusterno,
             return -EINVAL;
         }
 
+#ifdef CONFIG_FAT_FREEMAP
+      /* Keep the free cluster bitmap in sync with the FAT */
+
+      if (fs->fs_freemap != NULL && clusterno >= 2)
+        {
+          if (nextcluster != 0)
+            {
+              fs->fs_freemap[clusterno >> 5] |= 1u << (clusterno & 31);
+            }
+          else
+            {
+              fs->fs_freemap[clusterno >> 5] &= ~(1u << (clusterno & 31));
+            }
+        }
+#endif
+
       /* Mark the modified sector as "dirty" and return success */
 
       fs->fs_dirty = true;
@@ -1226,6 +1372,23 @@ int32_t fat_extendchain(struct fat_mountpt_s *fs, uint32_t cluster)
       startcluster = cluster;
     }
 
+#ifdef CONFIG_FAT_FREEMAP
+  /* Look up the free cluster bitmap, scanning the FAT into it the first
+   * time.  Fall back to searching the FAT if there is no memory for it.
+   */
+
+  if (fs->fs_freemap != NULL || fat_buildfreemap(fs) >= 0)
+    {
+      newcluster = fat_freemapalloc(fs, startcluster);
+      if (newcluster == 0)
+        {
+          return 0;
+        }
+
+      goto found;
+    }
+#endif
+
   /* Loop until (1) we discover that there are not free clusters
    * (return 0), an errors occurs (return -errno), or (3) we find
    * the next cluster (return the new cluster number).
@@ -1288,6 +1451,10 @@ int32_t fat_extendchain(struct fat_mountpt_s *fs, uint32_t cluster)
    * number in 'newcluster'  Now mark that cluster as in-use.
    */
 
+#ifdef CONFIG_FAT_FREEMAP
+found:
+#endif
+
   ret = fat_putcluster(fs, newcluster, 0x0fffffff);
   if (ret < 0)
     {
@@ -2035,9 +2202,21 @@ int fat_updatefsinfo(struct fat_mountpt_s *fs)
 
 int fat_computefreeclusters(struct fat_mountpt_s *fs)
 {
+  uint32_t nfreeclusters = 0;
+
+#ifdef CONFIG_FAT_FREEMAP
+  /* Count them while building the free cluster bitmap, falling back to
+   * just counting if there is no memory for it.
+   */
+
+  if (fat_buildfreemap(fs) >= 0)
+    {
+      return OK;
+    }
+#endif
+
   /* We have to count the number of free clusters */
 
-  uint32_t nfreeclusters = 0;
   if (fs->fs_type == FSTYPE_FAT12)
     {
       off_t sector;
@@ -0,0 +1,183 @@
+/****************************************************************************
+ * fs/inode/fs_inodehash.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <nuttx/fs/fs.h>
+
+#include "inode/inode.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define INODE_HASH_SIZE CONFIG_FS_INODE_HASH_SIZE
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* Children of all the directories are chained through i_hash into a single
+ * table keyed by the parent inode and the child name.
+ */
+
+static FAR struct inode *g_inode_hash[INODE_HASH_SIZE];
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: inode_hash
+ *
+ * Description:
+ *   Hash the first component of name, which ends with '/' or '\0', together
+ *   with the parent inode (FNV-1a).
+ *
+ ****************************************************************************/
+
+static unsigned int inode_hash(FAR const struct inode *parent,
+                               FAR const char *name)
+{
+  uint32_t hash = 2166136261u ^ (uint32_t)((uintptr_t)parent >> 3);
+
+  while (*name != '\0' && *name != '/')
+    {
+      hash ^= (uint8_t)*name++;
+      hash *= 16777619u;
+    }
+
+  return hash % INODE_HASH_SIZE;
+}
+
+/****************************************************************************
+ * Name: inode_namematch
+ ****************************************************************************/
+
+static bool inode_namematch(FAR const char *nname, FAR const char *fname)
+{
+  while (*nname != '\0')
+    {
+      if (*nname++ != *fname++)
+        {
+          return false;
+        }
+    }
+
+  return *fname == '\0' || *fname == '/';
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: inode_hash_find
+ ****************************************************************************/
+
+FAR struct inode *inode_hash_find(FAR struct inode *parent,
+                                  FAR const char *name)
+{
+  FAR struct inode *node;
+
+  for (node = g_inode_hash[inode_hash(parent, name)];
+       node != NULL; node = node->i_hash)
+    {
+      if (node->i_parent == parent && inode_namematch(node->i_name, name))
+        {
+          return node;
+        }
+    }
+
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: inode_hash_add
+ ****************************************************************************/
+
+void inode_hash_add(FAR struct inode *inode)
+{
+  FAR struct inode **head;
+
+  head = &g_inode_hash[inode_hash(inode->i_parent, inode->i_name)];
+  inode->i_hash = *head;
+  *head = inode;
+}
+
+/****************************************************************************
+ * Name: inode_hash_add_tree
+ ****************************************************************************/
+
+void inode_hash_add_tree(FAR struct inode *inode)
+{
+  FAR struct inode *child;
+
+  inode_hash_add(inode);
+  for (child = inode->i_child; child != NULL; child = child->i_peer)
+    {
+      inode_hash_add_tree(child);
+    }
+}
+
+/****************************************************************************
+ * Name: inode_hash_del
+ ****************************************************************************/
+
+void inode_hash_del(FAR struct inode *inode)
+{
+  FAR struct inode **curr;
+
+  curr = &g_inode_hash[inode_hash(inode->i_parent, inode->i_name)];
+  for (; *curr != NULL; curr = &(*curr)->i_hash)
+    {
+      if (*curr == inode)
+        {
+          *curr = inode->i_hash;
+          inode->i_hash = NULL;
+          break;
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: inode_hash_del_tree
+ ****************************************************************************/
+
+void inode_hash_del_tree(FAR struct inode *inode)
+{
+  FAR struct inode *child;
+
+  for (child = inode->i_child; child != NULL; child = child->i_peer)
+    {
+      inode_hash_del_tree(child);
+    }
+
+  inode_hash_del(inode);
+}
@@ -76,33 +76,41 @@ static FAR struct inode *inode_unlink(FAR const char *path)
   ret = inode_search(&desc);
   if (ret >= 0)
     {
+      FAR struct inode *peer;
+
       inode = desc.node;
       DEBUGASSERT(inode != NULL);
 
-      /* If peer is non-null, then remove the node from the right of
-       * of that peer node.
+      /* The parent could be null if we are trying to remove the
+       * root inode. In that case, fail because we cannot remove it.
        */
 
-      if (desc.peer != NULL)
+      if (desc.parent == NULL)
         {
-          desc.peer->i_peer = inode->i_peer;
+          inode = NULL;
+          goto errout;
         }
 
-      /* Then remove the node from head of the list of children. */
+      inode_hash_del_tree(inode);
+
+      /* Remove the node from head of the list of children or from the
+       * right of its peer.  desc.peer is not valid when the node was found
+       * through the hash, so look for it here.
+       */
 
+      peer = desc.parent->i_child;
+      if (peer == inode)
+        {
+          desc.parent->i_child = inode->i_peer;
+        }
       else
         {
-          /* The parent could be null if we are trying to remove the
-           * root inode. In that case, fail because we cannot remove it.
-           */
-
-          if (desc.parent == NULL)
+          while (peer->i_peer != inode)
             {
-              inode = NULL;
-              goto errout;
+              peer = peer->i_peer;
             }
 
-          desc.parent->i_child = inode->i_peer;
+          peer->i_peer = inode->i_peer;
         }
 
       inode->i_peer   = NULL;
@@ -242,7 +242,24 @@ static int _inode_search(FAR struct inode_search_s *desc)
 
   while (inode != NULL)
     {
-      int result = _inode_compare(name, inode);
+      int result;
+
+#ifdef CONFIG_FS_INODE_HASH
+      /* Jump straight to the matching child.  The peers are only walked
+       * when the name does not exist, to find where it would be inserted.
+       */
+
+      if (above != NULL && left == NULL)
+        {
+          FAR struct inode *node = inode_hash_find(above, name);
+          if (node != NULL)
+            {
+              inode = node;
+            }
+        }
+#endif
+
+      result = _inode_compare(name, inode);
 
       /* Case 1:  The name is less than the name of the node.
        * Since the names are ordered, these means that there
@@ -100,7 +100,9 @@
  *  node     - INPUT:  (not used)
  *             OUTPUT: On success, holds the pointer to the inode found.
  *  peer     - INPUT:  (not used)
- *             OUTPUT: The inode to the "left" of the inode found.
+ *             OUTPUT: The inode to the "left" of the inode found.  With
+ *                     CONFIG_FS_INODE_HASH, it is only valid when the
+ *                     inode is not found, as the insertion point.
  *  parent   - INPUT:  (not used)
  *             OUTPUT: The inode to the "above" of the inode found.
  *  relpath  - INPUT:  (not used)
@@ -237,6 +239,58 @@ void inode_runlock(void);
 
 int inode_search(FAR struct inode_search_s *desc);
 
+/****************************************************************************
+ * Name: inode_hash_find
+ *
+ * Description:
+ *   Return the child of 'parent' named by the first component of 'name',
+ *   or NULL if there is none.
+ *
+ * Assumptions:
+ *   The caller holds the inode lock
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_FS_INODE_HASH
+FAR struct inode *inode_hash_find(FAR struct inode *parent,
+                                  FAR const char *name);
+
+/****************************************************************************
+ * Name: inode_hash_add, inode_hash_add_tree
+ *
+ * Description:
+ *   Enter an inode linked below its i_parent into the child lookup hash.
+ *   The _tree variant also enters all the inodes below it.
+ *
+ * Assumptions:
+ *   The caller holds the inode lock for writing
+ *
+ ****************************************************************************/
+
+void inode_hash_add(FAR struct inode *inode);
+void inode_hash_add_tree(FAR struct inode *inode);
+
+/****************************************************************************
+ * Name: inode_hash_del, inode_hash_del_tree
+ *
+ * Description:
+ *   Remove an inode from the child lookup hash before it is unlinked from
+ *   its parent.  The _tree variant also removes all the inodes below it.
+ *
+ * Assumptions:
+ *   The caller holds the inode lock for writing
+ *
+ ****************************************************************************/
+
+void inode_hash_del(FAR struct inode *inode);
+void inode_hash_del_tree(FAR struct inode *inode);
+#else
+#  define inode_hash_add(inode)
+#  define inode_hash_add_tree(inode)
+#  define inode_hash_del(inode)
+#  define inode_hash_del_tree(inode)
+#endif
+
 /****************************************************************************
  * Name: inode_find
  *
@@ -28,13 +28,18 @@
 
 #include <errno.h>
 #include <fcntl.h>
+#include <stdlib.h>
 #include <string.h>
+#include <debug.h>
 
+#include <nuttx/clock.h>
 #include <nuttx/fs/fs.h>
 #include <nuttx/fs/ioctl.h>
 #include <nuttx/kmalloc.h>
+#include <nuttx/list.h>
 #include <nuttx/mtd/mtd.h>
 #include <nuttx/mutex.h>
+#include <nuttx/wqueue.h>
 
 #include <sys/stat.h>
 #include <sys/statfs.h>
@@ -52,6 +57,17 @@
 #  error littlefs requires CONFIG_C99_BOOL to be selected
 #endif
 
+/* Mount options */
+
+#define LITTLEFS_OPT_FORCEFORMAT (1 << 0)
+#define LITTLEFS_OPT_AUTOFORMAT  (1 << 1)
+#define LITTLEFS_OPT_RO          (1 << 2)
+
+#ifndef CONFIG_FS_LITTLEFS_WRITEBACK
+#  define littlefs_wb_flush(fs, priv) OK
+#  define littlefs_wb_dirty(fs, priv)
+#endif
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
@@ -66,6 +82,13 @@ struct littlefs_file_s
 {
   struct lfs_file       file;
   int                   refs;
+#ifdef CONFIG_FS_LITTLEFS_WRITEBACK
+  struct list_node      node;     /* Link in the open file list */
+  FAR char             *wbbuf;    /* Write-back buffer, allocated on use */
+  off_t                 wbpos;    /* File position of wbbuf[0] */
+  size_t                wblen;    /* Bytes held in wbbuf */
+  bool                  wbdirty;  /* Written but not committed */
+#endif
 };
 
 /* This structure represents the overall mountpoint state. An instance of
@@ -81,6 +104,12 @@ struct littlefs_mountpt_s
   struct lfs_config     cfg;
   struct lfs            lfs;
   bool                  readonly;
+#ifdef CONFIG_FS_LITTLEFS_WRITEBACK
+  struct list_node      files;    /* Open files */
+  struct work_s         wbwork;   /* Deferred commit of the dirty files */
+  size_t                wbsize;   /* Write-back buffer size of each file */
+  clock_t               wbdelay;  /* Dirty data deadline, in ticks */
+#endif
 };
 
 /* NuttX specific file attributes.
@@ -335,6 +364,165 @@ static FAR const char *littlefs_convert_path(FAR const char *path)
   return path;
 }
 
+#ifdef CONFIG_FS_LITTLEFS_WRITEBACK
+
+/****************************************************************************
+ * Name: littlefs_wb_flush
+ *
+ * Description:
+ *   Hand the buffered data of the file to littlefs.  The data is not
+ *   committed until the file is synchronized.  The buffer is emptied even
+ *   on failure, the error being reported to the caller.
+ *
+ ****************************************************************************/
+
+static int littlefs_wb_flush(FAR struct littlefs_mountpt_s *fs,
+                             FAR struct littlefs_file_s *priv)
+{
+  size_t len = priv->wblen;
+  int ret;
+
+  if (len == 0)
+    {
+      return OK;
+    }
+
+  priv->wblen = 0;
+  if (priv->wbpos != priv->file.pos)
+    {
+      ret = littlefs_convert_result(lfs_file_seek(&fs->lfs, &priv->file,
+                                                  priv->wbpos,
+                                                  LFS_SEEK_SET));
+      if (ret < 0)
+        {
+          return ret;
+        }
+    }
+
+  ret = littlefs_convert_result(lfs_file_write(&fs->lfs, &priv->file,
+                                               priv->wbbuf, len));
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  return (size_t)ret < len ? -ENOSPC : OK;
+}
+
+/****************************************************************************
+ * Name: littlefs_wb_worker
+ *
+ * Description:
+ *   Commit all the dirty files of the mountpoint at once, so that the
+ *   metadata updates of several writes and files share the same commits.
+ *
+ ****************************************************************************/
+
+static void littlefs_wb_worker(FAR void *arg)
+{
+  FAR struct littlefs_mountpt_s *fs = arg;
+  FAR struct littlefs_file_s *priv;
+  int ret;
+
+  if (nxmutex_lock(&fs->lock) < 0)
+    {
+      return;
+    }
+
+  list_for_every_entry(&fs->files, priv, struct littlefs_file_s, node)
+    {
+      if (!priv->wbdirty)
+        {
+          continue;
+        }
+
+      priv->wbdirty = false;
+      ret = littlefs_wb_flush(fs, priv);
+      if (ret >= 0)
+        {
+          ret = littlefs_convert_result(lfs_file_sync(&fs->lfs,
+                                                      &priv->file));
+        }
+
+      if (ret < 0)
+        {
+          ferr("ERROR: Deferred commit failed: %d\n", ret);
+        }
+    }
+
+  nxmutex_unlock(&fs->lock);
+}
+
+/****************************************************************************
+ * Name: littlefs_wb_dirty
+ *
+ * Description:
+ *   Mark the file as holding uncommitted data, and make sure that a
+ *   commit happens within the dirty data deadline.
+ *
+ ****************************************************************************/
+
+static void littlefs_wb_dirty(FAR struct littlefs_mountpt_s *fs,
+                              FAR struct littlefs_file_s *priv)
+{
+  priv->wbdirty = true;
+  if (fs->wbdelay > 0 && work_available(&fs->wbwork))
+    {
+      work_queue(LPWORK, &fs->wbwork, littlefs_wb_worker, fs, fs->wbdelay);
+    }
+}
+
+/****************************************************************************
+ * Name: littlefs_wb_write
+ *
+ * Description:
+ *   Append a small write to the write-back buffer of the file, merging
+ *   consecutive writes into one littlefs write.
+ *
+ ****************************************************************************/
+
+static ssize_t littlefs_wb_write(FAR struct littlefs_mountpt_s *fs,
+                                 FAR struct littlefs_file_s *priv,
+                                 FAR struct file *filep,
+                                 FAR const char *buffer, size_t buflen)
+{
+  int ret;
+
+  if (priv->wblen > 0 &&
+      (filep->f_pos != priv->wbpos + (off_t)priv->wblen ||
+       priv->wblen + buflen > fs->wbsize))
+    {
+      ret = littlefs_wb_flush(fs, priv);
+      if (ret < 0)
+        {
+          return ret;
+        }
+    }
+
+  if (priv->wbbuf == NULL)
+    {
+      priv->wbbuf = fs_heap_malloc(fs->wbsize);
+      if (priv->wbbuf == NULL)
+        {
+          return -ENOMEM;
+        }
+    }
+
+  if (priv->wblen == 0)
+    {
+      priv->wbpos = filep->f_pos;
+    }
+
+  memcpy(priv->wbbuf + priv->wblen, buffer, buflen);
+  priv->wblen  += buflen;
+  filep->f_pos += buflen;
+
+  littlefs_wb_dirty(fs, priv);
+  return buflen;
+}
+
+#endif /* CONFIG_FS_LITTLEFS_WRITEBACK */
+
 /****************************************************************************
  * Name: littlefs_open
  ****************************************************************************/
@@ -454,6 +642,13 @@ static int littlefs_open(FAR struct file *filep, FAR const char *relpath,
       lfs_file_sync(&fs->lfs, &priv->file);
     }
 
+#ifdef CONFIG_FS_LITTLEFS_WRITEBACK
+  priv->wbbuf   = NULL;
+  priv->wblen   = 0;
+  priv->wbdirty = false;
+  list_add_tail(&fs->files, &priv->node);
+#endif
+
   nxmutex_unlock(&fs->lock);
 
   /* Attach the private date to the struct file instance */
@@ -497,7 +692,22 @@ static int littlefs_close(FAR struct file *filep)
 
   if (--priv->refs <= 0)
     {
-      ret = littlefs_convert_result(lfs_file_close(&fs->lfs, &priv->file));
+      int ret2;
+
+#ifdef CONFIG_FS_LITTLEFS_WRITEBACK
+      ret = littlefs_wb_flush(fs, priv);
+      list_delete(&priv->node);
+      if (priv->wbbuf != NULL)
+        {
+          fs_heap_free(priv->wbbuf);
+        }
+#endif
+
+      ret2 = littlefs_convert_result(lfs_file_close(&fs->lfs, &priv->file));
+      if (ret >= 0)
+        {
+          ret = ret2;
+        }
     }
 
   nxmutex_unlock(&fs->lock);
@@ -535,6 +745,12 @@ static ssize_t littlefs_read(FAR struct file *filep, FAR char *buffer,
       return ret;
     }
 
+  ret = littlefs_wb_flush(fs, priv);
+  if (ret < 0)
+    {
+      goto out;
+    }
+
   if (filep->f_pos != priv->file.pos)
     {
       ret = littlefs_convert_result(lfs_file_seek(&fs->lfs, &priv->file,
@@ -584,6 +800,24 @@ static ssize_t littlefs_write(FAR struct file *filep, const char *buffer,
       return ret;
     }
 
+#ifdef CONFIG_FS_LITTLEFS_WRITEBACK
+  /* Small writes go to the write-back buffer, larger ones directly to
+   * littlefs after the buffered data.
+   */
+
+  if (buflen < fs->wbsize)
+    {
+      ret = littlefs_wb_write(fs, priv, filep, buffer, buflen);
+      goto out;
+    }
+
+  ret = littlefs_wb_flush(fs, priv);
+  if (ret < 0)
+    {
+      goto out;
+    }
+#endif
+
   if (filep->f_pos != priv->file.pos)
     {
       ret = littlefs_convert_result(lfs_file_seek(&fs->lfs, &priv->file,
@@ -600,6 +834,7 @@ static ssize_t littlefs_write(FAR struct file *filep, const char *buffer,
   if (ret > 0)
     {
       filep->f_pos += ret;
+      littlefs_wb_dirty(fs, priv);
     }
 
 out:
@@ -632,8 +867,13 @@ static off_t littlefs_seek(FAR struct file *filep, off_t offset, int whence)
       return ret;
     }
 
-  ret = littlefs_convert_result(lfs_file_seek(&fs->lfs, &priv->file,
-                                              offset, whence));
+  ret = littlefs_wb_flush(fs, priv);
+  if (ret >= 0)
+    {
+      ret = littlefs_convert_result(lfs_file_seek(&fs->lfs, &priv->file,
+                                                  offset, whence));
+    }
+
   if (ret >= 0)
     {
       filep->f_pos = ret;
@@ -747,7 +987,15 @@ static int littlefs_sync(FAR struct file *filep)
       return ret;
     }
 
-  ret = littlefs_convert_result(lfs_file_sync(&fs->lfs, &priv->file));
+  ret = littlefs_wb_flush(fs, priv);
+  if (ret >= 0)
+    {
+      ret = littlefs_convert_result(lfs_file_sync(&fs->lfs, &priv->file));
+    }
+
+#ifdef CONFIG_FS_LITTLEFS_WRITEBACK
+  priv->wbdirty = false;
+#endif
   nxmutex_unlock(&fs->lock);
 
   return ret;
@@ -821,6 +1069,12 @@ static int littlefs_fstat(FAR const struct file *filep, FAR struct stat *buf)
       return ret;
     }
 
+  ret = littlefs_wb_flush(fs, priv);
+  if (ret < 0)
+    {
+      goto errout;
+    }
+
   buf->st_size = lfs_file_size(&fs->lfs, &priv->file);
   if (buf->st_size < 0)
     {
@@ -972,8 +1226,19 @@ static int littlefs_truncate(FAR struct file *filep, off_t length)
       return ret;
     }
 
-  ret = littlefs_convert_result(lfs_file_truncate(&fs->lfs, &priv->file,
-                                                  length));
+  ret = littlefs_wb_flush(fs, priv);
+  if (ret >= 0)
+    {
+      ret = littlefs_convert_result(lfs_file_truncate(&fs->lfs,
+                                                      &priv->file,
+                                                      length));
+    }
+
+  if (ret >= 0)
+    {
+      littlefs_wb_dirty(fs, priv);
+    }
+
   nxmutex_unlock(&fs->lock);
 
   return ret;
@@ -1276,6 +1541,68 @@ static int littlefs_sync_block(FAR const struct lfs_config *c)
   return ret == -ENOTTY ? OK : ret;
 }
 
+/****************************************************************************
+ * Name: littlefs_parse_options
+ *
+ * Description:
+ *   Parse the comma separated mount options:
+ *
+ *     forceformat     - Format the device before mounting it
+ *     autoformat      - Format the device if it can't be mounted
+ *     ro              - Mount read-only
+ *     wbsize=<bytes>  - Size of the write-back buffer of each file, zero
+ *                       disables it
+ *     wbdeadline=<ms> - Maximum time written data stays uncommitted, zero
+ *                       disables the deferred commits
+ *
+ ****************************************************************************/
+
+static int littlefs_parse_options(FAR struct littlefs_mountpt_s *fs,
+                                  FAR const char *data, FAR int *flags)
+{
+  FAR char *options;
+  FAR char *saveptr;
+  FAR char *ptr;
+
+  options = fs_heap_strdup(data);
+  if (options == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  ptr = strtok_r(options, ",", &saveptr);
+  while (ptr != NULL)
+    {
+      if (strcmp(ptr, "forceformat") == 0)
+        {
+          *flags |= LITTLEFS_OPT_FORCEFORMAT;
+        }
+      else if (strcmp(ptr, "autoformat") == 0)
+        {
+          *flags |= LITTLEFS_OPT_AUTOFORMAT;
+        }
+      else if (strcmp(ptr, "ro") == 0)
+        {
+          *flags |= LITTLEFS_OPT_RO;
+        }
+#ifdef CONFIG_FS_LITTLEFS_WRITEBACK
+      else if (strncmp(ptr, "wbsize=", 7) == 0)
+        {
+          fs->wbsize = strtoul(&ptr[7], NULL, 0);
+        }
+      else if (strncmp(ptr, "wbdeadline=", 11) == 0)
+        {
+          fs->wbdelay = MSEC2TICK(strtoul(&ptr[11], NULL, 0));
+        }
+#endif
+
+      ptr = strtok_r(NULL, ",", &saveptr);
+    }
+
+  fs_heap_free(options);
+  return OK;
+}
+
 /****************************************************************************
  * Name: littlefs_bind
  *
@@ -1291,6 +1618,7 @@ static int littlefs_bind(FAR struct inode *driver, FAR const void *data,
                          FAR void **handle)
 {
   FAR struct littlefs_mountpt_s *fs;
+  int flags = 0;
   int ret;
 
   /* Open the block driver */
@@ -1321,6 +1649,12 @@ static int littlefs_bind(FAR struct inode *driver, FAR const void *data,
   fs->drv = driver;        /* Save the driver reference */
   nxmutex_init(&fs->lock); /* Initialize the access control mutex */
 
+#ifdef CONFIG_FS_LITTLEFS_WRITEBACK
+  list_initialize(&fs->files);
+  fs->wbsize  = CONFIG_FS_LITTLEFS_WRITEBACK_SIZE;
+  fs->wbdelay = MSEC2TICK(CONFIG_FS_LITTLEFS_WRITEBACK_DEADLINE);
+#endif
+
   if (INODE_IS_MTD(driver))
     {
       /* Get MTD geometry directly */
@@ -1395,13 +1729,24 @@ static int littlefs_bind(FAR struct inode *driver, FAR const void *data,
   fs->cfg.disk_version   = CONFIG_FS_LITTLEFS_DISK_VERSION;
 #endif
 
+  /* Parse the mount options */
+
+  if (data != NULL)
+    {
+      ret = littlefs_parse_options(fs, data, &flags);
+      if (ret < 0)
+        {
+          goto errout_with_fs;
+        }
+    }
+
   /* Then get information about the littlefs filesystem on the devices
    * managed by this driver.
    */
 
   /* Force format the device if -o forceformat */
 
-  if (data && strcmp(data, "forceformat") == 0)
+  if (flags & LITTLEFS_OPT_FORCEFORMAT)
     {
       ret = littlefs_convert_result(lfs_format(&fs->lfs, &fs->cfg));
       if (ret < 0)
@@ -1410,7 +1755,7 @@ static int littlefs_bind(FAR struct inode *driver, FAR const void *data,
         }
     }
 
-  if (data && !strcmp(data, "ro"))
+  if (flags & LITTLEFS_OPT_RO)
     {
       fs->readonly = true;
     }
@@ -1420,7 +1765,7 @@ static int littlefs_bind(FAR struct inode *driver, FAR const void *data,
     {
       /* Auto format the device if -o autoformat */
 
-      if (ret != -EFAULT || !data || strcmp(data, "autoformat"))
+      if (ret != -EFAULT || !(flags & LITTLEFS_OPT_AUTOFORMAT))
         {
           goto errout_with_fs;
         }
@@ -1470,6 +1815,31 @@ static int littlefs_unbind(FAR void *handle, FAR struct inode **driver,
   FAR struct inode *drv = fs->drv;
   int ret;
 
+#ifdef CONFIG_FS_LITTLEFS_WRITEBACK
+  bool busy;
+
+  /* Open files may still have data waiting for the deferred commit, leave
+   * it queued and refuse the unmount.  No file can be opened while the
+   * unbind is in progress.
+   */
+
+  ret = nxmutex_lock(&fs->lock);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  busy = !list_is_empty(&fs->files);
+  nxmutex_unlock(&fs->lock);
+
+  if (busy)
+    {
+      return -EBUSY;
+    }
+
+  work_cancel_sync(LPWORK, &fs->wbwork);
+#endif
+
   /* Unmount */
 
   ret = nxmutex_lock(&fs->lock);
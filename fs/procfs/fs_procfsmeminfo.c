@@ -45,6 +45,7 @@
 #include <nuttx/progmem.h>
 #include <nuttx/sched.h>
 #include <nuttx/mm/mm.h>
+#include <nuttx/mm/mempool.h>
 #include <nuttx/fs/fs.h>
 #include <nuttx/fs/procfs.h>
 
@@ -283,6 +284,9 @@ static ssize_t meminfo_read(FAR struct file *filep, FAR char *buffer,
   size_t copysize;
   size_t totalsize;
   off_t offset;
+#ifdef CONFIG_MM_HEAP_MEMPOOL_MAGAZINE
+  int cpu;
+#endif
 
   finfo("buffer=%p buflen=%d\n", buffer, (int)buflen);
 
@@ -342,6 +346,37 @@ static ssize_t meminfo_read(FAR struct file *filep, FAR char *buffer,
           copysize   = procfs_memcpy(procfile->line, linesize, buffer,
                                      buflen, &offset);
           totalsize += copysize;
+
+#ifdef CONFIG_MM_HEAP_MEMPOOL_MAGAZINE
+          /* Show the mempool magazine usage of each CPU */
+
+          for (cpu = 0; cpu < CONFIG_SMP_NCPUS && buflen > 0; cpu++)
+            {
+              struct mempool_magazineinfo_s maginfo;
+              unsigned long total;
+
+              if (mm_magazineinfo(entry->heap, cpu, &maginfo) < 0)
+                {
+                  break;
+                }
+
+              buffer    += copysize;
+              buflen    -= copysize;
+
+              total      = maginfo.hits + maginfo.misses;
+              linesize   = procfs_snprintf(procfile->line, MEMINFO_LINELEN,
+                                           "%11s cpu%d: hit %lu%% of %lu, "
+                                           "cached %lu blks %lu bytes\n",
+                                           "", cpu,
+                                           total ? maginfo.hits * 100 /
+                                                   total : 0,
+                                           total, maginfo.nblks,
+                                           maginfo.size);
+              copysize   = procfs_memcpy(procfile->line, linesize, buffer,
+                                         buflen, &offset);
+              totalsize += copysize;
+            }
+#endif
         }
     }
 
@@ -651,7 +651,7 @@ static int romfs_ioctl(FAR struct file *filep, int cmd, unsigned long arg)
       strlcat(ptr, rf->rf_path, PATH_MAX);
       return 0;
     }
-  else if (cmd == FIOC_XIPBASE)
+  else if (cmd == FIOC_XIPBASE || cmd == FIOC_XIPFIXED)
     {
       FAR struct romfs_mountpt_s *rm = filep->f_inode->i_private;
       FAR uintptr_t *ptr = (FAR uintptr_t *)arg;
@@ -1234,6 +1234,10 @@ errout_with_mount:
   fs_heap_free(rm);
 
 errout:
+#ifdef CONFIG_FS_BLOCKCACHE
+  blockcache_invalidate(blkdriver);
+#endif
+
   if (blkdriver->u.i_bops->close != NULL)
     {
       blkdriver->u.i_bops->close(blkdriver);
@@ -1295,6 +1299,13 @@ static int romfs_unbind(FAR void *handle, FAR struct inode **blkdriver,
           FAR struct inode *inode = rm->rm_blkdriver;
           if (inode)
             {
+#ifdef CONFIG_FS_BLOCKCACHE
+              if (INODE_IS_BLOCK(inode))
+                {
+                  blockcache_invalidate(inode);
+                }
+#endif
+
               if (INODE_IS_BLOCK(inode) && inode->u.i_bops->close != NULL)
                 {
                   inode->u.i_bops->close(inode);
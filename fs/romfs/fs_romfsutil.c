@@ -571,7 +571,8 @@ static int romfs_hwwrite(FAR struct romfs_mountpt_s *rm, FAR uint8_t *buffer,
 
   if (inode->u.i_bops->write)
     {
-      ret = inode->u.i_bops->write(inode, buffer, sector, nsectors);
+      ret = blockcache_write(inode, buffer, sector, nsectors,
+                             rm->rm_hwsectorsize);
     }
 
   if (ret == (ssize_t)nsectors)
@@ -770,7 +771,8 @@ int romfs_hwread(FAR struct romfs_mountpt_s *rm, FAR uint8_t *buffer,
 
       FAR struct inode *inode = rm->rm_blkdriver;
       ssize_t nsectorsread =
-        inode->u.i_bops->read(inode, buffer, sector, nsectors);
+        blockcache_read(inode, buffer, sector, nsectors,
+                        rm->rm_hwsectorsize);
 
       if (nsectorsread < 0)
         {
@@ -26,13 +26,16 @@
 
 #include <nuttx/config.h>
 
+#include <nuttx/atomic.h>
 #include <nuttx/kmalloc.h>
 #include <nuttx/net/net.h>
 #include <nuttx/fs/fs.h>
 #include <nuttx/mm/mm.h>
+#include <nuttx/wqueue.h>
 
 #include <sys/socket.h>
 #include <assert.h>
+#include <poll.h>
 #include <fcntl.h>
 #include <errno.h>
 #include <debug.h>
@@ -40,6 +43,23 @@
 #include "inode/inode.h"
 #include "fs_heap.h"
 
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+#ifdef CONFIG_FS_AIORING
+/* An asynchronous transfer waiting for the socket to become ready */
+
+struct sock_aio_s
+{
+  struct pollfd sa_fds;          /* Readiness callback on the socket */
+  struct work_s sa_work;         /* Retries the transfer */
+  atomic_t sa_armed;             /* The callback may queue sa_work */
+  FAR struct socket *sa_psock;   /* The socket */
+  FAR struct fs_aio_s *sa_aio;   /* The transfer */
+};
+#endif
+
 /****************************************************************************
  * Private Functions Prototypes
  ****************************************************************************/
@@ -55,6 +75,10 @@ static int sock_file_ioctl(FAR struct file *filep, int cmd,
 static int sock_file_poll(FAR struct file *filep, struct pollfd *fds,
                           bool setup);
 static int sock_file_truncate(FAR struct file *filep, off_t length);
+#ifdef CONFIG_FS_AIORING
+static int sock_file_submit(FAR struct file *filep,
+                            FAR struct fs_aio_s *aio);
+#endif
 
 /****************************************************************************
  * Private Data
@@ -71,6 +95,14 @@ static const struct file_operations g_sock_fileops =
   NULL,               /* mmap */
   sock_file_truncate, /* truncate */
   sock_file_poll      /* poll */
+#ifdef CONFIG_FS_AIORING
+  , NULL              /* readv */
+  , NULL              /* writev */
+#  ifndef CONFIG_DISABLE_PSEUDOFS_OPERATIONS
+  , NULL              /* unlink */
+#  endif
+  , sock_file_submit  /* submit */
+#endif
 };
 
 static struct inode g_sock_inode =
@@ -149,6 +181,101 @@ static int sock_file_truncate(FAR struct file *filep, off_t length)
   return -EINVAL;
 }
 
+#ifdef CONFIG_FS_AIORING
+static ssize_t sock_file_tryio(FAR struct socket *psock,
+                               FAR struct fs_aio_s *aio)
+{
+  if (aio->fa_opcode == FS_AIO_READ)
+    {
+      return psock_recv(psock, aio->fa_buffer, aio->fa_nbytes,
+                        MSG_DONTWAIT);
+    }
+
+  return psock_send(psock, aio->fa_buffer, aio->fa_nbytes, MSG_DONTWAIT);
+}
+
+static int sock_file_aiowait(FAR struct sock_aio_s *saio)
+{
+  /* Only the first event after arming queues the retry, so the work is
+   * never queued twice and nothing touches it once it has run.
+   */
+
+  saio->sa_fds.revents = 0;
+  atomic_set(&saio->sa_armed, 1);
+  return psock_poll(saio->sa_psock, &saio->sa_fds, true);
+}
+
+static void sock_file_aioretry(FAR void *arg)
+{
+  FAR struct sock_aio_s *saio = arg;
+  ssize_t ret;
+
+  psock_poll(saio->sa_psock, &saio->sa_fds, false);
+
+  ret = sock_file_tryio(saio->sa_psock, saio->sa_aio);
+  if (ret == -EAGAIN)
+    {
+      ret = sock_file_aiowait(saio);
+      if (ret >= 0)
+        {
+          return;
+        }
+    }
+
+  saio->sa_aio->fa_complete(saio->sa_aio, ret);
+  fs_heap_free(saio);
+}
+
+static void sock_file_aiopoll(FAR struct pollfd *fds)
+{
+  FAR struct sock_aio_s *saio = fds->arg;
+
+  if (atomic_xchg(&saio->sa_armed, 0) != 0)
+    {
+      work_queue(LPWORK, &saio->sa_work, sock_file_aioretry, saio, 0);
+    }
+}
+
+static int sock_file_submit(FAR struct file *filep,
+                            FAR struct fs_aio_s *aio)
+{
+  FAR struct sock_aio_s *saio;
+  ssize_t ret;
+
+  /* Try the transfer without blocking first.  If the socket is not ready,
+   * wait for it with a poll callback instead of a thread.
+   */
+
+  ret = sock_file_tryio(filep->f_priv, aio);
+  if (ret != -EAGAIN)
+    {
+      aio->fa_complete(aio, ret);
+      return OK;
+    }
+
+  saio = fs_heap_zalloc(sizeof(struct sock_aio_s));
+  if (saio == NULL)
+    {
+      return -ENOSYS;
+    }
+
+  saio->sa_fds.events = aio->fa_opcode == FS_AIO_READ ? POLLIN : POLLOUT;
+  saio->sa_fds.arg    = saio;
+  saio->sa_fds.cb     = sock_file_aiopoll;
+  saio->sa_psock      = filep->f_priv;
+  saio->sa_aio        = aio;
+
+  ret = sock_file_aiowait(saio);
+  if (ret < 0)
+    {
+      fs_heap_free(saio);
+      return -ENOSYS;
+    }
+
+  return OK;
+}
+#endif
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
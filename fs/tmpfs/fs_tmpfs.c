@@ -39,6 +39,7 @@
 #include <nuttx/kmalloc.h>
 #include <nuttx/fs/fs.h>
 #include <nuttx/fs/ioctl.h>
+#include <nuttx/mm/mempool.h>
 
 #include "inode/inode.h"
 #include "fs_tmpfs.h"
@@ -58,6 +59,16 @@
 #  warning CONFIG_FS_TMPFS_FILE_FREEGUARD needs to be > ALLOCGUARD
 #endif
 
+#ifdef CONFIG_FS_TMPFS_PAGED
+#  define TMPFS_BLOCKSIZE     CONFIG_FS_TMPFS_PAGE_SIZE
+#  define TMPFS_PAGE(o)       ((size_t)(o) / CONFIG_FS_TMPFS_PAGE_SIZE)
+#  define TMPFS_PAGEOFF(o)    ((size_t)(o) % CONFIG_FS_TMPFS_PAGE_SIZE)
+#  define TMPFS_NPAGES(s)     TMPFS_PAGE((s) + CONFIG_FS_TMPFS_PAGE_SIZE - 1)
+#else
+#  define TMPFS_BLOCKSIZE     CONFIG_FS_TMPFS_BLOCKSIZE
+#  define tmpfs_free_data(tfo) fs_heap_free((tfo)->tfo_data)
+#endif
+
 #define tmpfs_lock(fs) \
            nxrmutex_lock(&fs->tfs_lock)
 #define tmpfs_lock_object(to) \
@@ -96,6 +107,20 @@ static int  tmpfs_realloc_directory(FAR struct tmpfs_directory_s *tdo,
               unsigned int nentries);
 static int  tmpfs_realloc_file(FAR struct tmpfs_file_s *tfo,
               size_t newsize);
+#ifdef CONFIG_FS_TMPFS_PAGED
+static FAR void *tmpfs_pool_alloc(FAR struct mempool_s *pool,
+              size_t size);
+static void tmpfs_pool_free(FAR struct mempool_s *pool, FAR void *mem);
+static int  tmpfs_initialize_pool(void);
+static FAR uint8_t *tmpfs_alloc_page(FAR struct tmpfs_file_s *tfo,
+              size_t index);
+static void tmpfs_free_pages(FAR struct tmpfs_file_s *tfo, size_t first);
+static void tmpfs_free_data(FAR struct tmpfs_file_s *tfo);
+static void tmpfs_read_pages(FAR struct tmpfs_file_s *tfo,
+              FAR char *buffer, off_t pos, size_t len);
+static ssize_t tmpfs_write_pages(FAR struct tmpfs_file_s *tfo,
+              FAR const char *buffer, off_t pos, size_t len);
+#endif
 static void tmpfs_release_lockedobject(FAR struct tmpfs_object_s *to);
 static void tmpfs_release_lockedfile(FAR struct tmpfs_file_s *tfo);
 static int  tmpfs_release_file(FAR struct tmpfs_file_s *tfo);
@@ -175,6 +200,18 @@ static void tmpfs_stat_common(FAR struct tmpfs_object_s *to,
 static int  tmpfs_stat(FAR struct inode *mountpt, FAR const char *relpath,
               FAR struct stat *buf);
 
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+#ifdef CONFIG_FS_TMPFS_PAGED
+/* File data pages of all TMPFS mounts are taken from this pool */
+
+static struct mempool_s g_tmpfs_pagepool;
+static mutex_t g_tmpfs_poollock = NXMUTEX_INITIALIZER;
+static bool g_tmpfs_poolinit;
+#endif
+
 /****************************************************************************
  * Public Data
  ****************************************************************************/
@@ -268,6 +305,299 @@ static int tmpfs_realloc_directory(FAR struct tmpfs_directory_s *tdo,
   return ret;
 }
 
+/****************************************************************************
+ * Name: tmpfs_pool_alloc and tmpfs_pool_free
+ *
+ * Description:
+ *   Back the page pool with the file system heap.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_FS_TMPFS_PAGED
+static FAR void *tmpfs_pool_alloc(FAR struct mempool_s *pool, size_t size)
+{
+  return fs_heap_memalign(sizeof(uintptr_t), size);
+}
+
+static void tmpfs_pool_free(FAR struct mempool_s *pool, FAR void *mem)
+{
+  fs_heap_free(mem);
+}
+
+/****************************************************************************
+ * Name: tmpfs_initialize_pool
+ *
+ * Description:
+ *   Set up the page pool when the first TMPFS instance is bound.  The pool
+ *   starts out empty and grows CONFIG_FS_TMPFS_PAGE_EXPAND pages at a time.
+ *
+ ****************************************************************************/
+
+static int tmpfs_initialize_pool(void)
+{
+  int ret;
+
+  ret = nxmutex_lock(&g_tmpfs_poollock);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  if (!g_tmpfs_poolinit)
+    {
+      /* The extra page worth of expansion covers the header that the
+       * pool keeps in each chunk.
+       */
+
+      g_tmpfs_pagepool.blocksize  = CONFIG_FS_TMPFS_PAGE_SIZE;
+      g_tmpfs_pagepool.expandsize = (CONFIG_FS_TMPFS_PAGE_EXPAND + 1) *
+                                    MEMPOOL_REALBLOCKSIZE(&g_tmpfs_pagepool);
+      g_tmpfs_pagepool.alloc      = tmpfs_pool_alloc;
+      g_tmpfs_pagepool.free       = tmpfs_pool_free;
+
+      ret = mempool_init(&g_tmpfs_pagepool, "tmpfs");
+      g_tmpfs_poolinit = ret >= 0;
+    }
+
+  nxmutex_unlock(&g_tmpfs_poollock);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: tmpfs_alloc_page
+ *
+ * Description:
+ *   Return the page holding the data at page index 'index' of the file,
+ *   allocating a zeroed page if that part of the file is still a hole.
+ *   The file must be locked and 'index' must lie within the page table.
+ *
+ ****************************************************************************/
+
+static FAR uint8_t *tmpfs_alloc_page(FAR struct tmpfs_file_s *tfo,
+                                     size_t index)
+{
+  FAR uint8_t *page;
+
+  DEBUGASSERT(index < tfo->tfo_npages);
+
+  page = tfo->tfo_pages[index];
+  if (page == NULL)
+    {
+      page = mempool_allocate(&g_tmpfs_pagepool);
+      if (page != NULL)
+        {
+          memset(page, 0, CONFIG_FS_TMPFS_PAGE_SIZE);
+          tfo->tfo_pages[index] = page;
+          tfo->tfo_alloc += CONFIG_FS_TMPFS_PAGE_SIZE;
+        }
+    }
+
+  return page;
+}
+
+/****************************************************************************
+ * Name: tmpfs_free_pages
+ *
+ * Description:
+ *   Return all pages of the file from page index 'first' on to the pool.
+ *
+ ****************************************************************************/
+
+static void tmpfs_free_pages(FAR struct tmpfs_file_s *tfo, size_t first)
+{
+  size_t i;
+
+  for (i = first; i < tfo->tfo_npages; i++)
+    {
+      if (tfo->tfo_pages[i] != NULL)
+        {
+          mempool_release(&g_tmpfs_pagepool, tfo->tfo_pages[i]);
+          tfo->tfo_pages[i] = NULL;
+          tfo->tfo_alloc -= CONFIG_FS_TMPFS_PAGE_SIZE;
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: tmpfs_free_data
+ ****************************************************************************/
+
+static void tmpfs_free_data(FAR struct tmpfs_file_s *tfo)
+{
+  tmpfs_free_pages(tfo, 0);
+  fs_heap_free(tfo->tfo_pages);
+
+  tfo->tfo_pages  = NULL;
+  tfo->tfo_npages = 0;
+  tfo->tfo_alloc  = 0;
+}
+
+/****************************************************************************
+ * Name: tmpfs_read_pages
+ *
+ * Description:
+ *   Copy file data out of the pages.  Holes read back as zeros.
+ *
+ ****************************************************************************/
+
+static void tmpfs_read_pages(FAR struct tmpfs_file_s *tfo,
+                             FAR char *buffer, off_t pos, size_t len)
+{
+  FAR const uint8_t *page;
+  size_t offset;
+  size_t nbytes;
+
+  while (len > 0)
+    {
+      page   = tfo->tfo_pages[TMPFS_PAGE(pos)];
+      offset = TMPFS_PAGEOFF(pos);
+      nbytes = CONFIG_FS_TMPFS_PAGE_SIZE - offset;
+      if (nbytes > len)
+        {
+          nbytes = len;
+        }
+
+      if (page != NULL)
+        {
+          memcpy(buffer, page + offset, nbytes);
+        }
+      else
+        {
+          memset(buffer, 0, nbytes);
+        }
+
+      buffer += nbytes;
+      pos    += nbytes;
+      len    -= nbytes;
+    }
+}
+
+/****************************************************************************
+ * Name: tmpfs_write_pages
+ *
+ * Description:
+ *   Copy data into the file pages, filling in holes as they are reached.
+ *   The page table must already cover the range.
+ *
+ * Returned Value:
+ *   The number of bytes written.  This is less than 'len' if the pool ran
+ *   out of pages part way.  -ENOMEM is returned if nothing was written.
+ *
+ ****************************************************************************/
+
+static ssize_t tmpfs_write_pages(FAR struct tmpfs_file_s *tfo,
+                                 FAR const char *buffer, off_t pos,
+                                 size_t len)
+{
+  FAR uint8_t *page;
+  size_t offset;
+  size_t nbytes;
+  size_t total = 0;
+
+  while (total < len)
+    {
+      page = tmpfs_alloc_page(tfo, TMPFS_PAGE(pos));
+      if (page == NULL)
+        {
+          return total > 0 ? (ssize_t)total : -ENOMEM;
+        }
+
+      offset = TMPFS_PAGEOFF(pos);
+      nbytes = CONFIG_FS_TMPFS_PAGE_SIZE - offset;
+      if (nbytes > len - total)
+        {
+          nbytes = len - total;
+        }
+
+      memcpy(page + offset, buffer + total, nbytes);
+
+      pos   += nbytes;
+      total += nbytes;
+    }
+
+  return total;
+}
+
+/****************************************************************************
+ * Name: tmpfs_realloc_file
+ *
+ * Description:
+ *   Resize the file to 'newsize' bytes.  Only the page table is resized
+ *   here; pages are allocated lazily as they are written.  The table grows
+ *   geometrically, and since it holds only page pointers no file data is
+ *   ever moved, making appends amortized O(1).
+ *
+ *   Bytes beyond tfo_size within the last page are always kept zero so
+ *   that a later extension of the file reads back zeros.
+ *
+ ****************************************************************************/
+
+static int tmpfs_realloc_file(FAR struct tmpfs_file_s *tfo,
+                              size_t newsize)
+{
+  FAR uint8_t **newpages;
+  FAR uint8_t *page;
+  size_t npages;
+  size_t nentries;
+  size_t offset;
+
+  if (newsize > SIZE_MAX - CONFIG_FS_TMPFS_PAGE_SIZE)
+    {
+      /* There would be an integer overflow */
+
+      return -ENOMEM;
+    }
+
+  npages = TMPFS_NPAGES(newsize);
+
+  if (newsize == 0)
+    {
+      tmpfs_free_data(tfo);
+    }
+  else if (newsize < tfo->tfo_size)
+    {
+      tmpfs_free_pages(tfo, npages);
+
+      offset = TMPFS_PAGEOFF(newsize);
+      page   = tfo->tfo_pages[npages - 1];
+      if (offset != 0 && page != NULL)
+        {
+          memset(page + offset, 0, CONFIG_FS_TMPFS_PAGE_SIZE - offset);
+        }
+    }
+  else if (npages > tfo->tfo_npages)
+    {
+      nentries = tfo->tfo_npages > 0 ? tfo->tfo_npages : 4;
+      while (nentries < npages)
+        {
+          nentries <<= 1;
+        }
+
+      if (nentries > SIZE_MAX / sizeof(FAR uint8_t *))
+        {
+          return -ENOMEM;
+        }
+
+      newpages = fs_heap_realloc(tfo->tfo_pages,
+                                 nentries * sizeof(FAR uint8_t *));
+      if (newpages == NULL)
+        {
+          return -ENOMEM;
+        }
+
+      memset(&newpages[tfo->tfo_npages], 0,
+             (nentries - tfo->tfo_npages) * sizeof(FAR uint8_t *));
+
+      tfo->tfo_alloc += (nentries - tfo->tfo_npages) *
+                        sizeof(FAR uint8_t *);
+      tfo->tfo_npages = nentries;
+      tfo->tfo_pages  = newpages;
+    }
+
+  tfo->tfo_size = newsize;
+  return OK;
+}
+#else
 /****************************************************************************
  * Name: tmpfs_realloc_file
  ****************************************************************************/
@@ -345,6 +675,7 @@ static int tmpfs_realloc_file(FAR struct tmpfs_file_s *tfo,
   tfo->tfo_data  = newdata;
   return OK;
 }
+#endif
 
 /****************************************************************************
  * Name: tmpfs_release_lockedobject
@@ -383,7 +714,7 @@ static void tmpfs_release_lockedfile(FAR struct tmpfs_file_s *tfo)
     {
       tmpfs_unlock_file(tfo);
       nxrmutex_destroy(&tfo->tfo_lock);
-      fs_heap_free(tfo->tfo_data);
+      tmpfs_free_data(tfo);
       fs_heap_free(tfo);
     }
 
@@ -582,7 +913,12 @@ tmpfs_alloc_file(FAR struct tmpfs_directory_s *parent)
   tfo->tfo_parent = parent;
   tfo->tfo_flags  = 0;
   tfo->tfo_size   = 0;
+#ifdef CONFIG_FS_TMPFS_PAGED
+  tfo->tfo_npages = 0;
+  tfo->tfo_pages  = NULL;
+#else
   tfo->tfo_data   = NULL;
+#endif
 
   nxrmutex_init(&tfo->tfo_lock);
   tmpfs_lock_file(tfo);
@@ -1184,12 +1520,17 @@ static int tmpfs_statfs_callout(FAR struct tmpfs_directory_s *tdo,
       FAR struct tmpfs_file_s *tmptfo;
 
       /* It is a file object.  Increment the number of files and update the
-       * amount of memory in use.
+       * amount of memory in use.  Paged files have no private slack, free
+       * pages are accounted for by the pool.
        */
 
       tmptfo             = (FAR struct tmpfs_file_s *)to;
       tmpbuf->tsf_alloc += sizeof(struct tmpfs_file_s);
+#ifndef CONFIG_FS_TMPFS_PAGED
       tmpbuf->tsf_avail += to->to_alloc - tmptfo->tfo_size;
+#else
+      UNUSED(tmptfo);
+#endif
       tmpbuf->tsf_files++;
     }
   else /* if (to->to_type == TMPFS_DIRECTORY) */
@@ -1265,7 +1606,7 @@ static int tmpfs_free_callout(FAR struct tmpfs_directory_s *tdo,
           return TMPFS_UNLINKED;
         }
 
-      fs_heap_free(tfo->tfo_data);
+      tmpfs_free_data(tfo);
     }
   else /* if (to->to_type == TMPFS_DIRECTORY) */
     {
@@ -1586,6 +1927,10 @@ static ssize_t tmpfs_read(FAR struct file *filep, FAR char *buffer,
 
   /* Copy data from the memory object to the user buffer */
 
+#ifdef CONFIG_FS_TMPFS_PAGED
+  tmpfs_read_pages(tfo, buffer, startpos, nread);
+  filep->f_pos += nread;
+#else
   if (tfo->tfo_data != NULL)
     {
       memcpy(buffer, &tfo->tfo_data[startpos], nread);
@@ -1595,6 +1940,7 @@ static ssize_t tmpfs_read(FAR struct file *filep, FAR char *buffer,
     {
       DEBUGASSERT(tfo->tfo_size == 0 && nread == 0);
     }
+#endif
 
   /* Release the lock on the file */
 
@@ -1611,6 +1957,9 @@ static ssize_t tmpfs_write(FAR struct file *filep, FAR const char *buffer,
 {
   FAR struct tmpfs_file_s *tfo;
   ssize_t nwritten;
+#ifdef CONFIG_FS_TMPFS_PAGED
+  size_t oldsize;
+#endif
   off_t startpos;
   off_t endpos;
   int ret;
@@ -1644,6 +1993,9 @@ static ssize_t tmpfs_write(FAR struct file *filep, FAR const char *buffer,
 
   nwritten = buflen;
   endpos   = startpos + buflen;
+#ifdef CONFIG_FS_TMPFS_PAGED
+  oldsize  = tfo->tfo_size;
+#endif
 
   if (endpos > tfo->tfo_size)
     {
@@ -1658,6 +2010,30 @@ static ssize_t tmpfs_write(FAR struct file *filep, FAR const char *buffer,
 
   /* Copy data from the memory object to the user buffer */
 
+#ifdef CONFIG_FS_TMPFS_PAGED
+  nwritten = tmpfs_write_pages(tfo, buffer, startpos, buflen);
+  if (nwritten < (ssize_t)buflen)
+    {
+      /* The page pool is exhausted.  Only keep the part of the extension
+       * that was actually written.
+       */
+
+      endpos = nwritten > 0 ? startpos + nwritten : oldsize;
+      if (endpos < oldsize)
+        {
+          endpos = oldsize;
+        }
+
+      tmpfs_realloc_file(tfo, (size_t)endpos);
+      if (nwritten < 0)
+        {
+          ret = nwritten;
+          goto errout_with_lock;
+        }
+
+      endpos = startpos + nwritten;
+    }
+#else
   if (tfo->tfo_data != NULL)
     {
       memcpy(&tfo->tfo_data[startpos], buffer, nwritten);
@@ -1666,6 +2042,7 @@ static ssize_t tmpfs_write(FAR struct file *filep, FAR const char *buffer,
     {
       DEBUGASSERT(tfo->tfo_size == 0 && nwritten == 0);
     }
+#endif
 
   filep->f_pos = endpos;
 
@@ -1788,7 +2165,36 @@ static int tmpfs_mmap(FAR struct file *filep, FAR struct mm_map_entry_s *map)
   if (map->offset >= 0 && map->offset < tfo->tfo_size &&
       map->length && map->offset + map->length <= tfo->tfo_size)
     {
+#ifdef CONFIG_FS_TMPFS_PAGED
+      FAR uint8_t *page;
+
+      /* Only a range within one page is contiguous and can be mapped in
+       * place.  Let mmap() fall back to a copy for anything larger.
+       */
+
+      if (TMPFS_PAGE(map->offset) !=
+          TMPFS_PAGE(map->offset + map->length - 1))
+        {
+          return -ENOTTY;
+        }
+
+      ret = tmpfs_lock_file(tfo);
+      if (ret < 0)
+        {
+          return ret;
+        }
+
+      page = tmpfs_alloc_page(tfo, TMPFS_PAGE(map->offset));
+      tmpfs_unlock_file(tfo);
+      if (page == NULL)
+        {
+          return -ENOMEM;
+        }
+
+      map->vaddr = page + TMPFS_PAGEOFF(map->offset);
+#else
       map->vaddr = tfo->tfo_data + map->offset;
+#endif
       map->priv.p = tfo;
       map->munmap = tmpfs_unmap;
       ret = mm_map_add(get_current_mm(), map);
@@ -1838,12 +2244,43 @@ static int tmpfs_ioctl(FAR struct file *filep, int cmd, unsigned long arg)
           return ret;
         }
     }
-  else if (cmd == FIOC_XIPBASE)
+  else if (cmd == FIOC_XIPBASE || cmd == FIOC_XIPFIXED)
     {
       FAR uintptr_t *ptr = (FAR uintptr_t *)arg;
 
+#ifdef CONFIG_FS_TMPFS_PAGED
+      /* The file is only contiguous if it fits within the first page */
+
+      if (tfo->tfo_size > CONFIG_FS_TMPFS_PAGE_SIZE)
+        {
+          return -ENOTTY;
+        }
+
+      ret = tmpfs_lock_file(tfo);
+      if (ret < 0)
+        {
+          return ret;
+        }
+
+      *ptr = 0;
+      if (tfo->tfo_size > 0)
+        {
+          *ptr = (uintptr_t)tmpfs_alloc_page(tfo, 0);
+        }
+
+      tmpfs_unlock_file(tfo);
+      return tfo->tfo_size > 0 && *ptr == 0 ? -ENOMEM : OK;
+#else
+      /* The data moves whenever the file grows */
+
+      if (cmd == FIOC_XIPFIXED)
+        {
+          return -ENOTTY;
+        }
+
       *ptr = (uintptr_t)tfo->tfo_data;
       return OK;
+#endif
     }
 
   return ret;
@@ -1976,14 +2413,17 @@ static int tmpfs_truncate(FAR struct file *filep, off_t length)
           goto errout_with_lock;
         }
 
+#ifndef CONFIG_FS_TMPFS_PAGED
       /* If the size has increased, then we need to zero the newly added
-       * memory.
+       * memory.  Pages are zero beyond the end of file and new regions
+       * are holes, so there is nothing to do with paged storage.
        */
 
       if (length > oldsize)
         {
           memset(&tfo->tfo_data[oldsize], 0, length - oldsize);
         }
+#endif
 
       ret = OK;
     }
@@ -2192,10 +2632,23 @@ static int tmpfs_bind(FAR struct inode *blkdriver, FAR const void *data,
 {
   FAR struct tmpfs_directory_s *tdo;
   FAR struct tmpfs_s *fs;
+#ifdef CONFIG_FS_TMPFS_PAGED
+  int ret;
+#endif
 
   finfo("blkdriver: %p data: %p handle: %p\n", blkdriver, data, handle);
   DEBUGASSERT(blkdriver == NULL && handle != NULL);
 
+#ifdef CONFIG_FS_TMPFS_PAGED
+  /* Make sure that the file data page pool is ready */
+
+  ret = tmpfs_initialize_pool();
+  if (ret < 0)
+    {
+      return ret;
+    }
+#endif
+
   /* Create an instance of the tmpfs file system */
 
   fs = fs_heap_zalloc(sizeof(struct tmpfs_s));
@@ -2276,6 +2729,9 @@ static int tmpfs_statfs(FAR struct inode *mountpt, FAR struct statfs *buf)
   FAR struct tmpfs_s *fs;
   FAR struct tmpfs_directory_s *tdo;
   struct tmpfs_statfs_s tmpbuf;
+#ifdef CONFIG_FS_TMPFS_PAGED
+  struct mempoolinfo_s info;
+#endif
   size_t avail;
   off_t blkalloc;
   off_t blkavail;
@@ -2318,16 +2774,25 @@ static int tmpfs_statfs(FAR struct inode *mountpt, FAR struct statfs *buf)
       return -ECANCELED;
     }
 
+#ifdef CONFIG_FS_TMPFS_PAGED
+  /* Pages that are free in the shared pool are available to any file */
+
+  if (mempool_info(&g_tmpfs_pagepool, &info) >= 0)
+    {
+      tmpbuf.tsf_avail += info.ordblks * CONFIG_FS_TMPFS_PAGE_SIZE;
+    }
+#endif
+
   /* Return something for the file system description */
 
-  blkalloc        = (tmpbuf.tsf_alloc + CONFIG_FS_TMPFS_BLOCKSIZE - 1) /
-                     CONFIG_FS_TMPFS_BLOCKSIZE;
-  blkavail        = (tmpbuf.tsf_avail + CONFIG_FS_TMPFS_BLOCKSIZE - 1) /
-                     CONFIG_FS_TMPFS_BLOCKSIZE;
+  blkalloc        = (tmpbuf.tsf_alloc + TMPFS_BLOCKSIZE - 1) /
+                     TMPFS_BLOCKSIZE;
+  blkavail        = (tmpbuf.tsf_avail + TMPFS_BLOCKSIZE - 1) /
+                     TMPFS_BLOCKSIZE;
 
   buf->f_type     = TMPFS_MAGIC;
   buf->f_namelen  = NAME_MAX;
-  buf->f_bsize    = CONFIG_FS_TMPFS_BLOCKSIZE;
+  buf->f_bsize    = TMPFS_BLOCKSIZE;
   buf->f_blocks   = blkalloc;
   buf->f_bfree    = blkavail;
   buf->f_bavail   = blkavail;
@@ -2426,7 +2891,7 @@ static int tmpfs_unlink(FAR struct inode *mountpt, FAR const char *relpath)
   else
     {
       nxrmutex_destroy(&tfo->tfo_lock);
-      fs_heap_free(tfo->tfo_data);
+      tmpfs_free_data(tfo);
       fs_heap_free(tfo);
     }
 
@@ -2789,9 +3254,27 @@ static void tmpfs_stat_common(FAR struct tmpfs_object_s *to,
   /* Fake the rest of the information */
 
   buf->st_size    = objsize;
-  buf->st_blksize = CONFIG_FS_TMPFS_BLOCKSIZE;
-  buf->st_blocks  = (objsize + CONFIG_FS_TMPFS_BLOCKSIZE - 1) /
-                    CONFIG_FS_TMPFS_BLOCKSIZE;
+  buf->st_blksize = TMPFS_BLOCKSIZE;
+  buf->st_blocks  = (objsize + TMPFS_BLOCKSIZE - 1) / TMPFS_BLOCKSIZE;
+
+#ifdef CONFIG_FS_TMPFS_PAGED
+  if (to->to_type == TMPFS_REGULAR)
+    {
+      FAR struct tmpfs_file_s *tfo = (FAR struct tmpfs_file_s *)to;
+      size_t i;
+
+      /* Holes in a sparse file occupy no pages */
+
+      buf->st_blocks = 0;
+      for (i = 0; i < TMPFS_NPAGES(objsize); i++)
+        {
+          if (tfo->tfo_pages[i] != NULL)
+            {
+              buf->st_blocks++;
+            }
+        }
+    }
+#endif
 }
 
 /****************************************************************************
@@ -126,9 +126,14 @@ struct tmpfs_file_s
 
   /* Remaining fields are unique to a directory object */
 
-  uint8_t       tfo_flags; /* See TFO_FLAG_* definitions */
-  size_t        tfo_size;  /* Valid file size */
-  FAR uint8_t  *tfo_data;  /* File data starts here */
+  uint8_t       tfo_flags;  /* See TFO_FLAG_* definitions */
+  size_t        tfo_size;   /* Valid file size */
+#ifdef CONFIG_FS_TMPFS_PAGED
+  size_t        tfo_npages; /* Number of entries in the page table */
+  FAR uint8_t **tfo_pages;  /* Page table, NULL entries are holes */
+#else
+  FAR uint8_t  *tfo_data;   /* File data starts here */
+#endif
 };
 
 /* This structure represents one instance of a TMPFS file system */
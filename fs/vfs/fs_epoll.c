@@ -42,6 +42,7 @@
 #include <nuttx/list.h>
 #include <nuttx/mutex.h>
 #include <nuttx/signal.h>
+#include <nuttx/spinlock.h>
 
 #include "inode/inode.h"
 #include "fs_heap.h"
@@ -53,8 +54,10 @@
 struct epoll_node_s
 {
   struct list_node         node;
+  struct list_node         rnode;     /* Link in the ready list */
   epoll_data_t             data;
-  bool                     notified;
+  bool                     notified;  /* On the ready list */
+  pollevent_t              revents;   /* Events taken by the poll callback */
   struct pollfd            pfd;
   FAR struct file         *filep;
   FAR struct epoll_head_s *eph;
@@ -68,6 +71,11 @@ struct epoll_head_s
   int                   crefs;
   mutex_t               lock;
   sem_t                 sem;
+  spinlock_t            rlock;    /* Protects the ready list */
+  struct list_node      ready;    /* The ready list, store the setuped epoll
+                                   * node notified by the poll callback, so
+                                   * epoll_wait only visit these nodes.
+                                   */
   struct list_node      setup;    /* The setup list, store all the setuped
                                    * epoll node.
                                    */
@@ -239,11 +247,13 @@ static int epoll_do_create(int size, int flags)
   eph->size = size;
   nxmutex_init(&eph->lock);
   nxsem_init(&eph->sem, 0, 0);
+  spin_lock_init(&eph->rlock);
 
   /* List initialize */
 
   epn = (FAR epoll_node_t *)(eph + 1);
 
+  list_initialize(&eph->ready);
   list_initialize(&eph->setup);
   list_initialize(&eph->teardown);
   list_initialize(&eph->oneshot);
@@ -303,6 +313,7 @@ static int epoll_setup(FAR epoll_head_t *eph)
        */
 
       epn->notified    = false;
+      epn->revents     = 0;
       epn->pfd.revents = 0;
       ret = file_poll(epn->filep, &epn->pfd, true);
       if (ret < 0)
@@ -320,12 +331,49 @@ static int epoll_setup(FAR epoll_head_t *eph)
   return ret;
 }
 
+/****************************************************************************
+ * Name: epoll_unready
+ *
+ * Description:
+ *   Remove the epoll node from the ready list.  The node must be torn down
+ *   or the caller must hold the epoll lock, so that it is not handed to
+ *   epoll_teardown concurrently.
+ *
+ * Input Parameters:
+ *   eph       - The epoll head pointer
+ *   epn       - The epoll node
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+static void epoll_unready(FAR epoll_head_t *eph, FAR epoll_node_t *epn)
+{
+  irqstate_t flags;
+
+  flags = spin_lock_irqsave(&eph->rlock);
+  if (epn->notified)
+    {
+      list_delete(&epn->rnode);
+      epn->notified = false;
+    }
+
+  spin_unlock_irqrestore(&eph->rlock, flags);
+}
+
 /****************************************************************************
  * Name: epoll_teardown
  *
  * Description:
- *   Teardown all the notified fd and check the notified fd's event with user
- *   expected event.
+ *   Take the notified fd from the ready list and check the notified fd's
+ *   event with user expected event.  Only the ready nodes are visited, so
+ *   the cost does not depend on the number of idle fd.
+ *
+ *   A level-triggered fd is torn down and setup again by the next
+ *   epoll_wait, which reports it again if the event is still pending.  An
+ *   edge-triggered fd stays setup and is only reported again when the
+ *   driver notifies a new event.
  *
  * Input Parameters:
  *   eph       - The epoll head pointer
@@ -341,45 +389,74 @@ static int epoll_setup(FAR epoll_head_t *eph)
 static int epoll_teardown(FAR epoll_head_t *eph, FAR struct epoll_event *evs,
                           int maxevents)
 {
-  FAR epoll_node_t *tepn;
   FAR epoll_node_t *epn;
+  pollevent_t revents;
+  irqstate_t flags;
   int i = 0;
 
   nxmutex_lock(&eph->lock);
 
-  list_for_every_entry_safe(&eph->setup, epn, tepn, epoll_node_t, node)
+  while (i < maxevents)
     {
-      /* Only check the notified fd */
-
-      if (!epn->notified)
+      flags = spin_lock_irqsave(&eph->rlock);
+      if (list_is_empty(&eph->ready))
         {
-          continue;
+          spin_unlock_irqrestore(&eph->rlock, flags);
+          break;
         }
 
-      /* Teradown all the notified fd */
+      epn = container_of(list_remove_head(&eph->ready), epoll_node_t,
+                         rnode);
+      epn->notified = false;
 
-      file_poll(epn->filep, &epn->pfd, false);
-      list_delete(&epn->node);
+      /* Consume the events, for an edge-triggered fd the next notification
+       * adds them back.
+       */
+
+      revents       = epn->revents;
+      epn->revents  = 0;
 
-      if (epn->pfd.revents != 0 && i < maxevents)
+      spin_unlock_irqrestore(&eph->rlock, flags);
+
+      if (revents != 0)
         {
           evs[i].data     = epn->data;
-          evs[i++].events = epn->pfd.revents;
-          if ((epn->pfd.events & EPOLLONESHOT) != 0)
-            {
-              list_add_tail(&eph->oneshot, &epn->node);
-            }
-          else
-            {
-              list_add_tail(&eph->teardown, &epn->node);
-            }
+          evs[i++].events = revents;
         }
-      else
+
+      if (revents != 0 && (epn->pfd.events & EPOLLONESHOT) != 0)
         {
+          file_poll(epn->filep, &epn->pfd, false);
+          epoll_unready(eph, epn);
+          list_delete(&epn->node);
+          list_add_tail(&eph->oneshot, &epn->node);
+        }
+      else if ((epn->pfd.events & EPOLLET) == 0)
+        {
+          /* Teardown the notified fd */
+
+          file_poll(epn->filep, &epn->pfd, false);
+          epoll_unready(eph, epn);
+          list_delete(&epn->node);
           list_add_tail(&eph->teardown, &epn->node);
         }
     }
 
+  /* Some nodes are left on the ready list when evs is full, make sure the
+   * next epoll_wait doesn't block on them.
+   */
+
+  if (!list_is_empty(&eph->ready))
+    {
+      int semcount = 0;
+
+      nxsem_get_value(&eph->sem, &semcount);
+      if (semcount < 1)
+        {
+          nxsem_post(&eph->sem);
+        }
+    }
+
   nxmutex_unlock(&eph->lock);
   return i;
 }
@@ -402,10 +479,34 @@ static int epoll_teardown(FAR epoll_head_t *eph, FAR struct epoll_event *evs,
 static void epoll_default_cb(FAR struct pollfd *fds)
 {
   FAR epoll_node_t *epn = fds->arg;
+  FAR epoll_head_t *eph = epn->eph;
+  pollevent_t revents;
+  irqstate_t flags;
   int semcount = 0;
 
-  epn->notified = true;
-  if (fds->revents != 0)
+  /* Move the events out of the pollfd under the ready list lock, so that
+   * epoll_teardown never clears an event that poll_notify() sets
+   * concurrently on another CPU.
+   */
+
+  flags = spin_lock_irqsave(&eph->rlock);
+  revents       = fds->revents;
+  fds->revents  = 0;
+  epn->revents |= revents;
+  if ((revents & (POLLERR | POLLHUP)) != 0)
+    {
+      epn->revents &= ~POLLOUT;
+    }
+
+  if (!epn->notified)
+    {
+      epn->notified = true;
+      list_add_tail(&eph->ready, &epn->rnode);
+    }
+
+  spin_unlock_irqrestore(&eph->rlock, flags);
+
+  if (revents != 0)
     {
       nxsem_get_value(&epn->eph->sem, &semcount);
       if (semcount < 1)
@@ -562,6 +663,7 @@ int epoll_ctl(int epfd, int op, int fd, FAR struct epoll_event *ev)
         epn->eph         = eph;
         epn->data        = ev->data;
         epn->notified    = false;
+        epn->revents     = 0;
         epn->pfd.events  = ev->events | POLLALWAYS;
         epn->pfd.fd      = fd;
         epn->pfd.arg     = epn;
@@ -593,6 +695,7 @@ int epoll_ctl(int epfd, int op, int fd, FAR struct epoll_event *ev)
             if (epn->pfd.fd == fd)
               {
                 file_poll(epn->filep, &epn->pfd, false);
+                epoll_unready(eph, epn);
                 file_put(epn->filep);
                 list_delete(&epn->node);
                 list_add_tail(&eph->free, &epn->node);
@@ -633,9 +736,10 @@ int epoll_ctl(int epfd, int op, int fd, FAR struct epoll_event *ev)
                 if (epn->pfd.events != (ev->events | POLLALWAYS))
                   {
                     file_poll(epn->filep, &epn->pfd, false);
+                    epoll_unready(eph, epn);
 
-                    epn->notified    = false;
                     epn->data        = ev->data;
+                    epn->revents     = 0;
                     epn->pfd.events  = ev->events | POLLALWAYS;
                     epn->pfd.revents = 0;
 
@@ -658,6 +762,7 @@ int epoll_ctl(int epfd, int op, int fd, FAR struct epoll_event *ev)
                   {
                     epn->notified    = false;
                     epn->data        = ev->data;
+                    epn->revents     = 0;
                     epn->pfd.events  = ev->events | POLLALWAYS;
                     epn->pfd.revents = 0;
 
@@ -681,6 +786,7 @@ int epoll_ctl(int epfd, int op, int fd, FAR struct epoll_event *ev)
               {
                 epn->notified    = false;
                 epn->data        = ev->data;
+                epn->revents     = 0;
                 epn->pfd.events  = ev->events | POLLALWAYS;
                 epn->pfd.revents = 0;
 
@@ -204,6 +204,12 @@ ssize_t file_readv(FAR struct file *filep,
    * signature and position in the operations vtable.
    */
 
+#ifdef CONFIG_FS_READAHEAD
+  else if (iovcnt == 1 && file_readahead_check(filep))
+    {
+      ret = file_readahead_read(filep, iov[0].iov_base, iov[0].iov_len);
+    }
+#endif
   else if (inode != NULL && inode->u.i_ops)
     {
       if (inode->u.i_ops->readv)
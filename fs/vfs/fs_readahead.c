@@ -0,0 +1,461 @@
+/****************************************************************************
+ * fs/vfs/fs_readahead.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/param.h>
+#include <sys/types.h>
+#include <stdbool.h>
+#include <string.h>
+#include <fcntl.h>
+#include <errno.h>
+
+#include <nuttx/kmalloc.h>
+#include <nuttx/list.h>
+#include <nuttx/mutex.h>
+#include <nuttx/semaphore.h>
+#include <nuttx/wqueue.h>
+
+#include "inode/inode.h"
+#include "vfs.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define READAHEAD_MINSIZE CONFIG_FS_READAHEAD_MINSIZE
+#define READAHEAD_MAXSIZE CONFIG_FS_READAHEAD_MAXSIZE
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+struct file_rabuf_s
+{
+  off_t        pos;             /* File offset of data[0] */
+  size_t       len;             /* Number of valid bytes in data[] */
+  FAR uint8_t *data;            /* READAHEAD_MAXSIZE bytes */
+};
+
+/* The read-ahead state of one open file.  buf[cur] holds data ready to be
+ * consumed while buf[cur ^ 1] is filled by the work queue through a
+ * private open file, so the file system sees two independent streams.
+ */
+
+struct file_readahead_s
+{
+  struct list_node    node;     /* Link in g_readahead_list */
+  mutex_t             lock;     /* Serializes the readers of the file */
+  sem_t               done;     /* Posted when the worker completes */
+  struct work_s       work;     /* Read-ahead work */
+  struct file         file;     /* Private open file used by the worker */
+  struct file_rabuf_s buf[2];   /* Ready and in-flight buffers */
+  uint8_t             cur;      /* Index of the ready buffer */
+  bool                pending;  /* buf[cur ^ 1] is being filled */
+  size_t              request;  /* Size requested for buf[cur ^ 1] */
+  off_t               next;     /* Offset of the next sequential read */
+  off_t               eof;      /* End of file seen by the worker or -1 */
+  size_t              window;   /* Read-ahead window, zero if random */
+  volatile bool       stale;    /* The file system was written to */
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static mutex_t g_readahead_lock = NXMUTEX_INITIALIZER;
+
+/* All the read-ahead states, so that writers can invalidate them */
+
+static struct list_node g_readahead_list =
+  LIST_INITIAL_VALUE(g_readahead_list);
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: readahead_worker
+ ****************************************************************************/
+
+static void readahead_worker(FAR void *arg)
+{
+  FAR struct file_readahead_s *ra = arg;
+  FAR struct file_rabuf_s *buf = &ra->buf[ra->cur ^ 1];
+  FAR struct inode *inode = ra->file.f_inode;
+  ssize_t nread;
+
+  ra->file.f_pos = buf->pos;
+  nread = inode->u.i_ops->read(&ra->file, (FAR char *)buf->data,
+                               ra->request);
+
+  /* Errors are left for the synchronous read to report */
+
+  buf->len = nread > 0 ? nread : 0;
+  nxsem_post(&ra->done);
+}
+
+/****************************************************************************
+ * Name: readahead_complete
+ *
+ * Description:
+ *   Make the buffer filled by the worker the ready one.  The done
+ *   semaphore must have been taken.
+ *
+ ****************************************************************************/
+
+static void readahead_complete(FAR struct file_readahead_s *ra)
+{
+  FAR struct file_rabuf_s *buf = &ra->buf[ra->cur ^ 1];
+
+  if (buf->len < ra->request)
+    {
+      ra->eof = buf->pos + buf->len;
+    }
+
+  ra->pending = false;
+  ra->cur    ^= 1;
+}
+
+/****************************************************************************
+ * Name: readahead_drop
+ *
+ * Description:
+ *   Discard the data read ahead, after a write to the file system may have
+ *   made it stale.
+ *
+ ****************************************************************************/
+
+static void readahead_drop(FAR struct file_readahead_s *ra)
+{
+  ra->stale = false;
+
+  if (ra->pending)
+    {
+      nxsem_wait_uninterruptible(&ra->done);
+      ra->pending = false;
+    }
+
+  ra->buf[0].len = 0;
+  ra->buf[1].len = 0;
+  ra->eof        = -1;
+}
+
+/****************************************************************************
+ * Name: readahead_start
+ *
+ * Description:
+ *   Queue the read-ahead of the next window after pos, unless one is
+ *   already in flight.
+ *
+ ****************************************************************************/
+
+static void readahead_start(FAR struct file_readahead_s *ra, off_t pos)
+{
+  FAR struct file_rabuf_s *ready = &ra->buf[ra->cur];
+  FAR struct file_rabuf_s *spare = &ra->buf[ra->cur ^ 1];
+
+  if (ra->pending)
+    {
+      if (nxsem_trywait(&ra->done) < 0)
+        {
+          return;
+        }
+
+      readahead_complete(ra);
+      ready = &ra->buf[ra->cur];
+      spare = &ra->buf[ra->cur ^ 1];
+    }
+
+  /* If the reader is still consuming the ready buffer, continue after
+   * it.
+   */
+
+  if (pos >= ready->pos && pos < ready->pos + (off_t)ready->len)
+    {
+      pos = ready->pos + ready->len;
+    }
+
+  if (ra->eof >= 0 && pos >= ra->eof)
+    {
+      return;
+    }
+
+  if (spare->data == NULL)
+    {
+      spare->data = kmm_malloc(READAHEAD_MAXSIZE);
+      if (spare->data == NULL)
+        {
+          return;
+        }
+    }
+
+  spare->pos  = pos;
+  spare->len  = 0;
+  ra->request = ra->window;
+  ra->pending = true;
+
+  if (work_queue(LPWORK, &ra->work, readahead_worker, ra, 0) < 0)
+    {
+      ra->pending = false;
+      return;
+    }
+
+  /* Grow the window while the stream stays sequential */
+
+  ra->window = MIN(ra->window * 2, READAHEAD_MAXSIZE);
+}
+
+/****************************************************************************
+ * Name: readahead_get
+ *
+ * Description:
+ *   Return the read-ahead state of the file, creating it on first use.
+ *
+ ****************************************************************************/
+
+static FAR struct file_readahead_s *readahead_get(FAR struct file *filep)
+{
+  FAR struct file_readahead_s *ra = filep->f_readahead;
+
+  if (ra != NULL)
+    {
+      return ra;
+    }
+
+  if (nxmutex_lock(&g_readahead_lock) < 0)
+    {
+      return NULL;
+    }
+
+  ra = filep->f_readahead;
+  if (ra == NULL)
+    {
+      ra = kmm_zalloc(sizeof(struct file_readahead_s));
+      if (ra != NULL && file_dup2(filep, &ra->file) < 0)
+        {
+          kmm_free(ra);
+          ra = NULL;
+        }
+
+      if (ra != NULL)
+        {
+          nxmutex_init(&ra->lock);
+          nxsem_init(&ra->done, 0, 0);
+          ra->next = -1;
+          ra->eof  = -1;
+          list_add_tail(&g_readahead_list, &ra->node);
+          filep->f_readahead = ra;
+        }
+    }
+
+  nxmutex_unlock(&g_readahead_lock);
+  return ra;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: file_readahead_check
+ ****************************************************************************/
+
+bool file_readahead_check(FAR struct file *filep)
+{
+  FAR struct inode *inode = filep->f_inode;
+
+  /* Only regular files opened read-only can be read ahead, and the file
+   * system must be able to open a second stream on the same file.
+   */
+
+  return inode != NULL && INODE_IS_MOUNTPT(inode) &&
+         (filep->f_oflags & (O_WROK | O_DIRECT)) == 0 &&
+         inode->u.i_mops->read != NULL && inode->u.i_mops->dup != NULL;
+}
+
+/****************************************************************************
+ * Name: file_readahead_read
+ ****************************************************************************/
+
+ssize_t file_readahead_read(FAR struct file *filep, FAR void *buf,
+                            size_t nbytes)
+{
+  FAR struct inode *inode = filep->f_inode;
+  FAR struct file_readahead_s *ra;
+  FAR uint8_t *dest = buf;
+  ssize_t nread = 0;
+  ssize_t ret;
+  off_t pos;
+
+  ra = readahead_get(filep);
+  if (ra == NULL)
+    {
+      return inode->u.i_ops->read(filep, buf, nbytes);
+    }
+
+  ret = nxmutex_lock(&ra->lock);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  if (ra->stale)
+    {
+      readahead_drop(ra);
+    }
+
+  /* A read that does not continue the previous one ends the stream */
+
+  pos = filep->f_pos;
+  if (pos != ra->next)
+    {
+      ra->window = 0;
+      ra->eof    = -1;
+    }
+  else if (ra->window == 0)
+    {
+      ra->window = READAHEAD_MINSIZE;
+    }
+
+  /* Copy what the read-ahead has already fetched */
+
+  while (nbytes > 0)
+    {
+      FAR struct file_rabuf_s *ready = &ra->buf[ra->cur];
+      FAR struct file_rabuf_s *spare = &ra->buf[ra->cur ^ 1];
+      size_t n;
+
+      if (pos >= ready->pos && pos < ready->pos + (off_t)ready->len)
+        {
+          n = MIN(nbytes, ready->pos + ready->len - pos);
+          memcpy(dest, ready->data + (pos - ready->pos), n);
+
+          dest   += n;
+          pos    += n;
+          nbytes -= n;
+          nread  += n;
+        }
+      else if (ra->pending && pos >= spare->pos &&
+               pos < spare->pos + (off_t)ra->request)
+        {
+          nxsem_wait_uninterruptible(&ra->done);
+          readahead_complete(ra);
+        }
+      else
+        {
+          break;
+        }
+    }
+
+  /* Read the rest from the file system.  The file systems resynchronize
+   * their stream with f_pos on every read.
+   */
+
+  filep->f_pos = pos;
+  if (nbytes > 0)
+    {
+      ret = inode->u.i_ops->read(filep, (FAR char *)dest, nbytes);
+      if (ret >= 0)
+        {
+          nread += ret;
+        }
+      else if (nread == 0)
+        {
+          nread = ret;
+        }
+    }
+
+  ra->next = filep->f_pos;
+  if (ra->window > 0)
+    {
+      readahead_start(ra, ra->next);
+    }
+
+  nxmutex_unlock(&ra->lock);
+  return nread;
+}
+
+/****************************************************************************
+ * Name: file_readahead_close
+ ****************************************************************************/
+
+void file_readahead_close(FAR struct file *filep)
+{
+  FAR struct file_readahead_s *ra = filep->f_readahead;
+
+  if (ra == NULL)
+    {
+      return;
+    }
+
+  filep->f_readahead = NULL;
+
+  nxmutex_lock(&g_readahead_lock);
+  list_delete(&ra->node);
+  nxmutex_unlock(&g_readahead_lock);
+
+  if (ra->pending)
+    {
+      nxsem_wait_uninterruptible(&ra->done);
+    }
+
+  file_close(&ra->file);
+
+  kmm_free(ra->buf[0].data);
+  kmm_free(ra->buf[1].data);
+  nxsem_destroy(&ra->done);
+  nxmutex_destroy(&ra->lock);
+  kmm_free(ra);
+}
+
+/****************************************************************************
+ * Name: file_readahead_invalidate
+ ****************************************************************************/
+
+void file_readahead_invalidate(FAR struct file *filep)
+{
+  FAR struct inode *inode = filep->f_inode;
+  FAR struct file_readahead_s *ra;
+
+  if (inode == NULL || !INODE_IS_MOUNTPT(inode) ||
+      list_is_empty(&g_readahead_list))
+    {
+      return;
+    }
+
+  nxmutex_lock(&g_readahead_lock);
+
+  list_for_every_entry(&g_readahead_list, ra, struct file_readahead_s, node)
+    {
+      if (ra->file.f_inode == inode)
+        {
+          ra->stale = true;
+        }
+    }
+
+  nxmutex_unlock(&g_readahead_lock);
+}
@@ -70,6 +70,7 @@ static int pseudorename(FAR const char *oldpath, FAR struct inode *oldinode,
 {
   struct inode_search_s newdesc;
   FAR struct inode *newinode;
+  FAR struct inode *child;
   FAR char *subdir = NULL;
 #ifdef CONFIG_FS_NOTIFY
   bool isdir = INODE_IS_PSEUDODIR(oldinode);
@@ -219,6 +220,14 @@ static int pseudorename(FAR const char *oldpath, FAR struct inode *oldinode,
       goto errout_with_lock;
     }
 
+  /* Move the children below the new inode */
+
+  for (child = newinode->i_child; child != NULL; child = child->i_peer)
+    {
+      child->i_parent = newinode;
+      inode_hash_add_tree(child);
+    }
+
   /* Remove all of the children from the unlinked inode */
 
   oldinode->i_child  = NULL;
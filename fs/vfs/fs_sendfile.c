@@ -27,11 +27,13 @@
 #include <nuttx/config.h>
 
 #include <sys/sendfile.h>
+#include <sys/stat.h>
 #include <stdbool.h>
 #include <errno.h>
 #include <debug.h>
 
 #include <nuttx/fs/fs.h>
+#include <nuttx/fs/ioctl.h>
 #include <nuttx/kmalloc.h>
 #include <nuttx/net/net.h>
 #include "fs_heap.h"
@@ -40,6 +42,93 @@
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: copyfile_inplace
+ *
+ * Description:
+ *   Write directly from the memory of an input file that can be accessed
+ *   in place, skipping the intermediate buffer.  Only memory that stays in
+ *   place while the file is open is used (see FIOC_XIPFIXED), since
+ *   another writer may grow the file while the output write blocks.
+ *
+ * Returned Value:
+ *   The number of bytes transferred, a negated errno value on failure, or
+ *   -ENOSYS if the input file cannot be accessed in place.
+ *
+ ****************************************************************************/
+
+static ssize_t copyfile_inplace(FAR struct file *outfile,
+                                FAR struct file *infile, size_t count)
+{
+  FAR const uint8_t *base;
+  struct stat buf;
+  uintptr_t xipbase = 0;
+  ssize_t nbyteswritten;
+  size_t ntransferred = 0;
+  off_t pos;
+
+  /* Writing a file into itself could move the memory being read */
+
+  if (outfile->f_inode == infile->f_inode &&
+      outfile->f_priv == infile->f_priv)
+    {
+      return -ENOSYS;
+    }
+
+  if (file_ioctl(infile, FIOC_XIPFIXED,
+                 (unsigned long)((uintptr_t)&xipbase)) < 0 ||
+      xipbase == 0 || file_fstat(infile, &buf) < 0)
+    {
+      return -ENOSYS;
+    }
+
+  pos = file_seek(infile, 0, SEEK_CUR);
+  if (pos < 0)
+    {
+      return pos;
+    }
+
+  if (pos >= buf.st_size)
+    {
+      return 0;
+    }
+
+  if (count > (size_t)(buf.st_size - pos))
+    {
+      count = buf.st_size - pos;
+    }
+
+  base = (FAR const uint8_t *)xipbase + pos;
+  while (ntransferred < count)
+    {
+      nbyteswritten = file_write(outfile, base + ntransferred,
+                                 count - ntransferred);
+      if (nbyteswritten < 0)
+        {
+          /* EINTR is not an error if some data has been transferred */
+
+          if (nbyteswritten != -EINTR || ntransferred == 0)
+            {
+              return nbyteswritten;
+            }
+
+          break;
+        }
+
+      ntransferred += nbyteswritten;
+    }
+
+  /* Advance the input file as read() would have */
+
+  pos = file_seek(infile, pos + ntransferred, SEEK_SET);
+  if (pos < 0)
+    {
+      return pos;
+    }
+
+  return ntransferred;
+}
+
 static ssize_t copyfile(FAR struct file *outfile, FAR struct file *infile,
                         FAR off_t *offset, size_t count)
 {
@@ -74,6 +163,15 @@ static ssize_t copyfile(FAR struct file *outfile, FAR struct file *infile,
         }
     }
 
+  /* Avoid the I/O buffer if the input file can be accessed in place */
+
+  nbyteswritten = copyfile_inplace(outfile, infile, count);
+  if (nbyteswritten != -ENOSYS)
+    {
+      ntransferred = nbyteswritten;
+      goto out;
+    }
+
   /* Allocate an I/O buffer */
 
   iobuffer = fs_heap_malloc(CONFIG_SENDFILE_BUFSIZE);
@@ -201,6 +299,8 @@ static ssize_t copyfile(FAR struct file *outfile, FAR struct file *infile,
 
   fs_heap_free(iobuffer);
 
+out:
+
   /* Return the current file position */
 
   if (offset)
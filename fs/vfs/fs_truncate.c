@@ -54,6 +54,7 @@
 int file_truncate(FAR struct file *filep, off_t length)
 {
   struct inode *inode;
+  int ret;
 
   /* Was this file opened for write access? */
 
@@ -102,7 +103,13 @@ int file_truncate(FAR struct file *filep, off_t length)
 
   /* Yes, then tell the file system to truncate this file */
 
-  return inode->u.i_ops->truncate(filep, length);
+  ret = inode->u.i_ops->truncate(filep, length);
+  if (ret >= 0)
+    {
+      file_readahead_invalidate(filep);
+    }
+
+  return ret;
 }
 
 /****************************************************************************
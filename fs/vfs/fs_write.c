@@ -199,12 +199,13 @@ ssize_t file_writev(FAR struct file *filep,
         }
     }
 
-#ifdef CONFIG_FS_NOTIFY
   if (ret > 0)
     {
+      file_readahead_invalidate(filep);
+#ifdef CONFIG_FS_NOTIFY
       notify_write(filep);
-    }
 #endif
+    }
 
   return ret;
 }
@@ -107,6 +107,68 @@ int file_setlk(FAR struct file *filep, FAR struct flock *flock,
 
 #endif /* CONFIG_FS_LOCK_BUCKET_SIZE */
 
+#ifdef CONFIG_FS_READAHEAD
+
+/****************************************************************************
+ * Name: file_readahead_check
+ *
+ * Description:
+ *   Return true if reads of the file may go through the read-ahead logic:
+ *   a regular file opened read-only on a file system that supports dup.
+ *
+ ****************************************************************************/
+
+bool file_readahead_check(FAR struct file *filep);
+
+/****************************************************************************
+ * Name: file_readahead_read
+ *
+ * Description:
+ *   Read from the file at f_pos.  Sequential streams are detected and the
+ *   data beyond the current position is fetched by the low priority work
+ *   queue, with a window that doubles on every sequential read from
+ *   CONFIG_FS_READAHEAD_MINSIZE up to CONFIG_FS_READAHEAD_MAXSIZE.
+ *
+ * Input Parameters:
+ *   filep  - File structure instance
+ *   buf    - User-provided to save the data
+ *   nbytes - The maximum size of the user-provided buffer
+ *
+ * Returned Value:
+ *   The number of bytes read, 0 at end-of-file, or a negated errno value.
+ *
+ ****************************************************************************/
+
+ssize_t file_readahead_read(FAR struct file *filep, FAR void *buf,
+                            size_t nbytes);
+
+/****************************************************************************
+ * Name: file_readahead_close
+ *
+ * Description:
+ *   Wait for any read-ahead in flight and release the read-ahead state of
+ *   the file.
+ *
+ ****************************************************************************/
+
+void file_readahead_close(FAR struct file *filep);
+
+/****************************************************************************
+ * Name: file_readahead_invalidate
+ *
+ * Description:
+ *   Called after a write or truncate through filep.  The files do not
+ *   identify the file they access, so the data read ahead on every file of
+ *   the same file system is dropped before its next read.
+ *
+ ****************************************************************************/
+
+void file_readahead_invalidate(FAR struct file *filep);
+#else
+#  define file_readahead_close(filep)
+#  define file_readahead_invalidate(filep)
+#endif /* CONFIG_FS_READAHEAD */
+
 #ifdef CONFIG_FS_NOTIFY
 void notify_open(FAR const char *path, int oflags);
 void notify_close(FAR const char *path, int oflags);
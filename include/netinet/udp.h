@@ -33,6 +33,13 @@
  * Pre-processor Definitions
  ****************************************************************************/
 
+/* UDP protocol (SOL_UDP) socket options */
+
+#define UDP_ZEROCOPY_RELEASE (__SO_PROTOCOL + 0) /* Give back the buffers of a
+                                                  * datagram received with
+                                                  * MSG_ZEROCOPY.  Argument:
+                                                  * the first iov_base. */
+
 /* UDP header as specified by RFC 768, August 1980. */
 
 struct udphdr
@@ -189,6 +189,7 @@ struct statfs;
 struct pollfd;
 struct mtd_dev_s;
 struct uio;
+struct file_readahead_s;
 
 /* The internal representation of type DIR is just a container for an inode
  * reference, and the path of directory.
@@ -211,6 +212,27 @@ struct fs_dirent_s
   FAR char *fd_path;
 };
 
+#ifdef CONFIG_FS_AIORING
+/* A transfer started through the submit method of a driver.  The driver
+ * calls fa_complete() exactly once, from thread context, with the number
+ * of bytes (sectors for a block driver) transferred or a negated errno.
+ * It may do so before submit() returns.
+ */
+
+#define FS_AIO_READ       0
+#define FS_AIO_WRITE      1
+
+struct fs_aio_s
+{
+  uint8_t   fa_opcode;  /* FS_AIO_READ or FS_AIO_WRITE */
+  FAR void *fa_buffer;  /* The I/O buffer */
+  size_t    fa_nbytes;  /* Bytes, or sectors for a block driver */
+  off_t     fa_offset;  /* Byte offset, or start sector for a block driver.
+                         * Negative to use the file position. */
+  CODE void (*fa_complete)(FAR struct fs_aio_s *aio, ssize_t result);
+};
+#endif
+
 /* This structure is provided by devices when they are registered with the
  * system.  It is used to call back to perform device specific operations.
  */
@@ -247,6 +269,16 @@ struct file_operations
 #ifndef CONFIG_DISABLE_PSEUDOFS_OPERATIONS
   CODE int     (*unlink)(FAR struct inode *inode);
 #endif
+
+  /* Start a transfer without waiting for it.  Returns OK if the transfer
+   * was started, -ENOSYS if the caller should do it synchronously instead,
+   * or another negated errno if it failed.  fa_complete() is called only
+   * if OK is returned.
+   */
+
+#ifdef CONFIG_FS_AIORING
+  CODE int     (*submit)(FAR struct file *filep, FAR struct fs_aio_s *aio);
+#endif
 };
 
 /* This structure provides information about the state of a block driver */
@@ -274,6 +306,9 @@ struct block_operations
 #ifndef CONFIG_DISABLE_PSEUDOFS_OPERATIONS
   CODE int     (*unlink)(FAR struct inode *inode);
 #endif
+#ifdef CONFIG_FS_AIORING
+  CODE int     (*submit)(FAR struct inode *inode, FAR struct fs_aio_s *aio);
+#endif
 };
 
 /* This structure is provided by a filesystem to describe a mount point.
@@ -415,6 +450,9 @@ struct inode
   struct timespec   i_atime;    /* Time of last access */
   struct timespec   i_mtime;    /* Time of last modification */
   struct timespec   i_ctime;    /* Time of last status change */
+#endif
+#ifdef CONFIG_FS_INODE_HASH
+  FAR struct inode *i_hash;     /* Link in the child lookup hash chain */
 #endif
   FAR void         *i_private;  /* Per inode driver private data */
   char              i_name[1];  /* Name of inode (variable) */
@@ -461,6 +499,9 @@ struct file
   off_t             f_pos;      /* File position */
   FAR struct inode *f_inode;    /* Driver or file system interface */
   FAR void         *f_priv;     /* Per file driver private data */
+#ifdef CONFIG_FS_READAHEAD
+  FAR struct file_readahead_s *f_readahead; /* Read-ahead state */
+#endif
 #if CONFIG_FS_LOCK_BUCKET_SIZE > 0
   bool              f_locked;   /* Filelock state: false - unlocked, true - locked */
 #endif
@@ -572,6 +613,20 @@ struct streamlist
 };
 #endif /* CONFIG_FILE_STREAM */
 
+/* Usage statistics of the shared block buffer cache */
+
+#ifdef CONFIG_FS_BLOCKCACHE
+struct blockcache_stats_s
+{
+  unsigned int nblocks;     /* Number of cache blocks */
+  unsigned int nused;       /* Number of blocks holding a sector */
+  unsigned int ndirty;      /* Number of blocks not yet written back */
+  uint32_t     hits;        /* Sectors read from the cache */
+  uint32_t     misses;      /* Sectors read from the media */
+  uint32_t     writebacks;  /* Dirty sectors written back to the media */
+};
+#endif
+
 /****************************************************************************
  * Public Function Prototypes
  ****************************************************************************/
@@ -1483,6 +1538,108 @@ int close_blockdriver(FAR struct inode *inode);
 int find_blockdriver(FAR const char *pathname, int mountflags,
                      FAR struct inode **ppinode);
 
+/****************************************************************************
+ * Name: blockcache_read
+ *
+ * Description:
+ *   Read sectors from a block driver through the shared block buffer
+ *   cache.  Single sectors are kept in the cache; longer runs of sectors
+ *   that miss are read straight into the caller's buffer so that bulk
+ *   transfers do not flush out the metadata.
+ *
+ * Input Parameters:
+ *   inode    - The block driver inode
+ *   buffer   - The buffer to receive the data
+ *   start    - The first sector to read
+ *   nsectors - The number of sectors to read
+ *   sectsize - The sector size of the block driver.  The cache is bypassed
+ *              if it is not CONFIG_FS_BLOCKCACHE_BLOCKSIZE.
+ *
+ * Returned Value:
+ *   The number of sectors read on success or a negated errno on failure.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_FS_BLOCKCACHE
+ssize_t blockcache_read(FAR struct inode *inode, FAR unsigned char *buffer,
+                        blkcnt_t start, unsigned int nsectors,
+                        size_t sectsize);
+
+/****************************************************************************
+ * Name: blockcache_write
+ *
+ * Description:
+ *   Write sectors to a block driver through the shared block buffer cache.
+ *   With CONFIG_FS_BLOCKCACHE_WRITEBACK, a single sector is only written to
+ *   the cache and reaches the media when it is evicted or flushed.  Longer
+ *   writes go to the media directly and update the cached copies.
+ *
+ * Input Parameters:
+ *   inode    - The block driver inode
+ *   buffer   - The data to write
+ *   start    - The first sector to write
+ *   nsectors - The number of sectors to write
+ *   sectsize - The sector size of the block driver
+ *
+ * Returned Value:
+ *   The number of sectors written on success or a negated errno on failure.
+ *
+ ****************************************************************************/
+
+ssize_t blockcache_write(FAR struct inode *inode,
+                         FAR const unsigned char *buffer, blkcnt_t start,
+                         unsigned int nsectors, size_t sectsize);
+
+/****************************************************************************
+ * Name: blockcache_flush
+ *
+ * Description:
+ *   Write back the dirty sectors cached for a block driver.
+ *
+ * Input Parameters:
+ *   inode - The block driver inode, or NULL for all block drivers
+ *
+ * Returned Value:
+ *   Zero on success or a negated errno on failure.
+ *
+ ****************************************************************************/
+
+int blockcache_flush(FAR struct inode *inode);
+
+/****************************************************************************
+ * Name: blockcache_invalidate
+ *
+ * Description:
+ *   Write back and then drop all the sectors cached for a block driver.
+ *   This is called when the block driver is closed.
+ *
+ * Input Parameters:
+ *   inode - The block driver inode
+ *
+ * Returned Value:
+ *   Zero on success or a negated errno if the write back failed.  The
+ *   sectors are dropped in any case.
+ *
+ ****************************************************************************/
+
+int blockcache_invalidate(FAR struct inode *inode);
+
+/****************************************************************************
+ * Name: blockcache_getstats
+ *
+ * Description:
+ *   Return the usage statistics of the shared block buffer cache.
+ *
+ ****************************************************************************/
+
+void blockcache_getstats(FAR struct blockcache_stats_s *stats);
+#else
+#  define blockcache_read(inode, buffer, start, nsectors, sectsize) \
+     (inode)->u.i_bops->read(inode, buffer, start, nsectors)
+#  define blockcache_write(inode, buffer, start, nsectors, sectsize) \
+     (inode)->u.i_bops->write(inode, buffer, start, nsectors)
+#endif
+
 /****************************************************************************
  * Name: find_mtddriver
  *
@@ -247,6 +247,11 @@
 #define FIOGCLEX            _FIOC(0x0018) /* IN:  FAR int *
                                            * OUT: None
                                            */
+#define FIOC_XIPFIXED       _FIOC(0x0019) /* IN:  uinptr_t *
+                                           * OUT: Current file xip base address,
+                                           *      only if the memory does not
+                                           *      move while the file is open
+                                           */
 
 /* NuttX character driver ioctl definitions *********************************/
 
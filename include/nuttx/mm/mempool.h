@@ -87,6 +87,16 @@ struct mempool_procfs_entry_s
 };
 #endif
 
+#ifdef CONFIG_MM_MEMPOOL_PERCPU_FREELIST
+/* This structure describes the free blocks kept by one CPU */
+
+struct mempool_percpu_s
+{
+  sq_queue_t queue;   /* The free block queue of this CPU */
+  size_t     nfree;   /* The number of blocks in queue */
+};
+#endif
+
 /* This structure describes memory buffer pool */
 
 struct mempool_s
@@ -110,6 +120,9 @@ struct mempool_s
   size_t     nalloc;  /* The number of used block in mempool */
   spinlock_t lock;    /* The protect lock to mempool */
   sem_t      waitsem; /* The semaphore of waiter get free block */
+#ifdef CONFIG_MM_MEMPOOL_PERCPU_FREELIST
+  struct mempool_percpu_s percpu[CONFIG_SMP_NCPUS]; /* Per-CPU free blocks */
+#endif
 #if defined(CONFIG_FS_PROCFS) && !defined(CONFIG_FS_PROCFS_EXCLUDE_MEMPOOL)
   struct mempool_procfs_entry_s procfs; /* The entry of procfs */
 #endif
@@ -139,6 +152,16 @@ struct mempoolinfo_s
   unsigned long nwaiter;  /* This is the number of waiter for mempool */
 };
 
+#ifdef CONFIG_MM_HEAP_MEMPOOL_MAGAZINE
+struct mempool_magazineinfo_s
+{
+  unsigned long hits;     /* Allocations served from the CPU's magazines */
+  unsigned long misses;   /* Allocations that had to refill a magazine */
+  unsigned long nblks;    /* The number of blocks cached by the CPU */
+  unsigned long size;     /* The total size of blocks cached by the CPU */
+};
+#endif
+
 /****************************************************************************
  * Public Function Prototypes
  ****************************************************************************/
@@ -203,6 +226,43 @@ FAR void *mempool_allocate(FAR struct mempool_s *pool);
 
 void mempool_release(FAR struct mempool_s *pool, FAR void *blk);
 
+/****************************************************************************
+ * Name: mempool_allocate_batch
+ *
+ * Description:
+ *   Allocate up to nblks blocks from a specific memory pool under a single
+ *   acquisition of the pool lock.  If the pool has no free block, one
+ *   block is allocated with mempool_allocate(), expanding the pool if
+ *   possible.
+ *
+ * Input Parameters:
+ *   pool  - Address of the memory pool to be used.
+ *   blks  - The array that receives the allocated blocks.
+ *   nblks - The maximum number of blocks to allocate, must not be zero.
+ *
+ * Returned Value:
+ *   The number of blocks stored in blks; zero on any failure.
+ ****************************************************************************/
+
+size_t mempool_allocate_batch(FAR struct mempool_s *pool,
+                              FAR void **blks, size_t nblks);
+
+/****************************************************************************
+ * Name: mempool_release_batch
+ *
+ * Description:
+ *   Release nblks memory blocks to the pool under a single acquisition of
+ *   the pool lock.
+ *
+ * Input Parameters:
+ *   pool  - Address of the memory pool to be used.
+ *   blks  - The array of memory blocks.
+ *   nblks - The number of blocks in blks.
+ ****************************************************************************/
+
+void mempool_release_batch(FAR struct mempool_s *pool,
+                           FAR void * const *blks, size_t nblks);
+
 /****************************************************************************
  * Name: mempool_info
  *
@@ -521,6 +581,26 @@ struct mallinfo_task
 mempool_multiple_info_task(FAR struct mempool_multiple_s *mpool,
                            FAR const struct malltask *task);
 
+/****************************************************************************
+ * Name: mempool_multiple_magazine_info
+ * Description:
+ *   Get the per-CPU magazine statistics of a multiple memory pool.
+ *
+ * Input Parameters:
+ *   mpool - The handle of multiple memory pool to be used.
+ *   cpu   - The CPU whose magazines are queried.
+ *   info  - The pointer of magazine information to be filled in.
+ *
+ * Returned Value:
+ *   OK on success; A negated errno value on any failure.
+ ****************************************************************************/
+
+#ifdef CONFIG_MM_HEAP_MEMPOOL_MAGAZINE
+int mempool_multiple_magazine_info(FAR struct mempool_multiple_s *mpool,
+                                   int cpu,
+                                   FAR struct mempool_magazineinfo_s *info);
+#endif
+
 #undef EXTERN
 #if defined(__cplusplus)
 }
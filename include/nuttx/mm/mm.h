@@ -411,6 +411,12 @@ struct mallinfo_task mm_mallinfo_task(FAR struct mm_heap_s *heap,
 size_t mm_heapfree(FAR struct mm_heap_s *heap);
 size_t mm_heapfree_largest(FAR struct mm_heap_s *heap);
 
+#ifdef CONFIG_MM_HEAP_MEMPOOL_MAGAZINE
+struct mempool_magazineinfo_s;
+int mm_magazineinfo(FAR struct mm_heap_s *heap, int cpu,
+                    FAR struct mempool_magazineinfo_s *info);
+#endif
+
 /* Functions contained in kmm_mallinfo.c ************************************/
 
 #ifdef CONFIG_MM_KERNEL_HEAP
@@ -801,6 +801,28 @@ int netdev_ifdown(FAR struct net_driver_s *dev);
 void netdev_carrier_on(FAR struct net_driver_s *dev);
 void netdev_carrier_off(FAR struct net_driver_s *dev);
 
+/****************************************************************************
+ * Name: up_chksum
+ *
+ * Description:
+ *   Calculate the one's complement sum of the 16-bit words of a buffer,
+ *   read in host byte order, with an odd trailing byte padded with zero.
+ *   Provided by libs/libc/machine when CONFIG_LIBC_ARCH_CHKSUM is set and
+ *   used by chksum() and chksum_iob().
+ *
+ * Input Parameters:
+ *   data - Beginning of the data to include in the sum.
+ *   len  - Length of the data to include in the sum.
+ *
+ * Returned Value:
+ *   The one's complement sum, in host byte order.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_LIBC_ARCH_CHKSUM
+uint16_t up_chksum(FAR const uint8_t *data, uint16_t len);
+#endif
+
 /****************************************************************************
  * Name: chksum
  *
@@ -295,6 +295,27 @@ void netdev_lower_carrier_off(FAR struct netdev_lowerhalf_s *dev);
 
 void netdev_lower_rxready(FAR struct netdev_lowerhalf_s *dev);
 
+/****************************************************************************
+ * Name: netdev_lower_rxready_cpu
+ *
+ * Description:
+ *   Notifies the networking layer that an RX packet is ready to read on a
+ *   receive queue that is served by the work thread of the given CPU.
+ *   Drivers with several receive queues use this instead of
+ *   netdev_lower_rxready() so that each queue is drained on its own CPU.
+ *
+ * Input Parameters:
+ *   dev - The lower half device driver structure
+ *   cpu - The CPU whose work thread should receive the packet
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NETDEV_RSS
+void netdev_lower_rxready_cpu(FAR struct netdev_lowerhalf_s *dev, int cpu);
+#else
+#  define netdev_lower_rxready_cpu(dev, cpu) netdev_lower_rxready(dev)
+#endif
+
 /****************************************************************************
  * Name: netdev_lower_txdone
  *
@@ -100,6 +100,11 @@ void sched_note_spinlock_unlock(FAR volatile spinlock_t *spinlock);
 #  define sched_note_spinlock_unlock(spinlock)
 #endif
 
+#ifdef CONFIG_SCHED_LOCKSTAT_SPINLOCK
+void sched_lockstat_spinlock(FAR volatile spinlock_t *lock, bool contended,
+                             clock_t wait);
+#endif
+
 /****************************************************************************
  * Public Data Types
  ****************************************************************************/
@@ -227,6 +232,50 @@ static inline_function void spin_lock_notrace(FAR volatile spinlock_t *lock)
 #  define spin_lock_notrace(lock)
 #endif /* CONFIG_SPINLOCK */
 
+/****************************************************************************
+ * Name: spin_lock_lockstat
+ *
+ * Description:
+ *   The same as spin_lock_notrace(), but the acquisition and the time
+ *   spent spinning are counted in the lock statistics.
+ *
+ *   The raw performance counter is read directly: perf_gettime() takes a
+ *   spinlock itself.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SCHED_LOCKSTAT_SPINLOCK
+static inline_function void spin_lock_lockstat(FAR volatile spinlock_t *lock)
+{
+  bool contended = false;
+  unsigned long start = 0;
+
+#ifdef CONFIG_TICKET_SPINLOCK
+  int ticket = atomic_fetch_add(&lock->next, 1);
+  while (atomic_read(&lock->owner) != ticket)
+#else /* CONFIG_TICKET_SPINLOCK */
+  while (up_testset(lock) == SP_LOCKED)
+#endif
+    {
+      if (!contended)
+        {
+          contended = true;
+          start = up_perf_gettime();
+        }
+
+      UP_DSB();
+      UP_WFE();
+    }
+
+  UP_DMB();
+
+  sched_lockstat_spinlock(lock, contended, contended ?
+                          (unsigned long)up_perf_gettime() - start : 0);
+}
+#else
+#  define spin_lock_lockstat(lock) spin_lock_notrace(lock)
+#endif /* CONFIG_SCHED_LOCKSTAT_SPINLOCK */
+
 /****************************************************************************
  * Name: spin_lock
  *
@@ -259,7 +308,7 @@ static inline_function void spin_lock(FAR volatile spinlock_t *lock)
 
   /* Lock without trace note */
 
-  spin_lock_notrace(lock);
+  spin_lock_lockstat(lock);
 
   /* Notify that we have the spinlock */
 
@@ -513,7 +562,12 @@ irqstate_t spin_lock_irqsave(FAR volatile spinlock_t *lock)
 
   /* Lock without trace note */
 
+#ifdef CONFIG_SCHED_LOCKSTAT_SPINLOCK
+  flags = up_irq_save();
+  spin_lock_lockstat(lock);
+#else
   flags = spin_lock_irqsave_notrace(lock);
+#endif
 
   /* Notify that we have the spinlock */
 
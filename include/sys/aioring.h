@@ -0,0 +1,233 @@
+/****************************************************************************
+ * include/sys/aioring.h
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __INCLUDE_SYS_AIORING_H
+#define __INCLUDE_SYS_AIORING_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <stdint.h>
+
+#ifdef CONFIG_FS_AIORING
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Submission queue entry operations */
+
+#define AIORING_OP_NOP    0  /* Complete immediately with result 0 */
+#define AIORING_OP_READ   1  /* read(), or pread() if sqe_offset >= 0 */
+#define AIORING_OP_WRITE  2  /* write(), or pwrite() if sqe_offset >= 0 */
+#define AIORING_OP_FSYNC  3  /* fsync() */
+
+/* Access to the ring indices.  The side that owns an index publishes it
+ * with a store-release once it has filled in or consumed the entries, and
+ * the other side reads it with a load-acquire before it touches them.
+ */
+
+#define AIORING_LOAD_ACQUIRE(p)      __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define AIORING_STORE_RELEASE(p, v)  __atomic_store_n(p, v, __ATOMIC_RELEASE)
+
+/****************************************************************************
+ * Public Type Declarations
+ ****************************************************************************/
+
+/* One I/O request, filled in by the application */
+
+struct aioring_sqe_s
+{
+  uint8_t   sqe_opcode;     /* One of AIORING_OP_* */
+  int       sqe_fd;         /* File or socket descriptor */
+  off_t     sqe_offset;     /* File offset, or -1 for the current position */
+  FAR void *sqe_buf;        /* I/O buffer */
+  size_t    sqe_nbytes;     /* Size of the I/O buffer */
+  uintptr_t sqe_userdata;   /* Copied to the completion entry */
+};
+
+/* The completion of one I/O request, filled in by the system */
+
+struct aioring_cqe_s
+{
+  uintptr_t cqe_userdata;   /* sqe_userdata of the request */
+  ssize_t   cqe_result;     /* Result of the I/O, or a negated errno */
+};
+
+/* A submission/completion ring pair.  The structure and both entry arrays
+ * live in the application memory and are shared with the system.  The
+ * application only ever moves sq_tail and cq_head, the system only ever
+ * moves sq_head and cq_tail.  The indices run freely and are reduced
+ * modulo 'entries', which must be a power of two.  Each index is only
+ * written by its owner, with release semantics, and read by the other
+ * side with acquire semantics (see AIORING_LOAD_ACQUIRE() and
+ * AIORING_STORE_RELEASE()).
+ *
+ * The application sets up 'entries', 'sqes' and 'cqes' before calling
+ * aioring_setup().
+ */
+
+struct aioring_s
+{
+  uint32_t  sq_head;        /* Next request to be consumed by the system */
+  uint32_t  sq_tail;        /* Next request to be filled in */
+  uint32_t  cq_head;        /* Next completion to be consumed */
+  uint32_t  cq_tail;        /* Next completion to be filled in */
+  uint32_t  entries;        /* Size of both arrays, a power of two */
+  FAR struct aioring_sqe_s *sqes;
+  FAR struct aioring_cqe_s *cqes;
+  FAR void *priv;           /* Used by the system */
+};
+
+/****************************************************************************
+ * Inline Functions
+ ****************************************************************************/
+
+/* Return the next free submission entry, or NULL if the queue is full */
+
+static inline FAR struct aioring_sqe_s *
+aioring_get_sqe(FAR struct aioring_s *ring)
+{
+  uint32_t tail = ring->sq_tail;
+
+  if (tail - AIORING_LOAD_ACQUIRE(&ring->sq_head) >= ring->entries)
+    {
+      return NULL;
+    }
+
+  return &ring->sqes[tail & (ring->entries - 1)];
+}
+
+/* Queue the entry returned by aioring_get_sqe() */
+
+static inline void aioring_commit_sqe(FAR struct aioring_s *ring)
+{
+  AIORING_STORE_RELEASE(&ring->sq_tail, ring->sq_tail + 1);
+}
+
+/* Return the oldest completion, or NULL if there is none.  This does not
+ * enter the system, so it can be used to poll for completions.
+ */
+
+static inline FAR struct aioring_cqe_s *
+aioring_peek_cqe(FAR struct aioring_s *ring)
+{
+  uint32_t head = ring->cq_head;
+
+  if (head == AIORING_LOAD_ACQUIRE(&ring->cq_tail))
+    {
+      return NULL;
+    }
+
+  return &ring->cqes[head & (ring->entries - 1)];
+}
+
+/* Release the completion returned by aioring_peek_cqe() */
+
+static inline void aioring_seen_cqe(FAR struct aioring_s *ring)
+{
+  AIORING_STORE_RELEASE(&ring->cq_head, ring->cq_head + 1);
+}
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+#ifdef __cplusplus
+#define EXTERN extern "C"
+extern "C"
+{
+#else
+#define EXTERN extern
+#endif
+
+/****************************************************************************
+ * Name: aioring_setup
+ *
+ * Description:
+ *   Register a ring with the system.  'entries', 'sqes' and 'cqes' must
+ *   already be set up; the indices are reset.
+ *
+ * Returned Value:
+ *   Zero on success; -1 with errno set on failure.
+ *
+ ****************************************************************************/
+
+int aioring_setup(FAR struct aioring_s *ring);
+
+/****************************************************************************
+ * Name: aioring_submit
+ *
+ * Description:
+ *   Start all requests queued since the last call.  Reads and writes on
+ *   sockets and on block devices that support it are started directly;
+ *   the other requests run concurrently on the system AIO threads.  No
+ *   more than 'entries' requests are in flight at a time; the rest stay
+ *   queued until the next call.
+ *
+ * Returned Value:
+ *   The number of requests started; -1 with errno set on failure.
+ *
+ ****************************************************************************/
+
+int aioring_submit(FAR struct aioring_s *ring);
+
+/****************************************************************************
+ * Name: aioring_wait
+ *
+ * Description:
+ *   Wait until at least 'ncomplete' completions are available, or until
+ *   'timeout' milliseconds have elapsed.  A negative timeout waits
+ *   forever.
+ *
+ * Returned Value:
+ *   The number of completions available; -1 with errno set on failure.
+ *
+ ****************************************************************************/
+
+int aioring_wait(FAR struct aioring_s *ring, unsigned int ncomplete,
+                 int timeout);
+
+/****************************************************************************
+ * Name: aioring_destroy
+ *
+ * Description:
+ *   Wait for the requests in flight to complete, then unregister the ring.
+ *
+ * Returned Value:
+ *   Zero on success; -1 with errno set on failure.
+ *
+ ****************************************************************************/
+
+int aioring_destroy(FAR struct aioring_s *ring);
+
+#undef EXTERN
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CONFIG_FS_AIORING */
+#endif /* __INCLUDE_SYS_AIORING_H */
@@ -139,6 +139,9 @@
 #define MSG_CMSG_CLOEXEC 0x100000 /* Set close_on_exit for file
                                    * descriptor received through SCM_RIGHTS.
                                    */
+#define MSG_ZEROCOPY    0x4000000 /* Lend received buffers instead of
+                                   * copying, see UDP_ZEROCOPY_RELEASE.
+                                   */
 
 /* Protocol levels supported by get/setsockopt(): */
 
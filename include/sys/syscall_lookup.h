@@ -209,6 +209,12 @@ SYSCALL_LOOKUP(pwrite,                     4)
   SYSCALL_LOOKUP(aio_write,                1)
   SYSCALL_LOOKUP(aio_fsync,                2)
   SYSCALL_LOOKUP(aio_cancel,               2)
+#endif
+#ifdef CONFIG_FS_AIORING
+  SYSCALL_LOOKUP(aioring_setup,            1)
+  SYSCALL_LOOKUP(aioring_submit,           1)
+  SYSCALL_LOOKUP(aioring_wait,             3)
+  SYSCALL_LOOKUP(aioring_destroy,          1)
 #endif
   SYSCALL_LOOKUP(poll,                     3)
   SYSCALL_LOOKUP(select,                   5)
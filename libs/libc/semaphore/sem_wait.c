@@ -158,6 +158,14 @@ int nxsem_wait(FAR sem_t *sem)
     }
 #endif
 
+  /* Disable fast path if lock statistics are collected, so that every
+   * acquisition is counted.
+   */
+
+#ifdef CONFIG_SCHED_LOCKSTAT
+  fastpath = false;
+#endif
+
   /* Disable fast path on a counting semaphore with priority inheritance */
 
 #ifdef CONFIG_PRIORITY_INHERITANCE
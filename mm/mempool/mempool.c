@@ -100,6 +100,137 @@ static inline void mempool_add_queue(FAR struct mempool_s *pool,
     }
 }
 
+static inline bool mempool_is_interrupt_block(FAR struct mempool_s *pool,
+                                              FAR void *blk)
+{
+  size_t blocksize = MEMPOOL_REALBLOCKSIZE(pool);
+
+  return pool->interruptsize > blocksize &&
+         (FAR char *)blk >= pool->ibase &&
+         (FAR char *)blk < pool->ibase + pool->interruptsize - blocksize;
+}
+
+static inline void mempool_mark_free(FAR struct mempool_s *pool,
+                                     FAR void *blk)
+{
+#if CONFIG_MM_BACKTRACE >= 0
+  FAR struct mempool_backtrace_s *buf =
+    (FAR struct mempool_backtrace_s *)((FAR char *)blk + pool->blocksize);
+
+  /* Check double free or out of out of bounds */
+
+  DEBUGASSERT(buf->magic == MEMPOOL_MAGIC_ALLOC);
+  buf->magic = MEMPOOL_MAGIC_FREE;
+
+#endif
+
+#ifdef CONFIG_MM_FILL_ALLOCATIONS
+  memset(blk, MM_FREE_MAGIC, pool->blocksize);
+#endif
+}
+
+static void mempool_release_block(FAR struct mempool_s *pool,
+                                  FAR void *blk)
+{
+  mempool_mark_free(pool, blk);
+  pool->nalloc--;
+
+  if (mempool_is_interrupt_block(pool, blk))
+    {
+      sq_addlast(blk, &pool->iqueue);
+    }
+  else
+    {
+      sq_addlast(blk, &pool->queue);
+    }
+
+  kasan_poison(blk, pool->blocksize);
+}
+
+#ifdef CONFIG_MM_MEMPOOL_PERCPU_FREELIST
+/* Blocks on the per-CPU lists are still counted in pool->nalloc, so the
+ * fast paths below never touch the shared pool state.
+ */
+
+static FAR sq_entry_t *mempool_percpu_pop(FAR struct mempool_s *pool)
+{
+  FAR struct mempool_percpu_s *percpu;
+  FAR sq_entry_t *blk;
+  irqstate_t flags;
+
+  flags = up_irq_save();
+  percpu = &pool->percpu[this_cpu()];
+  blk = mempool_remove_queue(pool, &percpu->queue);
+  if (blk != NULL)
+    {
+      percpu->nfree--;
+    }
+
+  up_irq_restore(flags);
+  return blk;
+}
+
+static bool mempool_percpu_push(FAR struct mempool_s *pool, FAR void *blk)
+{
+  FAR struct mempool_percpu_s *percpu;
+  irqstate_t flags;
+
+  /* Waiters are only woken up by the shared path, and the interrupt
+   * reserve must go back to iqueue.
+   */
+
+  if ((pool->wait && pool->expandsize == 0) ||
+      mempool_is_interrupt_block(pool, blk))
+    {
+      return false;
+    }
+
+  flags = up_irq_save();
+  percpu = &pool->percpu[this_cpu()];
+  if (percpu->nfree >= CONFIG_MM_MEMPOOL_PERCPU_FREELIST_SIZE)
+    {
+      up_irq_restore(flags);
+      return false;
+    }
+
+  mempool_mark_free(pool, blk);
+  sq_addfirst(blk, &percpu->queue);
+  percpu->nfree++;
+  kasan_poison(blk, pool->blocksize);
+  up_irq_restore(flags);
+  return true;
+}
+
+static size_t mempool_percpu_count(FAR struct mempool_s *pool)
+{
+  size_t count = 0;
+  int cpu;
+
+  for (cpu = 0; cpu < CONFIG_SMP_NCPUS; cpu++)
+    {
+      count += pool->percpu[cpu].nfree;
+    }
+
+  return count;
+}
+#else
+#  define mempool_percpu_count(pool) 0
+#endif
+
+static void mempool_wake_waiter(FAR struct mempool_s *pool)
+{
+  if (pool->wait && pool->expandsize == 0)
+    {
+      int semcount;
+
+      nxsem_get_value(&pool->waitsem, &semcount);
+      if (semcount < 1)
+        {
+          nxsem_post(&pool->waitsem);
+        }
+    }
+}
+
 #if CONFIG_MM_BACKTRACE >= 0
 static inline void mempool_add_backtrace(FAR struct mempool_s *pool,
                                          FAR struct mempool_backtrace_s *buf)
@@ -262,6 +393,10 @@ int mempool_init(FAR struct mempool_s *pool, FAR const char *name)
   sq_init(&pool->iqueue);
   sq_init(&pool->equeue);
   pool->nalloc = 0;
+#ifdef CONFIG_MM_MEMPOOL_PERCPU_FREELIST
+  memset(pool->percpu, 0, sizeof(pool->percpu));
+#endif
+
   if (pool->interruptsize >= blocksize)
     {
       size_t ninterrupt = pool->interruptsize / blocksize;
@@ -347,6 +482,14 @@ FAR void *mempool_allocate(FAR struct mempool_s *pool)
   FAR sq_entry_t *blk;
   irqstate_t flags;
 
+#ifdef CONFIG_MM_MEMPOOL_PERCPU_FREELIST
+  blk = mempool_percpu_pop(pool);
+  if (blk != NULL)
+    {
+      goto out;
+    }
+
+#endif
 retry:
   flags = spin_lock_irqsave(&pool->lock);
   blk = mempool_remove_queue(pool, &pool->queue);
@@ -401,6 +544,9 @@ retry:
   pool->nalloc++;
   spin_unlock_irqrestore(&pool->lock, flags);
 
+#ifdef CONFIG_MM_MEMPOOL_PERCPU_FREELIST
+out:
+#endif
 #if CONFIG_MM_BACKTRACE >= 0
   mempool_add_backtrace(pool, (FAR struct mempool_backtrace_s *)
                               ((FAR char *)blk + pool->blocksize));
@@ -427,54 +573,117 @@ retry:
 
 void mempool_release(FAR struct mempool_s *pool, FAR void *blk)
 {
-  irqstate_t flags = spin_lock_irqsave(&pool->lock);
-  size_t blocksize = MEMPOOL_REALBLOCKSIZE(pool);
-#if CONFIG_MM_BACKTRACE >= 0
-  FAR struct mempool_backtrace_s *buf =
-    (FAR struct mempool_backtrace_s *)((FAR char *)blk + pool->blocksize);
-
-  /* Check double free or out of out of bounds */
+  irqstate_t flags;
 
-  DEBUGASSERT(buf->magic == MEMPOOL_MAGIC_ALLOC);
-  buf->magic = MEMPOOL_MAGIC_FREE;
+#ifdef CONFIG_MM_MEMPOOL_PERCPU_FREELIST
+  if (mempool_percpu_push(pool, blk))
+    {
+      return;
+    }
 
 #endif
+  flags = spin_lock_irqsave(&pool->lock);
+  mempool_release_block(pool, blk);
+  spin_unlock_irqrestore(&pool->lock, flags);
+  mempool_wake_waiter(pool);
+}
 
-  pool->nalloc--;
+/****************************************************************************
+ * Name: mempool_allocate_batch
+ *
+ * Description:
+ *   Allocate up to nblks blocks from a specific memory pool, taking the
+ *   pool lock only once.  If the pool has no free block, this falls back
+ *   to mempool_allocate() for a single block, which may expand the pool.
+ *
+ * Input Parameters:
+ *   pool  - Address of the memory pool to be used.
+ *   blks  - The array that receives the allocated blocks.
+ *   nblks - The maximum number of blocks to allocate.
+ *
+ * Returned Value:
+ *   The number of blocks stored in blks; zero on any failure.
+ *
+ ****************************************************************************/
 
-#ifdef CONFIG_MM_FILL_ALLOCATIONS
-  memset(blk, MM_FREE_MAGIC, pool->blocksize);
-#endif
+size_t mempool_allocate_batch(FAR struct mempool_s *pool,
+                              FAR void **blks, size_t nblks)
+{
+  irqstate_t flags;
+  size_t n = 0;
+  size_t i;
 
-  if (pool->interruptsize > blocksize)
+  flags = spin_lock_irqsave(&pool->lock);
+  while (n < nblks)
     {
-      if ((FAR char *)blk >= pool->ibase &&
-          (FAR char *)blk < pool->ibase + pool->interruptsize - blocksize)
-        {
-          sq_addlast(blk, &pool->iqueue);
-        }
-      else
+      FAR sq_entry_t *blk = mempool_remove_queue(pool, &pool->queue);
+
+      if (blk == NULL)
         {
-          sq_addlast(blk, &pool->queue);
+          break;
         }
+
+      blks[n++] = blk;
     }
-  else
+
+  pool->nalloc += n;
+  spin_unlock_irqrestore(&pool->lock, flags);
+
+  if (n == 0)
     {
-      sq_addlast(blk, &pool->queue);
+      blks[0] = mempool_allocate(pool);
+      return blks[0] != NULL;
     }
 
-  kasan_poison(blk, pool->blocksize);
-  spin_unlock_irqrestore(&pool->lock, flags);
-  if (pool->wait && pool->expandsize == 0)
+  for (i = 0; i < n; i++)
     {
-      int semcount;
+#if CONFIG_MM_BACKTRACE >= 0
+      mempool_add_backtrace(pool, (FAR struct mempool_backtrace_s *)
+                                  ((FAR char *)blks[i] + pool->blocksize));
+#endif
 
-      nxsem_get_value(&pool->waitsem, &semcount);
-      if (semcount < 1)
-        {
-          nxsem_post(&pool->waitsem);
-        }
+      blks[i] = kasan_unpoison(blks[i], pool->blocksize);
+#ifdef CONFIG_MM_FILL_ALLOCATIONS
+      memset(blks[i], MM_ALLOC_MAGIC, pool->blocksize);
+#endif
     }
+
+  return n;
+}
+
+/****************************************************************************
+ * Name: mempool_release_batch
+ *
+ * Description:
+ *   Release nblks memory blocks to the pool, taking the pool lock only
+ *   once.
+ *
+ * Input Parameters:
+ *   pool  - Address of the memory pool to be used.
+ *   blks  - The array of memory blocks.
+ *   nblks - The number of blocks in blks.
+ *
+ ****************************************************************************/
+
+void mempool_release_batch(FAR struct mempool_s *pool,
+                           FAR void * const *blks, size_t nblks)
+{
+  irqstate_t flags;
+  size_t i;
+
+  if (nblks == 0)
+    {
+      return;
+    }
+
+  flags = spin_lock_irqsave(&pool->lock);
+  for (i = 0; i < nblks; i++)
+    {
+      mempool_release_block(pool, blks[i]);
+    }
+
+  spin_unlock_irqrestore(&pool->lock, flags);
+  mempool_wake_waiter(pool);
 }
 
 /****************************************************************************
@@ -495,13 +704,15 @@ int mempool_info(FAR struct mempool_s *pool, FAR struct mempoolinfo_s *info)
 {
   size_t blocksize = MEMPOOL_REALBLOCKSIZE(pool);
   irqstate_t flags;
+  size_t cached;
 
   DEBUGASSERT(pool != NULL && info != NULL);
 
   flags = spin_lock_irqsave(&pool->lock);
-  info->ordblks = sq_count(&pool->queue);
+  cached = mempool_percpu_count(pool);
+  info->ordblks = sq_count(&pool->queue) + cached;
   info->iordblks = sq_count(&pool->iqueue);
-  info->aordblks = pool->nalloc;
+  info->aordblks = pool->nalloc - cached;
   info->arena = sq_count(&pool->equeue) * MEMPOOL_HEADER_SIZE +
     (info->aordblks + info->ordblks + info->iordblks) * blocksize;
   spin_unlock_irqrestore(&pool->lock, flags);
@@ -539,7 +750,8 @@ mempool_info_task(FAR struct mempool_s *pool,
     {
       irqstate_t flags = spin_lock_irqsave(&pool->lock);
       size_t count = sq_count(&pool->queue) +
-                     sq_count(&pool->iqueue);
+                     sq_count(&pool->iqueue) +
+                     mempool_percpu_count(pool);
 
       spin_unlock_irqrestore(&pool->lock, flags);
       info.aordblks += count;
@@ -547,8 +759,10 @@ mempool_info_task(FAR struct mempool_s *pool,
     }
   else if (task->pid == PID_MM_ALLOC)
     {
-      info.aordblks += pool->nalloc;
-      info.uordblks += pool->nalloc * blocksize;
+      size_t count = pool->nalloc - mempool_percpu_count(pool);
+
+      info.aordblks += count;
+      info.uordblks += count * blocksize;
     }
 #if CONFIG_MM_BACKTRACE >= 0
   else
@@ -617,6 +831,18 @@ int mempool_deinit(FAR struct mempool_s *pool)
   size_t blocksize = MEMPOOL_REALBLOCKSIZE(pool);
   FAR sq_entry_t *blk;
   size_t count = 0;
+#ifdef CONFIG_MM_MEMPOOL_PERCPU_FREELIST
+  int cpu;
+
+  /* Give the per-CPU free blocks back to the shared queue first */
+
+  for (cpu = 0; cpu < CONFIG_SMP_NCPUS; cpu++)
+    {
+      sq_cat(&pool->percpu[cpu].queue, &pool->queue);
+      pool->nalloc -= pool->percpu[cpu].nfree;
+      pool->percpu[cpu].nfree = 0;
+    }
+#endif
 
   if (pool->nalloc != 0)
     {
@@ -29,16 +29,42 @@
 #include <syslog.h>
 #include <sys/param.h>
 
+#include <nuttx/irq.h>
 #include <nuttx/mutex.h>
 #include <nuttx/nuttx.h>
 #include <nuttx/kmalloc.h>
+#include <nuttx/sched.h>
 #include <nuttx/mm/mempool.h>
 #include <nuttx/mm/kasan.h>
 
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifdef CONFIG_MM_HEAP_MEMPOOL_MAGAZINE
+#  define MAGAZINE_SIZE  CONFIG_MM_HEAP_MEMPOOL_MAGAZINE_SIZE
+#  define MAGAZINE_BATCH ((MAGAZINE_SIZE + 1) / 2)
+#endif
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
 
+#ifdef CONFIG_MM_HEAP_MEMPOOL_MAGAZINE
+/* A magazine is a small per-CPU stack of free blocks of one pool.  It is
+ * only touched by its own CPU with local interrupts disabled, so the pool
+ * lock is only taken to refill or flush half a magazine at a time.
+ */
+
+struct mpool_magazine_s
+{
+  size_t          nblks;                /* The number of cached blocks */
+  unsigned long   hits;                 /* Allocations served from here */
+  unsigned long   misses;               /* Allocations that refilled */
+  FAR void       *blks[MAGAZINE_SIZE];  /* The cached blocks */
+};
+#endif
+
 struct mpool_dict_s
 {
   FAR struct mempool_s *pool; /* Record pool when expanding */
@@ -93,6 +119,12 @@ struct mempool_multiple_s
   size_t                        dict_col_num_log2;
   size_t                        dict_row_num;
   FAR struct mpool_dict_s     **dict;
+
+#ifdef CONFIG_MM_HEAP_MEMPOOL_MAGAZINE
+  /* The magazines of CPU n are magazines[n * npools ... + npools - 1] */
+
+  FAR struct mpool_magazine_s  *magazines;
+#endif
 };
 
 /****************************************************************************
@@ -279,6 +311,145 @@ static void mempool_multiple_free_callback(FAR struct mempool_s *pool,
                               (FAR char *)addr - mpool->minpoolsize);
 }
 
+#ifdef CONFIG_MM_HEAP_MEMPOOL_MAGAZINE
+/****************************************************************************
+ * Name: mempool_multiple_magazine_alloc
+ *
+ * Description:
+ *   Allocate a block of the given pool from the current CPU's magazine.
+ *   If the magazine is empty, refill it with a batch of blocks from the
+ *   pool.
+ *
+ ****************************************************************************/
+
+static FAR void *
+mempool_multiple_magazine_alloc(FAR struct mempool_multiple_s *mpool,
+                                FAR struct mempool_s *pool)
+{
+  FAR struct mpool_magazine_s *mag;
+  FAR void *blks[MAGAZINE_BATCH];
+  FAR void *blk = NULL;
+  size_t index = pool - mpool->pools;
+  irqstate_t flags;
+  size_t nblks;
+
+  flags = up_irq_save();
+  mag = &mpool->magazines[this_cpu() * mpool->npools + index];
+  if (mag->nblks > 0)
+    {
+      blk = mag->blks[--mag->nblks];
+      mag->hits++;
+    }
+  else
+    {
+      mag->misses++;
+    }
+
+  up_irq_restore(flags);
+  if (blk != NULL)
+    {
+#ifdef CONFIG_MM_FILL_ALLOCATIONS
+      memset(blk, MM_ALLOC_MAGIC, pool->blocksize);
+#endif
+      return blk;
+    }
+
+  /* Refill outside of the interrupt disabled region since expanding the
+   * pool may need to take the heap lock.
+   */
+
+  nblks = mempool_allocate_batch(pool, blks, MAGAZINE_BATCH);
+  if (nblks <= 1)
+    {
+      return nblks == 1 ? blks[0] : NULL;
+    }
+
+  /* The task may have migrated meanwhile, so stash the spare blocks in the
+   * magazine of the CPU we are running on now.
+   */
+
+  flags = up_irq_save();
+  mag = &mpool->magazines[this_cpu() * mpool->npools + index];
+  while (nblks > 1 && mag->nblks < MAGAZINE_SIZE)
+    {
+      mag->blks[mag->nblks++] = blks[--nblks];
+    }
+
+  up_irq_restore(flags);
+
+  mempool_release_batch(pool, blks + 1, nblks - 1);
+  return blks[0];
+}
+
+/****************************************************************************
+ * Name: mempool_multiple_magazine_free
+ *
+ * Description:
+ *   Free a block of the given pool to the current CPU's magazine.  If the
+ *   magazine is full, its older half is returned to the pool.
+ *
+ ****************************************************************************/
+
+static void
+mempool_multiple_magazine_free(FAR struct mempool_multiple_s *mpool,
+                               FAR struct mempool_s *pool, FAR void *blk)
+{
+  FAR struct mpool_magazine_s *mag;
+  FAR void *blks[MAGAZINE_BATCH];
+  irqstate_t flags;
+  size_t nblks = 0;
+
+#ifdef CONFIG_MM_FILL_ALLOCATIONS
+  memset(blk, MM_FREE_MAGIC, pool->blocksize);
+#endif
+
+  flags = up_irq_save();
+  mag = &mpool->magazines[this_cpu() * mpool->npools +
+                          (pool - mpool->pools)];
+  if (mag->nblks == MAGAZINE_SIZE)
+    {
+      nblks = MAGAZINE_BATCH;
+      mag->nblks -= nblks;
+      memcpy(blks, mag->blks, nblks * sizeof(FAR void *));
+      memmove(mag->blks, mag->blks + nblks,
+              mag->nblks * sizeof(FAR void *));
+    }
+
+  mag->blks[mag->nblks++] = blk;
+  up_irq_restore(flags);
+
+  mempool_release_batch(pool, blks, nblks);
+}
+
+/****************************************************************************
+ * Name: mempool_multiple_magazine_drain
+ *
+ * Description:
+ *   Return the blocks cached in every magazine to their pools.
+ *
+ ****************************************************************************/
+
+static void
+mempool_multiple_magazine_drain(FAR struct mempool_multiple_s *mpool)
+{
+  FAR struct mpool_magazine_s *mag;
+  size_t i;
+
+  for (i = 0; i < CONFIG_SMP_NCPUS * mpool->npools; i++)
+    {
+      mag = &mpool->magazines[i];
+      mempool_release_batch(mpool->pools + i % mpool->npools,
+                            mag->blks, mag->nblks);
+      mag->nblks = 0;
+    }
+}
+
+#  define mempool_multiple_allocate(mpool, pool) \
+     mempool_multiple_magazine_alloc(mpool, pool)
+#else
+#  define mempool_multiple_allocate(mpool, pool) mempool_allocate(pool)
+#endif
+
 /****************************************************************************
  * Name: mempool_multiple_get_dict
  *
@@ -430,7 +601,11 @@ mempool_multiple_init(FAR const char *name,
 
   mpool = alloc(arg, sizeof(uintptr_t),
                 sizeof(struct mempool_multiple_s) +
-                npools * sizeof(struct mempool_s));
+                npools * sizeof(struct mempool_s)
+#ifdef CONFIG_MM_HEAP_MEMPOOL_MAGAZINE
+                + CONFIG_SMP_NCPUS * npools * sizeof(struct mpool_magazine_s)
+#endif
+                );
 
   if (mpool == NULL)
     {
@@ -453,6 +628,12 @@ mempool_multiple_init(FAR const char *name,
   mpool->minpoolsize = minpoolsize;
   mpool->delta = 0;
 
+#ifdef CONFIG_MM_HEAP_MEMPOOL_MAGAZINE
+  mpool->magazines = (FAR struct mpool_magazine_s *)(pools + npools);
+  memset(mpool->magazines, 0,
+         CONFIG_SMP_NCPUS * npools * sizeof(struct mpool_magazine_s));
+#endif
+
   for (i = 0; i < npools; i++)
     {
       pools[i].blocksize = poolsize[i];
@@ -547,7 +728,7 @@ FAR void *mempool_multiple_alloc(FAR struct mempool_multiple_s *mpool,
   end = mpool->pools + mpool->npools;
   do
     {
-      FAR void *blk = mempool_allocate(pool);
+      FAR void *blk = mempool_multiple_allocate(mpool, pool);
 
       if (blk)
         {
@@ -634,7 +815,11 @@ int mempool_multiple_free(FAR struct mempool_multiple_s *mpool,
                             ((FAR char *)kasan_clear_tag(dict->addr) +
                              mpool->minpoolsize)) %
                            MEMPOOL_REALBLOCKSIZE(dict->pool));
+#ifdef CONFIG_MM_HEAP_MEMPOOL_MAGAZINE
+  mempool_multiple_magazine_free(mpool, dict->pool, blk);
+#else
   mempool_release(dict->pool, blk);
+#endif
   return 0;
 }
 
@@ -713,7 +898,7 @@ FAR void *mempool_multiple_memalign(FAR struct mempool_multiple_s *mpool,
   end = mpool->pools + mpool->npools;
   do
     {
-      FAR char *blk = mempool_allocate(pool);
+      FAR char *blk = mempool_multiple_allocate(mpool, pool);
       if (blk != NULL)
         {
           return (FAR void *)ALIGN_UP((uintptr_t)blk, alignment);
@@ -773,8 +958,26 @@ mempool_multiple_mallinfo(FAR struct mempool_multiple_s *mpool)
   for (i = 0; i < mpool->npools; i++)
     {
       struct mempoolinfo_s poolinfo;
+#ifdef CONFIG_MM_HEAP_MEMPOOL_MAGAZINE
+      int cpu;
+#endif
 
       mempool_info(mpool->pools + i, &poolinfo);
+#ifdef CONFIG_MM_HEAP_MEMPOOL_MAGAZINE
+
+      /* Blocks cached in the magazines are allocated from the pool's point
+       * of view, but they are free for the user of the multiple mempool.
+       */
+
+      for (cpu = 0; cpu < CONFIG_SMP_NCPUS; cpu++)
+        {
+          size_t cached = mpool->magazines[cpu * mpool->npools + i].nblks;
+
+          poolinfo.ordblks  += cached;
+          poolinfo.aordblks -= cached;
+        }
+#endif
+
       info.fordblks += (poolinfo.ordblks + poolinfo.iordblks)
                        * poolinfo.sizeblks;
       info.ordblks += poolinfo.ordblks + poolinfo.iordblks;
@@ -870,6 +1073,10 @@ void mempool_multiple_deinit(FAR struct mempool_multiple_s *mpool)
       return;
     }
 
+#ifdef CONFIG_MM_HEAP_MEMPOOL_MAGAZINE
+  mempool_multiple_magazine_drain(mpool);
+#endif
+
   for (i = 0; i < mpool->npools; i++)
     {
       DEBUGVERIFY(mempool_deinit(mpool->pools + i));
@@ -892,3 +1099,46 @@ void mempool_multiple_deinit(FAR struct mempool_multiple_s *mpool)
   nxrmutex_destroy(&mpool->lock);
   mpool->free(mpool->arg, mpool);
 }
+
+/****************************************************************************
+ * Name: mempool_multiple_magazine_info
+ *
+ * Description:
+ *   Get the per-CPU magazine statistics of a multiple memory pool.
+ *
+ * Input Parameters:
+ *   mpool - The handle of multiple memory pool to be used.
+ *   cpu   - The CPU whose magazines are queried.
+ *   info  - The pointer of magazine information to be filled in.
+ *
+ * Returned Value:
+ *   OK on success; A negated errno value on any failure.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_MM_HEAP_MEMPOOL_MAGAZINE
+int mempool_multiple_magazine_info(FAR struct mempool_multiple_s *mpool,
+                                   int cpu,
+                                   FAR struct mempool_magazineinfo_s *info)
+{
+  FAR struct mpool_magazine_s *mag;
+  size_t i;
+
+  if (mpool == NULL || cpu < 0 || cpu >= CONFIG_SMP_NCPUS)
+    {
+      return -EINVAL;
+    }
+
+  memset(info, 0, sizeof(*info));
+  mag = &mpool->magazines[cpu * mpool->npools];
+  for (i = 0; i < mpool->npools; i++)
+    {
+      info->hits   += mag[i].hits;
+      info->misses += mag[i].misses;
+      info->nblks  += mag[i].nblks;
+      info->size   += mag[i].nblks * mpool->pools[i].blocksize;
+    }
+
+  return OK;
+}
+#endif
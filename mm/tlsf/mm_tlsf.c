@@ -1699,6 +1699,23 @@ void mm_free_delaylist(FAR struct mm_heap_s *heap)
     }
 }
 
+/****************************************************************************
+ * Name: mm_magazineinfo
+ *
+ * Description:
+ *   Return the statistics of the per-CPU magazines of the heap's multiple
+ *   mempool for the given CPU.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_MM_HEAP_MEMPOOL_MAGAZINE
+int mm_magazineinfo(FAR struct mm_heap_s *heap, int cpu,
+                    FAR struct mempool_magazineinfo_s *info)
+{
+  return mempool_multiple_magazine_info(heap->mm_mpool, cpu, info);
+}
+#endif
+
 /****************************************************************************
  * Name: mm_heapfree
  *
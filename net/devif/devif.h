@@ -500,6 +500,24 @@ int devif_file_send(FAR struct net_driver_s *dev, FAR struct file *file,
                     unsigned int target_offset);
 #endif
 
+/****************************************************************************
+ * Name: devif_file_release
+ *
+ * Description:
+ *   Drop the file references held for zero-copy sendfile() that are no
+ *   longer used by any I/O buffer.
+ *
+ * Assumptions:
+ *   Called with the network locked.
+ *
+ ****************************************************************************/
+
+#if defined(CONFIG_MM_IOB) && defined(CONFIG_NET_SENDFILE_ZEROCOPY)
+void devif_file_release(void);
+#else
+#  define devif_file_release()
+#endif
+
 /****************************************************************************
  * Name: devif_out
  *
@@ -26,21 +26,279 @@
 
 #include <nuttx/config.h>
 
+#include <sys/stat.h>
 #include <string.h>
 #include <assert.h>
 #include <debug.h>
 #include <errno.h>
 
 #include <nuttx/fs/fs.h>
+#include <nuttx/fs/ioctl.h>
 #include <nuttx/mm/iob.h>
 #include <nuttx/net/netdev.h>
+#include <nuttx/spinlock.h>
+
+#include "devif/devif.h"
 
 #ifdef CONFIG_MM_IOB
 
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_SENDFILE_ZEROCOPY
+/* A file whose memory is attached in place to outgoing packets.  The
+ * private reference to the file keeps it, and so its memory, alive for as
+ * long as any I/O buffer may still point into it.
+ */
+
+struct devif_fileref_s
+{
+  struct file        fr_file;  /* Private reference to the file */
+  FAR const uint8_t *fr_base;  /* File memory, NULL if the slot is free */
+  off_t              fr_size;  /* File size when the slot was set up */
+  unsigned int       fr_refs;  /* Number of I/O buffers using the memory */
+};
+#endif
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_SENDFILE_ZEROCOPY
+static struct devif_fileref_s
+g_devif_filerefs[CONFIG_NET_SENDFILE_ZEROCOPY_NFILES];
+
+/* Protects fr_refs, which is decremented wherever an I/O buffer is freed.
+ * The slots themselves are only set up and torn down with the network
+ * locked.
+ */
+
+static spinlock_t g_devif_filelock = SP_UNLOCKED;
+#endif
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_SENDFILE_ZEROCOPY
+/****************************************************************************
+ * Name: devif_file_iobfree
+ *
+ * Description:
+ *   Called when an I/O buffer that points into file memory is freed.  This
+ *   may happen in any context, so only the reference count is dropped
+ *   here.  The file itself is closed by devif_file_release().
+ *
+ ****************************************************************************/
+
+static void devif_file_iobfree(FAR void *data)
+{
+  FAR const uint8_t *ptr = data;
+  FAR struct devif_fileref_s *ref;
+  irqstate_t flags;
+  int i;
+
+  flags = spin_lock_irqsave(&g_devif_filelock);
+  for (i = 0; i < CONFIG_NET_SENDFILE_ZEROCOPY_NFILES; i++)
+    {
+      ref = &g_devif_filerefs[i];
+      if (ref->fr_refs > 0 && ptr >= ref->fr_base &&
+          ptr < ref->fr_base + ref->fr_size)
+        {
+          ref->fr_refs--;
+          break;
+        }
+    }
+
+  spin_unlock_irqrestore(&g_devif_filelock, flags);
+}
+
+/****************************************************************************
+ * Name: devif_file_iob
+ *
+ * Description:
+ *   Return an I/O buffer that refers to 'len' bytes at 'offset' directly in
+ *   the memory of the file, or NULL if the file cannot be accessed in place
+ *   or no reference slot is available.  The caller then falls back to
+ *   copying the data.  Only memory that stays in place while the file is
+ *   open is used (see FIOC_XIPFIXED), since a packet may still refer to it
+ *   long after this call.
+ *
+ ****************************************************************************/
+
+static FAR struct iob_s *devif_file_iob(FAR struct file *file,
+                                        unsigned int len,
+                                        unsigned int offset)
+{
+  FAR struct devif_fileref_s *ref = NULL;
+  FAR struct devif_fileref_s *slot = NULL;
+  FAR struct iob_s *iob;
+  struct stat buf;
+  uintptr_t base = 0;
+  irqstate_t flags;
+  int i;
+
+  if (file_ioctl(file, FIOC_XIPFIXED,
+                 (unsigned long)((uintptr_t)&base)) < 0 || base == 0)
+    {
+      return NULL;
+    }
+
+  /* Find the slot of this file, or else a free one */
+
+  for (i = 0; i < CONFIG_NET_SENDFILE_ZEROCOPY_NFILES; i++)
+    {
+      if (g_devif_filerefs[i].fr_base == (FAR const uint8_t *)base)
+        {
+          ref = &g_devif_filerefs[i];
+          break;
+        }
+      else if (slot == NULL && g_devif_filerefs[i].fr_base == NULL)
+        {
+          slot = &g_devif_filerefs[i];
+        }
+    }
+
+  if (ref == NULL)
+    {
+      if (slot == NULL)
+        {
+          /* All slots are in use.  Close the idle ones for next time. */
+
+          devif_file_release();
+          return NULL;
+        }
+
+      if (file_fstat(file, &buf) < 0 ||
+          file_dup2(file, &slot->fr_file) < 0)
+        {
+          return NULL;
+        }
+
+      ref          = slot;
+      ref->fr_size = buf.st_size;
+      ref->fr_refs = 0;
+      ref->fr_base = (FAR const uint8_t *)base;
+    }
+
+  if ((off_t)offset + len > ref->fr_size)
+    {
+      return NULL;
+    }
+
+  iob = iob_alloc_with_data((FAR void *)(ref->fr_base + offset), len,
+                            devif_file_iobfree);
+  if (iob != NULL)
+    {
+      flags = spin_lock_irqsave(&g_devif_filelock);
+      ref->fr_refs++;
+      spin_unlock_irqrestore(&g_devif_filelock, flags);
+    }
+
+  return iob;
+}
+
+/****************************************************************************
+ * Name: devif_file_zerocopy
+ *
+ * Description:
+ *   Set up the device buffer as a header buffer sized exactly for the
+ *   'target_offset' bytes of protocol headers, followed by an I/O buffer
+ *   that points straight into the file memory.  Since the header buffer is
+ *   full, recomputing the packet length later on never spills headers or
+ *   payload into the file memory.
+ *
+ ****************************************************************************/
+
+static int devif_file_zerocopy(FAR struct net_driver_s *dev,
+                               FAR struct file *file,
+                               unsigned int len, unsigned int offset,
+                               unsigned int target_offset)
+{
+  FAR struct iob_s *head;
+  FAR struct iob_s *iob;
+  off_t pos;
+
+  iob = devif_file_iob(file, len, offset);
+  if (iob == NULL)
+    {
+      return -ENOSYS;
+    }
+
+  head = iob_alloc_dynamic(CONFIG_NET_LL_GUARDSIZE + target_offset);
+  if (head == NULL)
+    {
+      iob_free(iob);
+      return -ENOSYS;
+    }
+
+  /* Keep the file position where copying would have left it */
+
+  pos = file_seek(file, offset + len, SEEK_SET);
+  if (pos < 0)
+    {
+      iob_free(iob);
+      iob_free(head);
+      return pos;
+    }
+
+  iob_reserve(head, CONFIG_NET_LL_GUARDSIZE);
+  head->io_flink = iob;
+
+  netdev_iob_replace(dev, head);
+  iob_update_pktlen(head, target_offset + len, false);
+
+  dev->d_sndlen = len;
+  return len;
+}
+#endif
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
 
+#ifdef CONFIG_NET_SENDFILE_ZEROCOPY
+/****************************************************************************
+ * Name: devif_file_release
+ *
+ * Description:
+ *   Drop the private file references that are no longer used by any I/O
+ *   buffer.
+ *
+ * Assumptions:
+ *   Called with the network locked.
+ *
+ ****************************************************************************/
+
+void devif_file_release(void)
+{
+  FAR struct devif_fileref_s *ref;
+  irqstate_t flags;
+  bool idle;
+  int i;
+
+  for (i = 0; i < CONFIG_NET_SENDFILE_ZEROCOPY_NFILES; i++)
+    {
+      ref = &g_devif_filerefs[i];
+
+      flags = spin_lock_irqsave(&g_devif_filelock);
+      idle  = ref->fr_base != NULL && ref->fr_refs == 0;
+      if (idle)
+        {
+          ref->fr_base = NULL;
+        }
+
+      spin_unlock_irqrestore(&g_devif_filelock, flags);
+
+      if (idle)
+        {
+          file_close(&ref->fr_file);
+        }
+    }
+}
+#endif
+
 /****************************************************************************
  * Name: devif_file_send
  *
@@ -85,6 +343,20 @@ int devif_file_send(FAR struct net_driver_s *dev, FAR struct file *file,
     }
 #endif
 
+#ifdef CONFIG_NET_SENDFILE_ZEROCOPY
+  /* Attach the file data in place if the file allows it */
+
+  ret = devif_file_zerocopy(dev, file, len, offset, target_offset);
+  if (ret >= 0)
+    {
+      return ret;
+    }
+  else if (ret != -ENOSYS)
+    {
+      goto errout;
+    }
+#endif
+
   /* Append the send buffer after device buffer */
 
   if (len > iob_navail(false) * CONFIG_IOB_BUFSIZE ||
@@ -26,6 +26,9 @@
 
 #include <nuttx/config.h>
 
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <stdbool.h>
 #include <assert.h>
 #include <errno.h>
 
@@ -33,10 +36,39 @@
 #include <nuttx/fs/fs.h>
 #include <nuttx/net/net.h>
 
+#include "inet/inet.h"
 #include "socket/socket.h"
 
 #ifdef CONFIG_NET
 
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: psock_recvmsg_lends
+ *
+ * Description:
+ *   Return true if the socket is a UDP socket of the network stack, the
+ *   only kind that can lend its own buffers with MSG_ZEROCOPY and thus
+ *   accepts a msg_iov without a buffer.
+ *
+ ****************************************************************************/
+
+static bool psock_recvmsg_lends(FAR struct socket *psock, int flags)
+{
+#ifdef CONFIG_NET_UDP_RECV_ZEROCOPY
+  return (flags & MSG_ZEROCOPY) != 0 &&
+         (psock->s_domain == PF_INET || psock->s_domain == PF_INET6) &&
+         psock->s_type == SOCK_DGRAM &&
+         (psock->s_proto == 0 || psock->s_proto == IPPROTO_UDP) &&
+         psock->s_sockif == inet_sockif(psock->s_domain, psock->s_type,
+                                        psock->s_proto);
+#else
+  return false;
+#endif
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -78,7 +110,7 @@ ssize_t psock_recvmsg(FAR struct socket *psock, FAR struct msghdr *msg,
 
   /* Verify that non-NULL pointers were passed */
 
-  if (msg == NULL || msg->msg_iov == NULL || msg->msg_iov->iov_base == NULL)
+  if (msg == NULL || msg->msg_iov == NULL)
     {
       return -EINVAL;
     }
@@ -95,6 +127,13 @@ ssize_t psock_recvmsg(FAR struct socket *psock, FAR struct msghdr *msg,
       return -EBADF;
     }
 
+  /* Only a socket that lends its own buffers may be given none */
+
+  if (msg->msg_iov->iov_base == NULL && !psock_recvmsg_lends(psock, flags))
+    {
+      return -EINVAL;
+    }
+
   /* Let logic specific to this address family handle the recvmsg()
    * operation.
    */
@@ -57,6 +57,7 @@
 #include <arch/irq.h>
 
 #include <nuttx/clock.h>
+#include <nuttx/hashtable.h>
 #include <nuttx/kmalloc.h>
 #include <nuttx/net/netconfig.h>
 #include <nuttx/net/net.h>
@@ -95,10 +96,130 @@ NET_BUFPOOL_DECLARE(g_tcp_connections, sizeof(struct tcp_conn_s),
 
 static dq_queue_t g_active_tcp_connections;
 
+#ifdef CONFIG_NET_TCP_HASH
+/* The same active connections hashed by remote address and port pair */
+
+static DECLARE_HASHTABLE(g_tcp_conn_hash, CONFIG_NET_TCP_HASH_BITS);
+#endif
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: tcp_ipv4_hash_key
+ *
+ * Description:
+ *   Create a connection hash key from the remote IPv4 address and the port
+ *   pair.  The local address is not part of the key because a connection
+ *   bound to INADDR_ANY must match any destination address.
+ *
+ ****************************************************************************/
+
+#if defined(CONFIG_NET_TCP_HASH) && defined(CONFIG_NET_IPv4)
+static inline uint32_t tcp_ipv4_hash_key(in_addr_t raddr, uint16_t lport,
+                                         uint16_t rport)
+{
+  return NTOHL(raddr) ^ ((uint32_t)rport << 16) ^ lport;
+}
+#endif
+
+/****************************************************************************
+ * Name: tcp_ipv6_hash_key
+ *
+ * Description:
+ *   Create a connection hash key from the remote IPv6 address and the port
+ *   pair.
+ *
+ ****************************************************************************/
+
+#if defined(CONFIG_NET_TCP_HASH) && defined(CONFIG_NET_IPv6)
+static inline uint32_t tcp_ipv6_hash_key(FAR const uint16_t *raddr,
+                                         uint16_t lport, uint16_t rport)
+{
+  uint32_t key = (((uint32_t)raddr[0] << 16) | raddr[1]) ^
+                 (((uint32_t)raddr[2] << 16) | raddr[3]) ^
+                 (((uint32_t)raddr[4] << 16) | raddr[5]) ^
+                 (((uint32_t)raddr[6] << 16) | raddr[7]);
+
+  return key ^ ((uint32_t)rport << 16) ^ lport;
+}
+#endif
+
+/****************************************************************************
+ * Name: tcp_conn_hash_key
+ *
+ * Description:
+ *   Create the hash key of an active connection.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_TCP_HASH
+static uint32_t tcp_conn_hash_key(FAR struct tcp_conn_s *conn)
+{
+#ifdef CONFIG_NET_IPv6
+#ifdef CONFIG_NET_IPv4
+  if (conn->domain == PF_INET6)
+#endif
+    {
+      return tcp_ipv6_hash_key(conn->u.ipv6.raddr, conn->lport,
+                               conn->rport);
+    }
+#endif /* CONFIG_NET_IPv6 */
+
+#ifdef CONFIG_NET_IPv4
+#ifdef CONFIG_NET_IPv6
+  else
+#endif
+    {
+      return tcp_ipv4_hash_key(conn->u.ipv4.raddr, conn->lport,
+                               conn->rport);
+    }
+#endif /* CONFIG_NET_IPv4 */
+}
+#endif /* CONFIG_NET_TCP_HASH */
+
+/****************************************************************************
+ * Name: tcp_active_add
+ *
+ * Description:
+ *   Put a connection into the list of active connections.  The local and
+ *   remote addresses and ports must not change until the connection is
+ *   removed again with tcp_active_remove().
+ *
+ * Assumptions:
+ *   This function is called with the network locked.
+ *
+ ****************************************************************************/
+
+static void tcp_active_add(FAR struct tcp_conn_s *conn)
+{
+  dq_addlast(&conn->sconn.node, &g_active_tcp_connections);
+#ifdef CONFIG_NET_TCP_HASH
+  hashtable_add(g_tcp_conn_hash, &conn->hash_node, tcp_conn_hash_key(conn));
+#endif
+}
+
+/****************************************************************************
+ * Name: tcp_active_remove
+ *
+ * Description:
+ *   Remove a connection from the list of active connections.
+ *
+ * Assumptions:
+ *   This function is called with the network locked.
+ *
+ ****************************************************************************/
+
+static void tcp_active_remove(FAR struct tcp_conn_s *conn)
+{
+  dq_rem(&conn->sconn.node, &g_active_tcp_connections);
+#ifdef CONFIG_NET_TCP_HASH
+  hashtable_delete(g_tcp_conn_hash, &conn->hash_node,
+                   tcp_conn_hash_key(conn));
+#endif
+}
+
 /****************************************************************************
  * Name: tcp_listener
  *
@@ -174,6 +295,46 @@ static FAR struct tcp_conn_s *
   return NULL;
 }
 
+/****************************************************************************
+ * Name: tcp_ipv4_match
+ *
+ * Description:
+ *   Return true if the connection matches the addresses and ports of the
+ *   received IPv4 TCP segment.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_IPv4
+static inline bool tcp_ipv4_match(FAR struct tcp_conn_s *conn,
+                                  FAR struct tcp_hdr_s *tcp,
+                                  in_addr_t srcipaddr, in_addr_t destipaddr)
+{
+  /* Find an open connection matching the TCP input. The following
+   * checks are performed:
+   *
+   * - The local port number is checked against the destination port
+   *   number in the received packet.
+   * - The remote port number is checked if the connection is bound
+   *   to a remote port.
+   * - Insist that the destination IP matches the bound address. If
+   *   a socket is bound to INADDRY_ANY, then it should receive all
+   *   packets directed to the port.
+   * - Finally, if the connection is bound to a remote IP address,
+   *   the source IP address of the packet is checked.
+   *
+   * If all of the above are true then the newly received TCP packet
+   * is destined for this TCP connection.
+   */
+
+  return conn->tcpstateflags != TCP_CLOSED &&
+         tcp->destport == conn->lport &&
+         tcp->srcport  == conn->rport &&
+         (net_ipv4addr_cmp(conn->u.ipv4.laddr, INADDR_ANY) ||
+          net_ipv4addr_cmp(destipaddr, conn->u.ipv4.laddr)) &&
+         net_ipv4addr_cmp(srcipaddr, conn->u.ipv4.raddr);
+}
+#endif /* CONFIG_NET_IPv4 */
+
 /****************************************************************************
  * Name: tcp_ipv4_active
  *
@@ -194,36 +355,34 @@ static inline FAR struct tcp_conn_s *
   FAR struct tcp_conn_s *conn;
   in_addr_t srcipaddr;
   in_addr_t destipaddr;
+#ifdef CONFIG_NET_TCP_HASH
+  FAR hash_node_t *p;
+#endif
 
-  conn       = (FAR struct tcp_conn_s *)g_active_tcp_connections.head;
   srcipaddr  = net_ip4addr_conv32(ip->srcipaddr);
   destipaddr = net_ip4addr_conv32(ip->destipaddr);
 
-  while (conn)
+#ifdef CONFIG_NET_TCP_HASH
+  /* Only the connections hashing to the same bucket can match */
+
+  hashtable_for_every_possible(g_tcp_conn_hash, p,
+                               tcp_ipv4_hash_key(srcipaddr, tcp->destport,
+                                                 tcp->srcport))
     {
-      /* Find an open connection matching the TCP input. The following
-       * checks are performed:
-       *
-       * - The local port number is checked against the destination port
-       *   number in the received packet.
-       * - The remote port number is checked if the connection is bound
-       *   to a remote port.
-       * - Insist that the destination IP matches the bound address. If
-       *   a socket is bound to INADDRY_ANY, then it should receive all
-       *   packets directed to the port.
-       * - Finally, if the connection is bound to a remote IP address,
-       *   the source IP address of the packet is checked.
-       *
-       * If all of the above are true then the newly received TCP packet
-       * is destined for this TCP connection.
-       */
+      conn = container_of(p, struct tcp_conn_s, hash_node);
+      if (tcp_ipv4_match(conn, tcp, srcipaddr, destipaddr))
+        {
+          return conn;
+        }
+    }
+
+  return NULL;
+#else
+  conn = (FAR struct tcp_conn_s *)g_active_tcp_connections.head;
 
-      if (conn->tcpstateflags != TCP_CLOSED &&
-          tcp->destport == conn->lport &&
-          tcp->srcport  == conn->rport &&
-          (net_ipv4addr_cmp(conn->u.ipv4.laddr, INADDR_ANY) ||
-           net_ipv4addr_cmp(destipaddr, conn->u.ipv4.laddr)) &&
-          net_ipv4addr_cmp(srcipaddr, conn->u.ipv4.raddr))
+  while (conn)
+    {
+      if (tcp_ipv4_match(conn, tcp, srcipaddr, destipaddr))
         {
           /* Matching connection found.. break out of the loop and return a
            * reference to it.
@@ -238,9 +397,51 @@ static inline FAR struct tcp_conn_s *
     }
 
   return conn;
+#endif
 }
 #endif /* CONFIG_NET_IPv4 */
 
+/****************************************************************************
+ * Name: tcp_ipv6_match
+ *
+ * Description:
+ *   Return true if the connection matches the addresses and ports of the
+ *   received IPv6 TCP segment.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_IPv6
+static inline bool tcp_ipv6_match(FAR struct tcp_conn_s *conn,
+                                  FAR struct tcp_hdr_s *tcp,
+                                  FAR net_ipv6addr_t *srcipaddr,
+                                  FAR net_ipv6addr_t *destipaddr)
+{
+  /* Find an open connection matching the TCP input. The following
+   * checks are performed:
+   *
+   * - The local port number is checked against the destination port
+   *   number in the received packet.
+   * - The remote port number is checked if the connection is bound
+   *   to a remote port.
+   * - Insist that the destination IP matches the bound address. If
+   *   a socket is bound to the IPv6 unspecified address, then it
+   *   should receive all packets directed to the port.
+   * - Finally, if the connection is bound to a remote IP address,
+   *   the source IP address of the packet is checked.
+   *
+   * If all of the above are true then the newly received TCP packet
+   * is destined for this TCP connection.
+   */
+
+  return conn->tcpstateflags != TCP_CLOSED &&
+         tcp->destport == conn->lport &&
+         tcp->srcport  == conn->rport &&
+         (net_ipv6addr_cmp(conn->u.ipv6.laddr, g_ipv6_unspecaddr) ||
+          net_ipv6addr_cmp(*destipaddr, conn->u.ipv6.laddr)) &&
+         net_ipv6addr_cmp(*srcipaddr, conn->u.ipv6.raddr);
+}
+#endif /* CONFIG_NET_IPv6 */
+
 /****************************************************************************
  * Name: tcp_ipv6_active
  *
@@ -261,36 +462,34 @@ static inline FAR struct tcp_conn_s *
   FAR struct tcp_conn_s *conn;
   net_ipv6addr_t *srcipaddr;
   net_ipv6addr_t *destipaddr;
+#ifdef CONFIG_NET_TCP_HASH
+  FAR hash_node_t *p;
+#endif
 
-  conn       = (FAR struct tcp_conn_s *)g_active_tcp_connections.head;
   srcipaddr  = (net_ipv6addr_t *)ip->srcipaddr;
   destipaddr = (net_ipv6addr_t *)ip->destipaddr;
 
-  while (conn)
+#ifdef CONFIG_NET_TCP_HASH
+  /* Only the connections hashing to the same bucket can match */
+
+  hashtable_for_every_possible(g_tcp_conn_hash, p,
+                               tcp_ipv6_hash_key(*srcipaddr, tcp->destport,
+                                                 tcp->srcport))
     {
-      /* Find an open connection matching the TCP input. The following
-       * checks are performed:
-       *
-       * - The local port number is checked against the destination port
-       *   number in the received packet.
-       * - The remote port number is checked if the connection is bound
-       *   to a remote port.
-       * - Insist that the destination IP matches the bound address. If
-       *   a socket is bound to the IPv6 unspecified address, then it
-       *   should receive all packets directed to the port.
-       * - Finally, if the connection is bound to a remote IP address,
-       *   the source IP address of the packet is checked.
-       *
-       * If all of the above are true then the newly received TCP packet
-       * is destined for this TCP connection.
-       */
+      conn = container_of(p, struct tcp_conn_s, hash_node);
+      if (tcp_ipv6_match(conn, tcp, srcipaddr, destipaddr))
+        {
+          return conn;
+        }
+    }
 
-      if (conn->tcpstateflags != TCP_CLOSED &&
-          tcp->destport == conn->lport &&
-          tcp->srcport  == conn->rport &&
-          (net_ipv6addr_cmp(conn->u.ipv6.laddr, g_ipv6_unspecaddr) ||
-           net_ipv6addr_cmp(*destipaddr, conn->u.ipv6.laddr)) &&
-          net_ipv6addr_cmp(*srcipaddr, conn->u.ipv6.raddr))
+  return NULL;
+#else
+  conn = (FAR struct tcp_conn_s *)g_active_tcp_connections.head;
+
+  while (conn)
+    {
+      if (tcp_ipv6_match(conn, tcp, srcipaddr, destipaddr))
         {
           /* Matching connection found.. break out of the loop and return a
            * reference to it.
@@ -305,6 +504,7 @@ static inline FAR struct tcp_conn_s *
     }
 
   return conn;
+#endif
 }
 #endif /* CONFIG_NET_IPv6 */
 
@@ -859,7 +1059,7 @@ void tcp_free(FAR struct tcp_conn_s *conn)
     {
       /* Remove the connection from the active list */
 
-      dq_rem(&conn->sconn.node, &g_active_tcp_connections);
+      tcp_active_remove(conn);
     }
 
   tcp_free_rx_buffers(conn);
@@ -887,6 +1087,10 @@ void tcp_free(FAR struct tcp_conn_s *conn)
 
 #endif
 
+  /* Let go of the files sent in place that no packet refers to anymore */
+
+  devif_file_release();
+
 #ifdef CONFIG_NET_TCPBACKLOG
   /* Remove any backlog attached to this connection */
 
@@ -1156,7 +1360,7 @@ FAR struct tcp_conn_s *tcp_alloc_accept(FAR struct net_driver_s *dev,
        * Interrupts should already be disabled in this context.
        */
 
-      dq_addlast(&conn->sconn.node, &g_active_tcp_connections);
+      tcp_active_add(conn);
       tcp_update_retrantimer(conn, TCP_RTO);
     }
 
@@ -1467,7 +1671,7 @@ int tcp_connect(FAR struct tcp_conn_s *conn, FAR const struct sockaddr *addr)
 
   /* And, finally, put the connection structure into the active list. */
 
-  dq_addlast(&conn->sconn.node, &g_active_tcp_connections);
+  tcp_active_add(conn);
   ret = OK;
 
 errout_with_lock:
@@ -50,6 +50,7 @@
 #include <stdbool.h>
 #include <debug.h>
 
+#include <nuttx/hashtable.h>
 #include <nuttx/net/netconfig.h>
 #include <nuttx/net/net.h>
 
@@ -63,12 +64,74 @@
 
 /* The tcp_listenports list all currently listening ports. */
 
+#ifdef CONFIG_NET_TCP_HASH
+static DECLARE_HASHTABLE(g_tcp_listen_hash, CONFIG_NET_TCP_HASH_BITS);
+#else
 static FAR struct tcp_conn_s *tcp_listenports[CONFIG_NET_MAX_LISTENPORTS];
+#endif
 
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: tcp_listenmatch
+ *
+ * Description:
+ *   Return true if the connection listens on this port and address
+ *
+ ****************************************************************************/
+
+#if defined(CONFIG_NET_IPv4) && defined(CONFIG_NET_IPv6)
+static bool tcp_listenmatch(FAR struct tcp_conn_s *conn,
+                            FAR union ip_binding_u *uaddr,
+                            uint16_t portno, uint8_t domain)
+#else
+static bool tcp_listenmatch(FAR struct tcp_conn_s *conn,
+                            FAR union ip_binding_u *uaddr,
+                            uint16_t portno)
+#endif
+{
+  /* Does the connection have the same local port number? */
+
+#if defined(CONFIG_NET_IPv4) && defined(CONFIG_NET_IPv6)
+  if (conn == NULL || conn->lport != portno || conn->domain != domain)
+#else
+  if (conn == NULL || conn->lport != portno)
+#endif
+    {
+      return false;
+    }
+
+#ifdef CONFIG_NET_IPv6
+#  ifdef CONFIG_NET_IPv4
+  if (domain == PF_INET6)
+#  endif
+    {
+      if (net_ipv6addr_cmp(conn->u.ipv6.laddr, uaddr->ipv6.laddr) ||
+          net_ipv6addr_cmp(conn->u.ipv6.laddr, g_ipv6_unspecaddr))
+        {
+          return true;
+        }
+    }
+#endif
+
+#ifdef CONFIG_NET_IPv4
+#  ifdef CONFIG_NET_IPv6
+  if (domain == PF_INET)
+#  endif
+    {
+      if (net_ipv4addr_cmp(conn->u.ipv4.laddr, uaddr->ipv4.laddr) ||
+          net_ipv4addr_cmp(conn->u.ipv4.laddr, INADDR_ANY))
+        {
+          return true;
+        }
+    }
+#endif
+
+  return false;
+}
+
 /****************************************************************************
  * Name: tcp_findlistener
  *
@@ -89,54 +152,46 @@ FAR struct tcp_conn_s *tcp_findlistener(FAR union ip_binding_u *uaddr,
                                         uint16_t portno)
 #endif
 {
-  int ndx;
+  FAR struct tcp_conn_s *conn;
+#ifdef CONFIG_NET_TCP_HASH
+  FAR hash_node_t *p;
 
-  /* Examine each connection structure in each slot of the listener list */
+  /* Examine each listener hashed by this local port number */
 
-  for (ndx = 0; ndx < CONFIG_NET_MAX_LISTENPORTS; ndx++)
+  hashtable_for_every_possible(g_tcp_listen_hash, p, portno)
     {
-      /* Is this slot assigned?  If so, does the connection have the same
-       * local port number?
-       */
+      conn = container_of(p, struct tcp_conn_s, listen_node);
+#  if defined(CONFIG_NET_IPv4) && defined(CONFIG_NET_IPv6)
+      if (tcp_listenmatch(conn, uaddr, portno, domain))
+#  else
+      if (tcp_listenmatch(conn, uaddr, portno))
+#  endif
+        {
+          /* Yes.. we found a listener on this port */
 
-      FAR struct tcp_conn_s *conn = tcp_listenports[ndx];
-#if defined(CONFIG_NET_IPv4) && defined(CONFIG_NET_IPv6)
-      if (conn && conn->lport == portno && conn->domain == domain)
+          return conn;
+        }
+    }
 #else
-      if (conn && conn->lport == portno)
-#endif
-        {
-#ifdef CONFIG_NET_IPv6
-#  ifdef CONFIG_NET_IPv4
-          if (domain == PF_INET6)
-#  endif
-            {
-              if (net_ipv6addr_cmp(conn->u.ipv6.laddr, uaddr->ipv6.laddr) ||
-                  net_ipv6addr_cmp(conn->u.ipv6.laddr, g_ipv6_unspecaddr))
-                {
-                  /* Yes.. we found a listener on this port */
+  int ndx;
 
-                  return conn;
-                }
-            }
-#endif
+  /* Examine each connection structure in each slot of the listener list */
 
-#ifdef CONFIG_NET_IPv4
-#  ifdef CONFIG_NET_IPv6
-          if (domain == PF_INET)
+  for (ndx = 0; ndx < CONFIG_NET_MAX_LISTENPORTS; ndx++)
+    {
+      conn = tcp_listenports[ndx];
+#  if defined(CONFIG_NET_IPv4) && defined(CONFIG_NET_IPv6)
+      if (tcp_listenmatch(conn, uaddr, portno, domain))
+#  else
+      if (tcp_listenmatch(conn, uaddr, portno))
 #  endif
-            {
-              if (net_ipv4addr_cmp(conn->u.ipv4.laddr, uaddr->ipv4.laddr) ||
-                  net_ipv4addr_cmp(conn->u.ipv4.laddr, INADDR_ANY))
-                {
-                  /* Yes.. we found a listener on this port */
+        {
+          /* Yes.. we found a listener on this port */
 
-                  return conn;
-                }
-            }
-#endif
+          return conn;
         }
     }
+#endif
 
   /* No listener for this port */
 
@@ -160,10 +215,25 @@ FAR struct tcp_conn_s *tcp_findlistener(FAR union ip_binding_u *uaddr,
 
 int tcp_unlisten(FAR struct tcp_conn_s *conn)
 {
+#ifdef CONFIG_NET_TCP_HASH
+  FAR hash_node_t *p;
+#else
   int ndx;
+#endif
   int ret = -EINVAL;
 
   net_lock();
+#ifdef CONFIG_NET_TCP_HASH
+  hashtable_for_every_possible(g_tcp_listen_hash, p, conn->lport)
+    {
+      if (p == &conn->listen_node)
+        {
+          hashtable_delete(g_tcp_listen_hash, p, conn->lport);
+          ret = OK;
+          break;
+        }
+    }
+#else
   for (ndx = 0; ndx < CONFIG_NET_MAX_LISTENPORTS; ndx++)
     {
       if (tcp_listenports[ndx] == conn)
@@ -173,6 +243,7 @@ int tcp_unlisten(FAR struct tcp_conn_s *conn)
           break;
         }
     }
+#endif
 
   net_unlock();
   return ret;
@@ -191,7 +262,9 @@ int tcp_unlisten(FAR struct tcp_conn_s *conn)
 
 int tcp_listen(FAR struct tcp_conn_s *conn)
 {
+#ifndef CONFIG_NET_TCP_HASH
   int ndx;
+#endif
   int ret;
 
   /* This must be done with network locked because the listener table
@@ -218,6 +291,10 @@ int tcp_listen(FAR struct tcp_conn_s *conn)
        * "listener" list.
        */
 
+#ifdef CONFIG_NET_TCP_HASH
+      hashtable_add(g_tcp_listen_hash, &conn->listen_node, conn->lport);
+      ret = OK;
+#else
       ret = -ENOBUFS; /* Assume failure */
 
       /* Search all slots until an available slot is found */
@@ -235,6 +312,7 @@ int tcp_listen(FAR struct tcp_conn_s *conn)
               break;
             }
         }
+#endif
     }
 
   net_unlock();
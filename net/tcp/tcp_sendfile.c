@@ -538,6 +538,10 @@ ssize_t tcp_sendfile(FAR struct socket *psock, FAR struct file *infile,
 
   tcp_callback_free(conn, state.snd_cb);
 
+  /* Let go of the input file if no packet refers to its memory anymore */
+
+  devif_file_release();
+
 errout_locked:
   nxsem_destroy(&state.snd_sem);
 #ifdef CONFIG_NET_TCP_WRITE_BUFFERS
@@ -32,6 +32,7 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 
+#include <nuttx/mutex.h>
 #include <nuttx/queue.h>
 #include <nuttx/semaphore.h>
 #include <nuttx/net/ip.h>
@@ -67,6 +68,20 @@
 #define udp_callback_free(dev,conn,cb) \
   devif_conn_callback_free((dev), (cb), &(conn)->sconn.list, &(conn)->sconn.list_tail)
 
+/* Lock the read-ahead queue of a connection.  Without
+ * CONFIG_NET_UDP_READAHEAD_LOCK the queue is protected by the network lock.
+ * The network lock may be held when this is taken, but must not be taken
+ * while holding it.
+ */
+
+#ifdef CONFIG_NET_UDP_READAHEAD_LOCK
+#  define udp_readahead_lock(conn)   nxmutex_lock(&(conn)->rdlock)
+#  define udp_readahead_unlock(conn) nxmutex_unlock(&(conn)->rdlock)
+#else
+#  define udp_readahead_lock(conn)
+#  define udp_readahead_unlock(conn)
+#endif
+
 /* Definitions for the UDP connection struct flag field */
 
 #define _UDP_FLAG_CONNECTMODE (1 << 0) /* Bit 0:  UDP connection-mode */
@@ -133,6 +148,23 @@ struct udp_conn_s
    */
 
   FAR struct iob_s *readahead;   /* Read-ahead buffering */
+#ifdef CONFIG_NET_UDP_READAHEAD_LOCK
+  mutex_t rdlock;                /* Protects readahead */
+#endif
+
+#ifdef CONFIG_NET_UDP_RECV_ZEROCOPY
+  /* Datagrams lent to the user by recvmsg(MSG_ZEROCOPY) and not yet
+   * released with the UDP_ZEROCOPY_RELEASE socket option.
+   */
+
+  FAR struct iob_s *zcbufs[CONFIG_NET_UDP_RECV_ZEROCOPY_NBUFS];
+
+  /* The first iov_base handed to the user for each entry of zcbufs[], by
+   * which UDP_ZEROCOPY_RELEASE identifies the datagram.
+   */
+
+  FAR void *zcaddrs[CONFIG_NET_UDP_RECV_ZEROCOPY_NBUFS];
+#endif
 
 #ifdef CONFIG_NET_UDP_WRITE_BUFFERS
   /* Write buffering
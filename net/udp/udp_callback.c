@@ -79,11 +79,15 @@ static uint16_t udp_datahandler(FAR struct net_driver_s *dev,
   int offset;
 
 #if CONFIG_NET_RECV_BUFSIZE > 0
+  udp_readahead_lock(conn);
   if (conn->readahead && conn->readahead->io_pktlen > conn->rcvbufs)
     {
+      udp_readahead_unlock(conn);
       netdev_iob_release(dev);
       return 0;
     }
+
+  udp_readahead_unlock(conn);
 #endif
 
   iob = dev->d_iob;
@@ -213,7 +217,9 @@ static uint16_t udp_datahandler(FAR struct net_driver_s *dev,
 
   /* Concat the iob to readahead */
 
+  udp_readahead_lock(conn);
   net_iob_concat(&conn->readahead, &iob);
+  udp_readahead_unlock(conn);
 
 #ifdef CONFIG_NET_UDP_NOTIFIER
   ninfo("Buffered %d bytes\n", buflen);
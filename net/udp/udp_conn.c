@@ -593,6 +593,13 @@ FAR struct udp_conn_s *udp_alloc(uint8_t domain)
       /* Initialize the write buffer lists */
 
       sq_init(&conn->write_q);
+#endif
+#ifdef CONFIG_NET_UDP_RECV_ZEROCOPY
+      memset(conn->zcbufs, 0, sizeof(conn->zcbufs));
+      memset(conn->zcaddrs, 0, sizeof(conn->zcaddrs));
+#endif
+#ifdef CONFIG_NET_UDP_READAHEAD_LOCK
+      nxmutex_init(&conn->rdlock);
 #endif
       /* Enqueue the connection into the active list */
 
@@ -617,6 +624,9 @@ void udp_free(FAR struct udp_conn_s *conn)
 #ifdef CONFIG_NET_UDP_WRITE_BUFFERS
   FAR struct udp_wrbuffer_s *wrbuffer;
 #endif
+#ifdef CONFIG_NET_UDP_RECV_ZEROCOPY
+  int i;
+#endif
 
   /* The free list is protected by a mutex. */
 
@@ -633,6 +643,17 @@ void udp_free(FAR struct udp_conn_s *conn)
 
   iob_free_chain(conn->readahead);
 
+#ifdef CONFIG_NET_UDP_RECV_ZEROCOPY
+  /* Reclaim the datagrams the user never released */
+
+  for (i = 0; i < CONFIG_NET_UDP_RECV_ZEROCOPY_NBUFS; i++)
+    {
+      iob_free_chain(conn->zcbufs[i]);
+      conn->zcbufs[i]  = NULL;
+      conn->zcaddrs[i] = NULL;
+    }
+#endif
+
 #ifdef CONFIG_NET_UDP_WRITE_BUFFERS
   /* Release any write buffers attached to the connection */
 
@@ -648,6 +669,10 @@ void udp_free(FAR struct udp_conn_s *conn)
   udp_sendbuffer_notify(conn);
 #endif /* CONFIG_NET_SEND_BUFSIZE */
 
+#endif
+
+#ifdef CONFIG_NET_UDP_READAHEAD_LOCK
+  nxmutex_destroy(&conn->rdlock);
 #endif
 
   /* Free the connection. */
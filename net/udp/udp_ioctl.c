@@ -118,6 +118,7 @@ int udp_ioctl(FAR struct udp_conn_s *conn, int cmd, unsigned long arg)
   switch (cmd)
     {
       case FIONREAD:
+        udp_readahead_lock(conn);
         iob = conn->readahead;
         if (iob)
           {
@@ -129,6 +130,8 @@ int udp_ioctl(FAR struct udp_conn_s *conn, int cmd, unsigned long arg)
           {
             *(FAR int *)((uintptr_t)arg) = 0;
           }
+
+        udp_readahead_unlock(conn);
         break;
       case FIONSPACE:
 #ifdef CONFIG_NET_UDP_WRITE_BUFFERS
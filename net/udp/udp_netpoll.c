@@ -210,6 +210,7 @@ int udp_pollsetup(FAR struct socket *psock, FAR struct pollfd *fds)
 
   /* Check for read data availability now */
 
+  udp_readahead_lock(conn);
   if (conn->readahead != NULL)
     {
       /* Normal data may be read without blocking. */
@@ -217,6 +218,8 @@ int udp_pollsetup(FAR struct socket *psock, FAR struct pollfd *fds)
       eventset |= POLLRDNORM;
     }
 
+  udp_readahead_unlock(conn);
+
   if (psock_udp_cansend(conn) >= 0)
     {
       /* Normal data may be sent without blocking (at least one byte). */
@@ -27,10 +27,12 @@
 #include <nuttx/config.h>
 
 #include <sys/types.h>
+#include <stdbool.h>
 #include <assert.h>
 
 #include <nuttx/wqueue.h>
 #include <nuttx/mm/iob.h>
+#include <nuttx/net/net.h>
 
 #include "udp/udp.h"
 
@@ -71,6 +73,7 @@ int udp_readahead_notifier_setup(worker_t worker,
                                  FAR void *arg)
 {
   struct work_notifier_s info;
+  bool ready;
 
   DEBUGASSERT(worker != NULL);
 
@@ -78,7 +81,11 @@ int udp_readahead_notifier_setup(worker_t worker,
    * setting up the notification.
    */
 
-  if (conn->readahead != NULL)
+  udp_readahead_lock(conn);
+  ready = conn->readahead != NULL;
+  udp_readahead_unlock(conn);
+
+  if (ready)
     {
       return 0;
     }
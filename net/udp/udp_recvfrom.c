@@ -33,6 +33,7 @@
 #include <assert.h>
 
 #include <sys/time.h>
+#include <nuttx/clock.h>
 #include <nuttx/semaphore.h>
 #include <nuttx/net/net.h>
 #include <nuttx/mm/iob.h>
@@ -170,71 +171,116 @@ static inline size_t udp_recvfrom_newdata(FAR struct net_driver_s *dev,
   return recvlen;
 }
 
-static inline void udp_readahead(struct udp_recvfrom_s *pstate)
-{
-  FAR struct udp_conn_s *conn = pstate->ir_conn;
-  FAR struct iob_s *iob;
-
-  /* Check there is any UDP datagram already buffered in a read-ahead
-   * buffer.
-   */
-
-  pstate->ir_recvlen = -1;
+/****************************************************************************
+ * Name: udp_readahead_header
+ *
+ * Description:
+ *   Unpack the meta information saved in front of the datagram at the head
+ *   of the read-ahead buffer, and return the sender address, packet info
+ *   and timestamp to the caller as requested.
+ *
+ * Input Parameters:
+ *   pstate   recvfrom state structure
+ *   iob      The read-ahead I/O buffer chain
+ *   datalen  Location to return the length of the datagram payload
+ *
+ * Returned Value:
+ *   The offset of the datagram payload in the I/O buffer chain.
+ *
+ * Assumptions:
+ *   The connection is locked.
+ *
+ ****************************************************************************/
 
-  if ((iob = conn->readahead) != NULL)
-    {
-      int recvlen;
-      int offset = 0;
-      uint16_t datalen;
-      uint8_t src_addr_size;
-      uint8_t ifindex;
+static int udp_readahead_header(FAR struct udp_recvfrom_s *pstate,
+                                FAR struct iob_s *iob,
+                                FAR uint16_t *datalen)
+{
+  int recvlen;
+  int offset = 0;
+  uint8_t src_addr_size;
+  uint8_t ifindex;
 #ifdef CONFIG_NET_IPv6
-      uint8_t srcaddr[sizeof(struct sockaddr_in6)];
+  uint8_t srcaddr[sizeof(struct sockaddr_in6)];
 #else
-      uint8_t srcaddr[sizeof(struct sockaddr_in)];
+  uint8_t srcaddr[sizeof(struct sockaddr_in)];
 #endif
 
-      /* Unflatten saved connection information
-       * Layout: |datalen|ifindex|src_addr_size|src_addr|[timestamp]|data|
-       */
+  /* Unflatten saved connection information
+   * Layout: |datalen|ifindex|src_addr_size|src_addr|[timestamp]|data|
+   */
 
-      recvlen = iob_copyout((FAR uint8_t *)&datalen, iob,
-                            sizeof(datalen), offset);
-      offset += sizeof(datalen);
-      DEBUGASSERT(recvlen == sizeof(datalen));
+  recvlen = iob_copyout((FAR uint8_t *)datalen, iob,
+                        sizeof(*datalen), offset);
+  offset += sizeof(*datalen);
+  DEBUGASSERT(recvlen == sizeof(*datalen));
 
 #ifdef CONFIG_NETDEV_IFINDEX
-      recvlen = iob_copyout(&ifindex, iob, sizeof(ifindex), offset);
-      offset += sizeof(ifindex);
-      DEBUGASSERT(recvlen == sizeof(ifindex));
+  recvlen = iob_copyout(&ifindex, iob, sizeof(ifindex), offset);
+  offset += sizeof(ifindex);
+  DEBUGASSERT(recvlen == sizeof(ifindex));
 #else
-      ifindex = 1;
+  ifindex = 1;
 #endif
-      recvlen = iob_copyout(&src_addr_size, iob,
-                            sizeof(src_addr_size), offset);
-      offset += sizeof(src_addr_size);
-      DEBUGASSERT(recvlen == sizeof(src_addr_size));
+  recvlen = iob_copyout(&src_addr_size, iob,
+                        sizeof(src_addr_size), offset);
+  offset += sizeof(src_addr_size);
+  DEBUGASSERT(recvlen == sizeof(src_addr_size));
 
-      recvlen = iob_copyout(srcaddr, iob, src_addr_size, offset);
-      offset += src_addr_size;
-      DEBUGASSERT(recvlen == src_addr_size);
+  recvlen = iob_copyout(srcaddr, iob, src_addr_size, offset);
+  offset += src_addr_size;
+  DEBUGASSERT(recvlen == src_addr_size);
 
 #ifdef CONFIG_NET_TIMESTAMP
-      /* Unpack stored timestamp if SO_TIMESTAMP socket option is enabled */
+  /* Unpack stored timestamp if SO_TIMESTAMP socket option is enabled */
 
-      if (conn->timestamp)
-        {
-          struct timespec timestamp;
-          recvlen = iob_copyout((FAR uint8_t *)&timestamp, iob,
-                                sizeof(struct timespec), offset);
-          DEBUGASSERT(recvlen == sizeof(struct timespec));
+  if (pstate->ir_conn->timestamp)
+    {
+      struct timespec timestamp;
+      recvlen = iob_copyout((FAR uint8_t *)&timestamp, iob,
+                            sizeof(struct timespec), offset);
+      DEBUGASSERT(recvlen == sizeof(struct timespec));
 
-          udp_store_cmsg_timestamp(pstate, &timestamp);
-        }
+      udp_store_cmsg_timestamp(pstate, &timestamp);
+    }
 
-      offset += sizeof(struct timespec);
+  offset += sizeof(struct timespec);
 #endif
 
+  if (pstate->ir_msg->msg_name)
+    {
+      pstate->ir_msg->msg_namelen =
+            src_addr_size > pstate->ir_msg->msg_namelen ?
+            pstate->ir_msg->msg_namelen : src_addr_size;
+
+      memcpy(pstate->ir_msg->msg_name, srcaddr,
+             pstate->ir_msg->msg_namelen);
+    }
+
+  udp_recvpktinfo(pstate, srcaddr, ifindex);
+  return offset;
+}
+
+static inline void udp_readahead(struct udp_recvfrom_s *pstate)
+{
+  FAR struct udp_conn_s *conn = pstate->ir_conn;
+  FAR struct iob_s *iob;
+
+  /* Check there is any UDP datagram already buffered in a read-ahead
+   * buffer.
+   */
+
+  pstate->ir_recvlen = -1;
+
+  udp_readahead_lock(conn);
+  if ((iob = conn->readahead) != NULL)
+    {
+      int recvlen;
+      int offset;
+      uint16_t datalen;
+
+      offset = udp_readahead_header(pstate, iob, &datalen);
+
       /* Copy to user */
 
       recvlen = iob_copyout(pstate->ir_msg->msg_iov->iov_base, iob,
@@ -248,18 +294,6 @@ static inline void udp_readahead(struct udp_recvfrom_s *pstate)
       ninfo("Received %d bytes (of %d, total %d)\n",
             recvlen, datalen, iob->io_pktlen);
 
-      if (pstate->ir_msg->msg_name)
-        {
-          pstate->ir_msg->msg_namelen =
-                src_addr_size > pstate->ir_msg->msg_namelen ?
-                pstate->ir_msg->msg_namelen : src_addr_size;
-
-          memcpy(pstate->ir_msg->msg_name, srcaddr,
-                 pstate->ir_msg->msg_namelen);
-        }
-
-      udp_recvpktinfo(pstate, srcaddr, ifindex);
-
       /* Remove the packet from the head of the I/O buffer chain. */
 
       if (!(pstate->ir_flags & MSG_PEEK))
@@ -275,8 +309,151 @@ static inline void udp_readahead(struct udp_recvfrom_s *pstate)
             }
         }
     }
+
+  udp_readahead_unlock(conn);
+}
+
+#ifdef CONFIG_NET_UDP_RECV_ZEROCOPY
+/****************************************************************************
+ * Name: udp_readahead_zerocopy
+ *
+ * Description:
+ *   Detach the datagram at the head of the read-ahead buffer and hand its
+ *   I/O buffers to the caller through msg_iov, one iovec per buffer.  The
+ *   buffers stay owned by the connection until the caller releases them
+ *   with the UDP_ZEROCOPY_RELEASE socket option.
+ *
+ * Input Parameters:
+ *   pstate   recvfrom state structure
+ *
+ * Returned Value:
+ *   None.  pstate->ir_recvlen is left at -1 if no datagram was taken.
+ *
+ ****************************************************************************/
+
+static void udp_readahead_zerocopy(FAR struct udp_recvfrom_s *pstate)
+{
+  FAR struct udp_conn_s *conn = pstate->ir_conn;
+  FAR struct msghdr *msg = pstate->ir_msg;
+  FAR struct iob_s *iob;
+  FAR struct iob_s *last;
+  uint16_t datalen;
+  size_t recvlen;
+  int consumed;
+  int offset;
+  int slot;
+  int i;
+
+  pstate->ir_recvlen = -1;
+
+  udp_readahead_lock(conn);
+  if ((iob = conn->readahead) == NULL)
+    {
+      goto out;
+    }
+
+  for (slot = 0; slot < CONFIG_NET_UDP_RECV_ZEROCOPY_NBUFS; slot++)
+    {
+      if (conn->zcbufs[slot] == NULL)
+        {
+          break;
+        }
+    }
+
+  if (slot >= CONFIG_NET_UDP_RECV_ZEROCOPY_NBUFS)
+    {
+      goto out;
+    }
+
+  offset = udp_readahead_header(pstate, iob, &datalen);
+
+  /* Each datagram was queued as its own buffer chain, so it ends exactly
+   * at a buffer boundary.  Cut the chain there.
+   */
+
+  last     = iob;
+  consumed = iob->io_len;
+  while (consumed < offset + datalen)
+    {
+      last      = last->io_flink;
+      consumed += last->io_len;
+    }
+
+  DEBUGASSERT(consumed == offset + datalen);
+
+  conn->readahead = last->io_flink;
+  if (conn->readahead != NULL)
+    {
+      conn->readahead->io_pktlen = iob->io_pktlen - consumed;
+    }
+
+  last->io_flink = NULL;
+  iob->io_pktlen = consumed;
+
+  /* Drop the meta information in front of the payload */
+
+  iob = iob_trimhead(iob, offset);
+  if (iob == NULL || iob->io_pktlen == 0)
+    {
+      iob_free_chain(iob);
+      msg->msg_iovlen    = 0;
+      pstate->ir_recvlen = 0;
+      goto out;
+    }
+
+  recvlen = 0;
+  for (i = 0, last = iob; last != NULL && i < msg->msg_iovlen;
+       last = last->io_flink)
+    {
+      if (last->io_len > 0)
+        {
+          msg->msg_iov[i].iov_base = last->io_data + last->io_offset;
+          msg->msg_iov[i].iov_len  = last->io_len;
+          recvlen += last->io_len;
+          i++;
+        }
+    }
+
+  if (last != NULL)
+    {
+      msg->msg_flags |= MSG_TRUNC;
+    }
+
+  msg->msg_iovlen     = i;
+  conn->zcbufs[slot]  = iob;
+  conn->zcaddrs[slot] = msg->msg_iov[0].iov_base;
+  pstate->ir_recvlen  = recvlen;
+
+  ninfo("Lent %zu bytes (of %d) in %d buffers\n", recvlen, datalen, i);
+
+out:
+  udp_readahead_unlock(conn);
 }
 
+/****************************************************************************
+ * Name: udp_recvfrom_readahead
+ *
+ * Description:
+ *   Take the next datagram from the read-ahead buffer, either by copying or
+ *   by lending its buffers, depending on MSG_ZEROCOPY.
+ *
+ ****************************************************************************/
+
+static void udp_recvfrom_readahead(FAR struct udp_recvfrom_s *pstate)
+{
+  if ((pstate->ir_flags & MSG_ZEROCOPY) != 0)
+    {
+      udp_readahead_zerocopy(pstate);
+    }
+  else
+    {
+      udp_readahead(pstate);
+    }
+}
+#else
+#  define udp_recvfrom_readahead(p) udp_readahead(p)
+#endif
+
 /****************************************************************************
  * Name: udp_sender
  *
@@ -465,6 +642,18 @@ static uint16_t udp_eventhandler(FAR struct net_driver_s *dev,
 
       /* If new data is available, then complete the read action. */
 
+#ifdef CONFIG_NET_UDP_RECV_ZEROCOPY
+      /* A zero-copy receive leaves the packet to udp_callback() so that it
+       * is queued as read-ahead data, then takes it from there.
+       */
+
+      else if ((flags & UDP_NEWDATA) != 0 &&
+               (pstate->ir_flags & MSG_ZEROCOPY) != 0)
+        {
+          udp_terminate(pstate, OK);
+        }
+#endif
+
       else if ((flags & UDP_NEWDATA) != 0)
         {
           /* Save packet timestamp, if requested */
@@ -682,24 +871,78 @@ ssize_t psock_udp_recvfrom(FAR struct socket *psock, FAR struct msghdr *msg,
   struct udp_callback_s info;
   struct udp_recvfrom_s state;
   ssize_t ret;
+#ifdef CONFIG_NET_UDP_RECV_ZEROCOPY
+  unsigned int timeout;
+  clock_t deadline;
+  clock_t now;
+  int i;
+#endif
 
   /* Perform the UDP recvfrom() operation */
 
+#ifdef CONFIG_NET_UDP_RECV_ZEROCOPY
+  if ((flags & MSG_ZEROCOPY) != 0)
+    {
+      if (msg->msg_iovlen < 1 || (flags & MSG_PEEK) != 0)
+        {
+          return -EINVAL;
+        }
+
+      /* Fail early if all the buffers we may lend are still in use */
+
+      udp_readahead_lock(conn);
+      for (i = 0; i < CONFIG_NET_UDP_RECV_ZEROCOPY_NBUFS; i++)
+        {
+          if (conn->zcbufs[i] == NULL)
+            {
+              break;
+            }
+        }
+
+      udp_readahead_unlock(conn);
+      if (i >= CONFIG_NET_UDP_RECV_ZEROCOPY_NBUFS)
+        {
+          return -ENOBUFS;
+        }
+    }
+  else
+#endif
   if (msg->msg_iovlen != 1)
     {
       return -ENOTSUP;
     }
 
-  /* Initialize the state structure.  This is done with the network locked
-   * because we don't want anything to happen until we are ready.
+  /* Initialize the state structure */
+
+  udp_recvfrom_initialize(conn, msg, &state, flags);
+
+#ifdef CONFIG_NET_UDP_READAHEAD_LOCK
+  /* Consume a datagram already in the read-ahead buffer holding only the
+   * read-ahead lock, so that the common case does not contend for the
+   * network lock with unrelated sockets.
    */
 
+  udp_recvfrom_readahead(&state);
+  if (state.ir_recvlen >= 0)
+    {
+      ret = state.ir_recvlen;
+#ifdef CONFIG_NETDEV_RSS
+      net_lock();
+      udp_notify_recvcpu(conn);
+      net_unlock();
+#endif
+      udp_recvfrom_uninitialize(&state);
+      return ret;
+    }
+#endif
+
+  /* Nothing happens with the network locked until we are ready */
+
   net_lock();
-  udp_recvfrom_initialize(conn, msg, &state, flags);
 
   /* Copy the read-ahead data from the packet */
 
-  udp_readahead(&state);
+  udp_recvfrom_readahead(&state);
 
   /* The default return value is the number of bytes that we just copied
    * into the user buffer.  We will return this if the socket has become
@@ -742,6 +985,13 @@ ssize_t psock_udp_recvfrom(FAR struct socket *psock, FAR struct msghdr *msg,
 
       dev = udp_find_laddr_device(conn);
 
+#ifdef CONFIG_NET_UDP_RECV_ZEROCOPY
+      timeout  = _SO_TIMEOUT(conn->sconn.s_rcvtimeo);
+      deadline = clock_systime_ticks() + MSEC2TICK(timeout);
+
+    retry:
+#endif
+
       /* Set up the callback in the connection */
 
       state.ir_cb = udp_callback_alloc(dev, conn);
@@ -768,8 +1018,12 @@ ssize_t psock_udp_recvfrom(FAR struct socket *psock, FAR struct msghdr *msg,
            * received.
            */
 
+#ifdef CONFIG_NET_UDP_RECV_ZEROCOPY
+          ret = net_sem_timedwait(&state.ir_sem, timeout);
+#else
           ret = net_sem_timedwait(&state.ir_sem,
                               _SO_TIMEOUT(conn->sconn.s_rcvtimeo));
+#endif
           tls_cleanup_pop(tls_get_info(), 0);
           if (ret == -ETIMEDOUT)
             {
@@ -780,6 +1034,46 @@ ssize_t psock_udp_recvfrom(FAR struct socket *psock, FAR struct msghdr *msg,
 
           udp_callback_free(dev, conn, state.ir_cb);
           ret = udp_recvfrom_result(ret, &state);
+
+#ifdef CONFIG_NET_UDP_RECV_ZEROCOPY
+          /* The event handler left the datagram in the read-ahead buffer */
+
+          if (ret >= 0 && (flags & MSG_ZEROCOPY) != 0)
+            {
+              udp_readahead_zerocopy(&state);
+              if (state.ir_recvlen >= 0)
+                {
+                  ret = state.ir_recvlen;
+                }
+              else if (conn->readahead != NULL)
+                {
+                  /* Another receiver took the free zero-copy slots */
+
+                  ret = -ENOBUFS;
+                }
+              else if (timeout == UINT_MAX)
+                {
+                  /* The datagram that woke us never made it to the
+                   * read-ahead buffer, e.g. it was dropped by the rcvbufs
+                   * limit.  Wait for the next one.
+                   */
+
+                  goto retry;
+                }
+              else
+                {
+                  /* The same, for what is left of the timeout */
+
+                  now = clock_systime_ticks();
+                  ret = -EAGAIN;
+                  if (now < deadline)
+                    {
+                      timeout = TICK2MSEC(deadline - now);
+                      goto retry;
+                    }
+                }
+            }
+#endif
         }
       else
         {
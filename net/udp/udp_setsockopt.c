@@ -34,6 +34,7 @@
 #include <net/if.h>
 #include <netinet/udp.h>
 
+#include <nuttx/mm/iob.h>
 #include <nuttx/net/net.h>
 #include <nuttx/net/netdev.h>
 #include <nuttx/net/udp.h>
@@ -76,7 +77,52 @@
 int udp_setsockopt(FAR struct socket *psock, int option,
                    FAR const void *value, socklen_t value_len)
 {
-  return -ENOPROTOOPT;
+#ifdef CONFIG_NET_UDP_RECV_ZEROCOPY
+  FAR struct udp_conn_s *conn = psock->s_conn;
+  FAR const void *buf;
+  int ret;
+  int i;
+#endif
+
+  switch (option)
+    {
+#ifdef CONFIG_NET_UDP_RECV_ZEROCOPY
+      case UDP_ZEROCOPY_RELEASE:
+
+        /* The value is the first iov_base returned by
+         * recvmsg(MSG_ZEROCOPY) for the datagram to release.
+         */
+
+        if (value == NULL || value_len != sizeof(FAR void *))
+          {
+            return -EINVAL;
+          }
+
+        buf = *(FAR void * const *)value;
+        ret = -EINVAL;
+
+        udp_readahead_lock(conn);
+        for (i = 0; i < CONFIG_NET_UDP_RECV_ZEROCOPY_NBUFS; i++)
+          {
+            FAR struct iob_s *iob = conn->zcbufs[i];
+
+            if (iob != NULL && conn->zcaddrs[i] == buf)
+              {
+                iob_free_chain(iob);
+                conn->zcbufs[i]  = NULL;
+                conn->zcaddrs[i] = NULL;
+                ret = OK;
+                break;
+              }
+          }
+
+        udp_readahead_unlock(conn);
+        return ret;
+#endif
+
+      default:
+        return -ENOPROTOOPT;
+    }
 }
 
 #endif /* CONFIG_NET_UDPPROTO_OPTIONS */
@@ -33,6 +33,110 @@
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: chksum_block
+ *
+ * Description:
+ *   Calculate the one's complement sum of the 16-bit words of a buffer,
+ *   read in host byte order.  An odd trailing byte is padded with zero.
+ *
+ *   The words are summed 32 bits at a time into a 64-bit accumulator and
+ *   the carries are folded back once at the end.  A buffer starting at an
+ *   odd address is summed from the preceding even address and the bytes of
+ *   the result are swapped, which keeps all loads aligned.
+ *
+ * Input Parameters:
+ *   data - Beginning of the data to include in the checksum.
+ *   len  - Length of the data to include in the checksum.
+ *
+ * Returned Value:
+ *   The one's complement sum, in host byte order.
+ *
+ ****************************************************************************/
+
+#ifndef CONFIG_NET_ARCH_CHKSUM
+#ifdef CONFIG_LIBC_ARCH_CHKSUM
+#  define chksum_block(data, len) up_chksum(data, len)
+#else
+static uint16_t chksum_block(FAR const uint8_t *data, uint16_t len)
+{
+  FAR const uint32_t *data32;
+  uint64_t acc = 0;
+  bool swap = false;
+
+  if (len == 0)
+    {
+      return 0;
+    }
+
+  if (((uintptr_t)data & 1) != 0)
+    {
+#ifdef CONFIG_ENDIAN_BIG
+      acc = data[0];
+#else
+      acc = (uint16_t)data[0] << 8;
+#endif
+      swap = true;
+      data++;
+      len--;
+    }
+
+  if (len >= 2 && ((uintptr_t)data & 2) != 0)
+    {
+      acc += *(FAR const uint16_t *)data;
+      data += 2;
+      len  -= 2;
+    }
+
+  data32 = (FAR const uint32_t *)data;
+
+  while (len >= 16)
+    {
+      acc += (uint64_t)data32[0] + data32[1] + data32[2] + data32[3];
+      data32 += 4;
+      len    -= 16;
+    }
+
+  while (len >= 4)
+    {
+      acc += *data32++;
+      len -= 4;
+    }
+
+  data = (FAR const uint8_t *)data32;
+
+  if (len >= 2)
+    {
+      acc += *(FAR const uint16_t *)data;
+      data += 2;
+      len  -= 2;
+    }
+
+  if (len > 0)
+    {
+#ifdef CONFIG_ENDIAN_BIG
+      acc += (uint16_t)data[0] << 8;
+#else
+      acc += data[0];
+#endif
+    }
+
+  /* Fold the carries back into the low 16 bits */
+
+  acc = (acc & 0xffffffff) + (acc >> 32);
+  acc = (acc & 0xffffffff) + (acc >> 32);
+  acc = (acc & 0xffff) + (acc >> 16);
+  acc = (acc & 0xffff) + (acc >> 16);
+
+  if (swap)
+    {
+      acc = ((acc & 0xff) << 8) | (acc >> 8);
+    }
+
+  return (uint16_t)acc;
+}
+#endif /* CONFIG_LIBC_ARCH_CHKSUM */
+
 /****************************************************************************
  * Name: checksum
  *
@@ -53,57 +157,44 @@
  *
  ****************************************************************************/
 
-#ifndef CONFIG_NET_ARCH_CHKSUM
 uint16_t checksum(uint16_t sum, FAR const uint8_t *data,
                     uint16_t len, bool *odd)
 {
-  FAR const uint8_t *dataptr;
-  FAR const uint8_t *last_byte;
   uint16_t t;
 
-  dataptr = data;
-  last_byte = data + len - 1;
-
-  if (*odd == true)
+  if (len == 0)
     {
-      t = dataptr[0];
-      sum += t;
-      if (sum < t)
-        {
-          sum++; /* carry */
-        }
-
-      dataptr += 1;
+      return sum;
     }
 
-  while (dataptr < last_byte)
+  if (*odd == true)
     {
-      /* At least two more bytes */
+      /* The first byte completes the word started by the previous call */
 
-      t = ((uint16_t)dataptr[0] << 8) + dataptr[1];
+      t = data[0];
       sum += t;
       if (sum < t)
         {
           sum++; /* carry */
         }
 
-      dataptr += 2;
+      data += 1;
+      len  -= 1;
     }
 
-  *odd = false;
+  /* The sum of the byte-swapped words is the byte-swapped sum, so the
+   * words can be added in host byte order and converted once.
+   */
 
-  if (dataptr == last_byte)
+  t = NTOHS(chksum_block(data, len));
+  sum += t;
+  if (sum < t)
     {
-      t = (dataptr[0] << 8) + 0;
-      sum += t;
-      if (sum < t)
-        {
-          sum++; /* carry */
-        }
-
-      *odd = true;
+      sum++; /* carry */
     }
 
+  *odd = (len & 1) != 0;
+
   /* Return sum in host byte order. */
 
   return sum;
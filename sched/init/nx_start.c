@@ -405,7 +405,7 @@ static void idle_task_initialize(void)
 #ifdef CONFIG_SMP
       g_assignedtasks[i] = tcb;
 #else
-      dq_addfirst((FAR dq_entry_t *)tcb, TLIST_HEAD(tcb));
+      nxsched_add_rtrlist(tcb);
 #endif
 
       /* Mark the idle task as the running task */
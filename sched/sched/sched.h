@@ -324,6 +324,31 @@ bool nxsched_merge_pending(void);
 bool nxsched_reprioritize_rtr(FAR struct tcb_s *tcb, int priority);
 #endif
 
+/* Ready-to-run list insertion and removal.  With the priority bitmap these
+ * are O(1); otherwise they operate on the list directly.
+ */
+
+#ifdef CONFIG_SCHED_READYTORUN_BITMAP
+bool nxsched_add_rtrlist(FAR struct tcb_s *tcb);
+void nxsched_remove_rtrlist(FAR struct tcb_s *tcb);
+#else
+#  define nxsched_add_rtrlist(tcb) \
+     nxsched_add_prioritized(tcb, list_readytorun())
+#  define nxsched_remove_rtrlist(tcb) \
+     dq_rem((FAR dq_entry_t *)(tcb), list_readytorun())
+#endif
+
+/* Change the priority of the running task in place.  Only in the non-SMP
+ * case is the running task a member of the ready-to-run list.
+ */
+
+#if defined(CONFIG_SCHED_READYTORUN_BITMAP) && !defined(CONFIG_SMP)
+void nxsched_setprio_rtrlist(FAR struct tcb_s *tcb, int priority);
+#else
+#  define nxsched_setprio_rtrlist(tcb, priority) \
+     ((tcb)->sched_priority = (uint8_t)(priority))
+#endif
+
 /* Priority inheritance support */
 
 #ifdef CONFIG_PRIORITY_INHERITANCE
@@ -439,6 +464,14 @@ void nxsched_critmon_csection(FAR struct tcb_s *tcb, bool state,
                               FAR void *caller);
 #endif
 
+/* Lock contention statistics */
+
+#ifdef CONFIG_SCHED_LOCKSTAT
+void nxsched_lockstat_sem(FAR sem_t *sem, bool contended, clock_t wait);
+#else
+#  define nxsched_lockstat_sem(s, c, w)
+#endif
+
 /* TCB operations */
 
 bool nxsched_verify_tcb(FAR struct tcb_s *tcb);
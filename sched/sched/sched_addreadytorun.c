@@ -91,7 +91,7 @@ bool nxsched_add_readytorun(FAR struct tcb_s *btcb)
 
   /* Otherwise, add the new task to the ready-to-run task list */
 
-  else if (nxsched_add_prioritized(btcb, list_readytorun()))
+  else if (nxsched_add_rtrlist(btcb))
     {
       /* The new btcb was added at the head of the ready-to-run list.  It
        * is now the new active task!
@@ -183,14 +183,14 @@ bool nxsched_switch_running(int cpu, bool switch_equal)
         {
           /* Found a task, remove it from ready-to-run list */
 
-          dq_rem((FAR struct dq_entry_s *)btcb, list_readytorun());
+          nxsched_remove_rtrlist(btcb);
 
           if (!is_idle_task(rtcb))
             {
               /* Put currently running task back to ready-to-run list */
 
               rtcb->task_state = TSTATE_TASK_READYTORUN;
-              nxsched_add_prioritized(rtcb, list_readytorun());
+              nxsched_add_rtrlist(rtcb);
             }
           else
             {
@@ -256,7 +256,7 @@ bool nxsched_add_readytorun(FAR struct tcb_s *btcb)
    */
 
   btcb->task_state = TSTATE_TASK_READYTORUN;
-  nxsched_add_prioritized(btcb, list_readytorun());
+  nxsched_add_rtrlist(btcb);
 
   if (target_cpu < CONFIG_SMP_NCPUS)
     {
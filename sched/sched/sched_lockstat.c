@@ -0,0 +1,738 @@
+/****************************************************************************
+ * sched/sched/sched_lockstat.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/stat.h>
+#include <inttypes.h>
+#include <sched.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <string.h>
+#include <time.h>
+#include <assert.h>
+#include <debug.h>
+#include <errno.h>
+
+#include <nuttx/arch.h>
+#include <nuttx/clock.h>
+#include <nuttx/kmalloc.h>
+#include <nuttx/semaphore.h>
+#include <nuttx/spinlock.h>
+#include <nuttx/fs/fs.h>
+#include <nuttx/fs/procfs.h>
+
+#include "sched/sched.h"
+
+#if !defined(CONFIG_DISABLE_MOUNTPOINT) && defined(CONFIG_FS_PROCFS)
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define LOCKSTAT_NENTRIES CONFIG_SCHED_LOCKSTAT_NENTRIES
+#define LOCKSTAT_NWAITERS CONFIG_SCHED_LOCKSTAT_NWAITERS
+
+/* Number of hash table slots probed before an acquisition is dropped */
+
+#define LOCKSTAT_PROBES   8
+
+#define LOCKSTAT_LINELEN  128
+
+/* Lock types */
+
+#define LOCKSTAT_SEM      1
+#define LOCKSTAT_MUTEX    2
+#define LOCKSTAT_SPINLOCK 3
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* A call site that had to wait for the lock */
+
+struct lockstat_waiter_s
+{
+  FAR void *caller;                   /* Return address of the waiter */
+  uint32_t count;                     /* Number of contended acquisitions */
+};
+
+/* The statistics of one lock instance */
+
+struct lockstat_entry_s
+{
+  FAR const void *lock;               /* Lock address, NULL if unused */
+  uint8_t type;                       /* See LOCKSTAT_* */
+  uint32_t acquired;                  /* Number of acquisitions */
+  uint32_t contended;                 /* Number of them that waited */
+  uint64_t waittotal;                 /* Total wait in nanoseconds */
+  uint64_t waitmax;                   /* Longest wait in nanoseconds */
+  struct lockstat_waiter_s waiters[LOCKSTAT_NWAITERS];
+};
+
+/* The statistics recorded on one CPU.  Only that CPU adds to them, so the
+ * lock is contended only by a read or a reset of /proc/lockstat.
+ */
+
+struct lockstat_s
+{
+  spinlock_t lock;                    /* Protects the table */
+  uint32_t dropped;                   /* Acquisitions lost, table was full */
+  struct lockstat_entry_s entries[LOCKSTAT_NENTRIES];
+};
+
+/* This structure describes one open "file" */
+
+struct lockstat_file_s
+{
+  struct procfs_file_s base;          /* Base open file structure */
+  FAR char *buffer;                   /* User provided buffer */
+  size_t remaining;                   /* Number of available characters */
+  size_t ncopied;                     /* Number of characters in buffer */
+  off_t offset;                       /* Current file offset */
+  char line[LOCKSTAT_LINELEN];        /* Buffer for one formatted line */
+};
+
+/****************************************************************************
+ * Private Function Prototypes
+ ****************************************************************************/
+
+/* File system methods */
+
+static int     lockstat_open(FAR struct file *filep,
+                             FAR const char *relpath, int oflags,
+                             mode_t mode);
+static int     lockstat_close(FAR struct file *filep);
+static ssize_t lockstat_read(FAR struct file *filep, FAR char *buffer,
+                             size_t buflen);
+static ssize_t lockstat_write(FAR struct file *filep,
+                              FAR const char *buffer, size_t buflen);
+static int     lockstat_dup(FAR const struct file *oldp,
+                            FAR struct file *newp);
+static int     lockstat_stat(FAR const char *relpath,
+                             FAR struct stat *buf);
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static struct lockstat_s g_lockstat[CONFIG_SMP_NCPUS];
+
+static FAR const char * const g_lockstat_type[] =
+{
+  "?", "sem", "mutex", "spin"
+};
+
+/****************************************************************************
+ * Public Data
+ ****************************************************************************/
+
+/* See fs_mount.c -- this structure is explicitly extern'ed there.
+ * We use the old-fashioned kind of initializers so that this will compile
+ * with any compiler.
+ */
+
+const struct procfs_operations g_lockstat_operations =
+{
+  lockstat_open,        /* open */
+  lockstat_close,       /* close */
+  lockstat_read,        /* read */
+  lockstat_write,       /* write */
+  NULL,                 /* poll */
+
+  lockstat_dup,         /* dup */
+
+  NULL,                 /* opendir */
+  NULL,                 /* closedir */
+  NULL,                 /* readdir */
+  NULL,                 /* rewinddir */
+
+  lockstat_stat         /* stat */
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: lockstat_lookup
+ *
+ * Description:
+ *   Find the entry of a lock in a table.  If 'create' is true, a free slot
+ *   is returned when the lock has none yet.  NULL if the lock is not found
+ *   within LOCKSTAT_PROBES slots.
+ *
+ ****************************************************************************/
+
+static FAR struct lockstat_entry_s *
+lockstat_lookup(FAR struct lockstat_s *stat, FAR const void *lock,
+                bool create)
+{
+  FAR struct lockstat_entry_s *entry;
+  uint32_t hash;
+  int i;
+
+  hash = (uint32_t)((uintptr_t)lock >> 2) * 2654435761u;
+
+  for (i = 0; i < LOCKSTAT_PROBES; i++)
+    {
+      entry = &stat->entries[(hash + i) % LOCKSTAT_NENTRIES];
+      if (entry->lock == lock)
+        {
+          return entry;
+        }
+
+      if (entry->lock == NULL)
+        {
+          return create ? entry : NULL;
+        }
+    }
+
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: lockstat_addwaiter
+ *
+ * Description:
+ *   Count the contended acquisitions of a call site, replacing the least
+ *   frequent one if all the slots are taken.
+ *
+ ****************************************************************************/
+
+static void lockstat_addwaiter(FAR struct lockstat_entry_s *entry,
+                               FAR void *caller, uint32_t count)
+{
+  FAR struct lockstat_waiter_s *waiter = &entry->waiters[0];
+  int i;
+
+  for (i = 0; i < LOCKSTAT_NWAITERS; i++)
+    {
+      if (entry->waiters[i].caller == caller ||
+          entry->waiters[i].count == 0)
+        {
+          waiter = &entry->waiters[i];
+          break;
+        }
+
+      if (entry->waiters[i].count < waiter->count)
+        {
+          waiter = &entry->waiters[i];
+        }
+    }
+
+  if (waiter->caller != caller)
+    {
+      waiter->caller = caller;
+      waiter->count  = 0;
+    }
+
+  waiter->count += count;
+}
+
+/****************************************************************************
+ * Name: lockstat_record
+ *
+ * Description:
+ *   Count one acquisition of a lock in the table of this CPU.  The table
+ *   is only ever locked with the untraced spinlock primitives, as the
+ *   spinlock statistics call here.
+ *
+ *   Spin and semaphore waits are both measured with the counter read by
+ *   perf_gettime() and converted to nanoseconds here, so they are
+ *   reported in the same unit.
+ *
+ ****************************************************************************/
+
+static void lockstat_record(FAR const void *lock, uint8_t type,
+                            bool contended, clock_t wait,
+                            FAR void *caller)
+{
+  FAR struct lockstat_s *stat;
+  FAR struct lockstat_entry_s *entry;
+  struct timespec ts;
+  irqstate_t flags;
+  uint64_t nsec = 0;
+
+  if (contended)
+    {
+      perf_convert(wait, &ts);
+      nsec = (uint64_t)ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+    }
+
+  flags = up_irq_save();
+  stat  = &g_lockstat[this_cpu()];
+  spin_lock_notrace(&stat->lock);
+
+  entry = lockstat_lookup(stat, lock, true);
+  if (entry == NULL)
+    {
+      stat->dropped++;
+      goto out;
+    }
+
+  if (entry->lock == NULL)
+    {
+      entry->lock = lock;
+      entry->type = type;
+    }
+
+  entry->acquired++;
+  if (!contended)
+    {
+      goto out;
+    }
+
+  entry->contended++;
+  entry->waittotal += nsec;
+  if (nsec > entry->waitmax)
+    {
+      entry->waitmax = nsec;
+    }
+
+  /* A waiter whose call site is unknown is not counted */
+
+  if (caller != NULL)
+    {
+      lockstat_addwaiter(entry, caller, 1);
+    }
+
+out:
+  spin_unlock_notrace(&stat->lock);
+  up_irq_restore(flags);
+}
+
+/****************************************************************************
+ * Name: lockstat_get
+ *
+ * Description:
+ *   Copy the entry of a lock from the table of one CPU.
+ *
+ ****************************************************************************/
+
+static bool lockstat_get(int cpu, FAR const void *lock,
+                         FAR struct lockstat_entry_s *entry)
+{
+  FAR struct lockstat_s *stat = &g_lockstat[cpu];
+  FAR struct lockstat_entry_s *found;
+  irqstate_t flags;
+
+  flags = spin_lock_irqsave_notrace(&stat->lock);
+  found = lockstat_lookup(stat, lock, false);
+  if (found != NULL)
+    {
+      memcpy(entry, found, sizeof(struct lockstat_entry_s));
+    }
+
+  spin_unlock_irqrestore_notrace(&stat->lock, flags);
+  return found != NULL;
+}
+
+/****************************************************************************
+ * Name: lockstat_merge
+ *
+ * Description:
+ *   Merge the statistics of the lock in slot 'index' of the table of
+ *   'cpu' with those of the same lock on the other CPUs.  Returns false if
+ *   the slot is empty or the lock was already reported for a lower CPU.
+ *
+ ****************************************************************************/
+
+static bool lockstat_merge(int cpu, int index,
+                           FAR struct lockstat_entry_s *merged)
+{
+  FAR struct lockstat_s *stat = &g_lockstat[cpu];
+  struct lockstat_entry_s entry;
+  irqstate_t flags;
+  int other;
+  int i;
+
+  flags = spin_lock_irqsave_notrace(&stat->lock);
+  memcpy(merged, &stat->entries[index], sizeof(struct lockstat_entry_s));
+  spin_unlock_irqrestore_notrace(&stat->lock, flags);
+
+  if (merged->lock == NULL)
+    {
+      return false;
+    }
+
+  for (other = 0; other < cpu; other++)
+    {
+      if (lockstat_get(other, merged->lock, &entry))
+        {
+          return false;
+        }
+    }
+
+  for (other = cpu + 1; other < CONFIG_SMP_NCPUS; other++)
+    {
+      if (!lockstat_get(other, merged->lock, &entry))
+        {
+          continue;
+        }
+
+      merged->acquired  += entry.acquired;
+      merged->contended += entry.contended;
+      merged->waittotal += entry.waittotal;
+      if (entry.waitmax > merged->waitmax)
+        {
+          merged->waitmax = entry.waitmax;
+        }
+
+      for (i = 0; i < LOCKSTAT_NWAITERS && entry.waiters[i].count; i++)
+        {
+          lockstat_addwaiter(merged, entry.waiters[i].caller,
+                             entry.waiters[i].count);
+        }
+    }
+
+  return true;
+}
+
+/****************************************************************************
+ * Name: lockstat_open
+ ****************************************************************************/
+
+static int lockstat_open(FAR struct file *filep, FAR const char *relpath,
+                         int oflags, mode_t mode)
+{
+  FAR struct lockstat_file_s *attr;
+
+  finfo("Open '%s'\n", relpath);
+
+  /* Allocate a container to hold the file attributes */
+
+  attr = kmm_zalloc(sizeof(struct lockstat_file_s));
+  if (!attr)
+    {
+      ferr("ERROR: Failed to allocate file attributes\n");
+      return -ENOMEM;
+    }
+
+  /* Save the attributes as the open-specific state in filep->f_priv */
+
+  filep->f_priv = (FAR void *)attr;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: lockstat_close
+ ****************************************************************************/
+
+static int lockstat_close(FAR struct file *filep)
+{
+  FAR struct lockstat_file_s *attr;
+
+  /* Recover our private data from the struct file instance */
+
+  attr = (FAR struct lockstat_file_s *)filep->f_priv;
+  DEBUGASSERT(attr);
+
+  /* Release the file attributes structure */
+
+  kmm_free(attr);
+  filep->f_priv = NULL;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: lockstat_copy
+ ****************************************************************************/
+
+static bool lockstat_copy(FAR struct lockstat_file_s *attr,
+                          size_t linesize)
+{
+  size_t copysize;
+
+  if (linesize >= LOCKSTAT_LINELEN)
+    {
+      linesize = LOCKSTAT_LINELEN - 1;
+    }
+
+  copysize = procfs_memcpy(attr->line, linesize, attr->buffer,
+                           attr->remaining, &attr->offset);
+
+  attr->ncopied   += copysize;
+  attr->buffer    += copysize;
+  attr->remaining -= copysize;
+  return attr->remaining > 0;
+}
+
+/****************************************************************************
+ * Name: lockstat_read
+ *
+ * Description:
+ *   Output one line per lock: the lock, its type, the number of
+ *   acquisitions and contended acquisitions and the total and maximum
+ *   wait in microseconds, followed by one indented line per waiting call
+ *   site.
+ *
+ ****************************************************************************/
+
+static ssize_t lockstat_read(FAR struct file *filep, FAR char *buffer,
+                             size_t buflen)
+{
+  FAR struct lockstat_file_s *attr;
+  struct lockstat_entry_s entry;
+  uint32_t dropped = 0;
+  size_t linesize;
+  int cpu;
+  int i;
+  int j;
+
+  finfo("buffer=%p buflen=%d\n", buffer, (int)buflen);
+
+  /* Recover our private data from the struct file instance */
+
+  attr = (FAR struct lockstat_file_s *)filep->f_priv;
+  DEBUGASSERT(attr);
+
+  /* Save the file offset and the user buffer information */
+
+  attr->offset    = filep->f_pos;
+  attr->buffer    = buffer;
+  attr->remaining = buflen;
+  attr->ncopied   = 0;
+
+  linesize = snprintf(attr->line, LOCKSTAT_LINELEN,
+                      "%-5s %10s %10s %12s %10s %s\n", "TYPE", "ACQUIRED",
+                      "CONTENDED", "WAIT(us)", "MAX(us)", "LOCK");
+  if (!lockstat_copy(attr, linesize))
+    {
+      goto out;
+    }
+
+  /* Each CPU records in its own table; a lock is reported once, with the
+   * counts of all the CPUs merged.
+   */
+
+  for (cpu = 0; cpu < CONFIG_SMP_NCPUS; cpu++)
+    {
+      dropped += g_lockstat[cpu].dropped;
+
+      for (i = 0; i < LOCKSTAT_NENTRIES; i++)
+        {
+          if (!lockstat_merge(cpu, i, &entry))
+            {
+              continue;
+            }
+
+          linesize = snprintf(attr->line, LOCKSTAT_LINELEN,
+                              "%-5s %10" PRIu32 " %10" PRIu32 " %12" PRIu64
+                              " %10" PRIu64 " %pS\n",
+                              g_lockstat_type[entry.type], entry.acquired,
+                              entry.contended,
+                              entry.waittotal / NSEC_PER_USEC,
+                              entry.waitmax / NSEC_PER_USEC, entry.lock);
+          if (!lockstat_copy(attr, linesize))
+            {
+              goto out;
+            }
+
+          for (j = 0; j < LOCKSTAT_NWAITERS; j++)
+            {
+              if (entry.waiters[j].count == 0)
+                {
+                  break;
+                }
+
+              linesize = snprintf(attr->line, LOCKSTAT_LINELEN,
+                                  "%16s %10" PRIu32 " %24s%pS\n", "",
+                                  entry.waiters[j].count, "",
+                                  entry.waiters[j].caller);
+              if (!lockstat_copy(attr, linesize))
+                {
+                  goto out;
+                }
+            }
+        }
+    }
+
+  /* Acquisitions lost to a full table show up as a lock of their own */
+
+  if (dropped > 0)
+    {
+      linesize = snprintf(attr->line, LOCKSTAT_LINELEN,
+                          "%-5s %10" PRIu32 " %35s%s\n", "", dropped,
+                          "", "[dropped]");
+      lockstat_copy(attr, linesize);
+    }
+
+out:
+
+  /* Update the file position */
+
+  filep->f_pos += attr->ncopied;
+  return attr->ncopied;
+}
+
+/****************************************************************************
+ * Name: lockstat_write
+ *
+ * Description:
+ *   "reset" clears the statistics.
+ *
+ ****************************************************************************/
+
+static ssize_t lockstat_write(FAR struct file *filep,
+                              FAR const char *buffer, size_t buflen)
+{
+  FAR struct lockstat_s *stat;
+  irqstate_t flags;
+  int cpu;
+
+  if (buflen < 5 || strncmp(buffer, "reset", 5) != 0)
+    {
+      return -EINVAL;
+    }
+
+  for (cpu = 0; cpu < CONFIG_SMP_NCPUS; cpu++)
+    {
+      stat  = &g_lockstat[cpu];
+      flags = spin_lock_irqsave_notrace(&stat->lock);
+      memset(stat->entries, 0, sizeof(stat->entries));
+      stat->dropped = 0;
+      spin_unlock_irqrestore_notrace(&stat->lock, flags);
+    }
+
+  return buflen;
+}
+
+/****************************************************************************
+ * Name: lockstat_dup
+ *
+ * Description:
+ *   Duplicate open file data in the new file structure.
+ *
+ ****************************************************************************/
+
+static int lockstat_dup(FAR const struct file *oldp, FAR struct file *newp)
+{
+  FAR struct lockstat_file_s *oldattr;
+  FAR struct lockstat_file_s *newattr;
+
+  finfo("Dup %p->%p\n", oldp, newp);
+
+  /* Recover our private data from the old struct file instance */
+
+  oldattr = (FAR struct lockstat_file_s *)oldp->f_priv;
+  DEBUGASSERT(oldattr);
+
+  /* Allocate a new container to hold the task and attribute selection */
+
+  newattr = kmm_malloc(sizeof(struct lockstat_file_s));
+  if (!newattr)
+    {
+      ferr("ERROR: Failed to allocate file attributes\n");
+      return -ENOMEM;
+    }
+
+  /* The copy the file attributes from the old attributes to the new */
+
+  memcpy(newattr, oldattr, sizeof(struct lockstat_file_s));
+
+  /* Save the new attributes in the new file structure */
+
+  newp->f_priv = (FAR void *)newattr;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: lockstat_stat
+ *
+ * Description: Return information about a file or directory
+ *
+ ****************************************************************************/
+
+static int lockstat_stat(FAR const char *relpath, FAR struct stat *buf)
+{
+  memset(buf, 0, sizeof(struct stat));
+  buf->st_mode = S_IFREG | S_IROTH | S_IRGRP | S_IRUSR | S_IWUSR;
+  return OK;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: nxsched_lockstat_sem
+ *
+ * Description:
+ *   Count one acquisition of a semaphore or mutex in nxsem_wait_slow().
+ *
+ * Input Parameters:
+ *   sem       - The semaphore that was taken.
+ *   contended - True if the caller had to block.
+ *   wait      - The time blocked, in perf_gettime() units.
+ *
+ ****************************************************************************/
+
+noinline_function
+void nxsched_lockstat_sem(FAR sem_t *sem, bool contended, clock_t wait)
+{
+  FAR void *caller = NULL;
+
+  /* Only the waiters are identified, a backtrace is costly.  The return
+   * address of this function would always be in nxsem_wait_slow().
+   */
+
+  if (contended)
+    {
+      sched_backtrace(_SCHED_GETTID(), &caller, 1,
+                      CONFIG_SCHED_LOCKSTAT_SKIP + 1);
+    }
+
+  lockstat_record(sem, NXSEM_IS_MUTEX(sem) ? LOCKSTAT_MUTEX : LOCKSTAT_SEM,
+                  contended, wait, caller);
+}
+
+/****************************************************************************
+ * Name: sched_lockstat_spinlock
+ *
+ * Description:
+ *   Count one acquisition of a spinlock.  spin_lock() is inlined, so the
+ *   return address is the call site.
+ *
+ * Input Parameters:
+ *   lock      - The spinlock that was taken.
+ *   contended - True if the caller had to spin.
+ *   wait      - The time spent spinning, in up_perf_gettime() units,
+ *               which are those of perf_gettime() when this is enabled.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SCHED_LOCKSTAT_SPINLOCK
+noinline_function
+void sched_lockstat_spinlock(FAR volatile spinlock_t *lock, bool contended,
+                             clock_t wait)
+{
+  lockstat_record((FAR const void *)lock, LOCKSTAT_SPINLOCK, contended,
+                  wait, contended ? return_address(0) : NULL);
+}
+#endif
+
+#endif /* !CONFIG_DISABLE_MOUNTPOINT && CONFIG_FS_PROCFS */
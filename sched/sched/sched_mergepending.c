@@ -61,6 +61,44 @@
  *
  ****************************************************************************/
 
+#ifdef CONFIG_SCHED_READYTORUN_BITMAP
+bool nxsched_merge_pending(void)
+{
+  FAR struct tcb_s *ptcb;
+  FAR struct tcb_s *rtcb;
+  bool ret = false;
+
+  /* Do nothing if pre-emption is still disabled */
+
+  if (!nxsched_islocked_tcb(this_task()))
+    {
+      /* Move every TCB in the g_pendingtasks list to the ready-to-run list.
+       * The priority index finds the insertion point of each TCB directly.
+       */
+
+      while ((ptcb = (FAR struct tcb_s *)
+                     dq_remfirst(list_pendingtasks())) != NULL)
+        {
+          if (nxsched_add_rtrlist(ptcb))
+            {
+              /* Inserted at the head: ptcb is the new running task */
+
+              rtcb              = ptcb->flink;
+              rtcb->task_state  = TSTATE_TASK_READYTORUN;
+              ptcb->task_state  = TSTATE_TASK_RUNNING;
+              up_update_task(ptcb);
+              ret               = true;
+            }
+          else
+            {
+              ptcb->task_state  = TSTATE_TASK_READYTORUN;
+            }
+        }
+    }
+
+  return ret;
+}
+#else
 bool nxsched_merge_pending(void)
 {
   FAR struct tcb_s *ptcb;
@@ -150,3 +188,4 @@ bool nxsched_merge_pending(void)
 
   return ret;
 }
+#endif
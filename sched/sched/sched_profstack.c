@@ -0,0 +1,542 @@
+/****************************************************************************
+ * sched/sched/sched_profstack.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/stat.h>
+#include <inttypes.h>
+#include <sched.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <string.h>
+#include <assert.h>
+#include <debug.h>
+#include <errno.h>
+
+#include <nuttx/arch.h>
+#include <nuttx/kmalloc.h>
+#include <nuttx/spinlock.h>
+#include <nuttx/wdog.h>
+#include <nuttx/fs/fs.h>
+#include <nuttx/fs/procfs.h>
+
+#include "sched/sched.h"
+
+#if !defined(CONFIG_DISABLE_MOUNTPOINT) && defined(CONFIG_FS_PROCFS)
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define PROFTICK NSEC2TICK(NSEC_PER_SEC / CONFIG_SCHED_PROFILE_TICKSPERSEC)
+
+#define PROFSTACK_DEPTH    CONFIG_SCHED_PROFILE_STACKS_DEPTH
+#define PROFSTACK_NENTRIES CONFIG_SCHED_PROFILE_STACKS_NENTRIES
+
+/* A backtrace taken from the timer interrupt starts with the frames of the
+ * interrupt handler itself, which are dropped afterwards.
+ */
+
+#define PROFSTACK_NFRAMES  (PROFSTACK_DEPTH + 16)
+
+/* Number of hash table slots probed before a sample is dropped */
+
+#define PROFSTACK_PROBES   8
+
+/* Longest folded line: the task name, one symbol per frame and the count */
+
+#define PROFSTACK_LINELEN  (CONFIG_TASK_NAME_SIZE + 48 * PROFSTACK_DEPTH + 16)
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* One distinct call stack of one task.  Frames are stored leaf first. */
+
+struct profstack_entry_s
+{
+  pid_t pid;                          /* Task that was interrupted */
+  uint16_t depth;                     /* Number of frames, zero if unused */
+  uint32_t count;                     /* Number of samples */
+  uintptr_t frames[PROFSTACK_DEPTH];  /* Return addresses, leaf first */
+};
+
+struct profstack_s
+{
+  struct wdog_s timer;                /* Timer for sampling */
+  spinlock_t lock;                    /* Protects the table */
+  bool running;                       /* Sampling is enabled */
+  uint32_t dropped;                   /* Samples lost, table was full */
+  struct profstack_entry_s entries[PROFSTACK_NENTRIES];
+};
+
+/* This structure describes one open "file" */
+
+struct profstack_file_s
+{
+  struct procfs_file_s base;          /* Base open file structure */
+  FAR char *buffer;                   /* User provided buffer */
+  size_t remaining;                   /* Number of available characters */
+  size_t ncopied;                     /* Number of characters in buffer */
+  off_t offset;                       /* Current file offset */
+  char line[PROFSTACK_LINELEN];       /* Buffer for one formatted line */
+};
+
+/****************************************************************************
+ * Private Function Prototypes
+ ****************************************************************************/
+
+#ifdef CONFIG_SMP
+static int profstack_sample(FAR void *arg);
+#endif
+
+/* File system methods */
+
+static int     profstack_open(FAR struct file *filep,
+                              FAR const char *relpath, int oflags,
+                              mode_t mode);
+static int     profstack_close(FAR struct file *filep);
+static ssize_t profstack_read(FAR struct file *filep, FAR char *buffer,
+                              size_t buflen);
+static ssize_t profstack_write(FAR struct file *filep,
+                               FAR const char *buffer, size_t buflen);
+static int     profstack_dup(FAR const struct file *oldp,
+                             FAR struct file *newp);
+static int     profstack_stat(FAR const char *relpath,
+                              FAR struct stat *buf);
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static struct profstack_s g_profstack;
+
+#ifdef CONFIG_SMP
+static struct smp_call_data_s g_profstack_call_data =
+SMP_CALL_INITIALIZER(profstack_sample, &g_profstack);
+#endif
+
+/****************************************************************************
+ * Public Data
+ ****************************************************************************/
+
+/* See fs_mount.c -- this structure is explicitly extern'ed there.
+ * We use the old-fashioned kind of initializers so that this will compile
+ * with any compiler.
+ */
+
+const struct procfs_operations g_profstack_operations =
+{
+  profstack_open,       /* open */
+  profstack_close,      /* close */
+  profstack_read,       /* read */
+  profstack_write,      /* write */
+  NULL,                 /* poll */
+
+  profstack_dup,        /* dup */
+
+  NULL,                 /* opendir */
+  NULL,                 /* closedir */
+  NULL,                 /* readdir */
+  NULL,                 /* rewinddir */
+
+  profstack_stat        /* stat */
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: profstack_sample
+ *
+ * Description:
+ *   Take one sample on this CPU: the interrupted PC followed by the call
+ *   stack of the running task, and count it in the stack table.
+ *
+ ****************************************************************************/
+
+static int profstack_sample(FAR void *arg)
+{
+  FAR struct profstack_s *prof = (FAR struct profstack_s *)arg;
+  FAR struct profstack_entry_s *entry;
+  FAR void *frames[PROFSTACK_NFRAMES];
+  FAR struct tcb_s *tcb = this_task();
+  uintptr_t pc = up_getusrpc(NULL);
+  irqstate_t flags;
+  uint32_t hash;
+  int depth;
+  int start;
+  int i;
+
+  /* Drop the frames of the interrupt handler, which end where the
+   * interrupted code was.  If the PC is not found the interrupted code
+   * probably had no frame yet, so record the PC alone.
+   */
+
+  depth = sched_backtrace(tcb->pid, frames, PROFSTACK_NFRAMES, 0);
+  for (start = 0; start < depth; start++)
+    {
+      if ((uintptr_t)frames[start] == pc)
+        {
+          break;
+        }
+    }
+
+  if (start >= depth)
+    {
+      frames[0] = (FAR void *)pc;
+      start = 0;
+      depth = 1;
+    }
+
+  depth -= start;
+  if (depth > PROFSTACK_DEPTH)
+    {
+      depth = PROFSTACK_DEPTH;
+    }
+
+  /* FNV-1a over the PID and the frames */
+
+  hash = 2166136261u ^ (uint32_t)tcb->pid;
+  for (i = 0; i < depth; i++)
+    {
+      hash = (hash ^ (uint32_t)(uintptr_t)frames[start + i]) * 16777619u;
+    }
+
+  flags = spin_lock_irqsave(&prof->lock);
+
+  for (i = 0; i < PROFSTACK_PROBES; i++)
+    {
+      entry = &prof->entries[(hash + i) % PROFSTACK_NENTRIES];
+      if (entry->depth == 0)
+        {
+          entry->pid   = tcb->pid;
+          entry->depth = depth;
+          entry->count = 1;
+          memcpy(entry->frames, &frames[start], depth * sizeof(uintptr_t));
+          break;
+        }
+
+      if (entry->pid == tcb->pid && entry->depth == depth &&
+          memcmp(entry->frames, &frames[start],
+                 depth * sizeof(uintptr_t)) == 0)
+        {
+          entry->count++;
+          break;
+        }
+    }
+
+  if (i >= PROFSTACK_PROBES)
+    {
+      prof->dropped++;
+    }
+
+  spin_unlock_irqrestore(&prof->lock, flags);
+  return OK;
+}
+
+/****************************************************************************
+ * Name: profstack_timer_handler
+ ****************************************************************************/
+
+static void profstack_timer_handler(wdparm_t arg)
+{
+  FAR struct profstack_s *prof = (FAR struct profstack_s *)(uintptr_t)arg;
+
+#ifdef CONFIG_SMP
+  cpu_set_t cpus = (1 << CONFIG_SMP_NCPUS) - 1;
+  CPU_CLR(this_cpu(), &cpus);
+  nxsched_smp_call_async(cpus, &g_profstack_call_data);
+#endif
+
+  profstack_sample(prof);
+  wd_start_next(&prof->timer, PROFTICK, profstack_timer_handler, arg);
+}
+
+/****************************************************************************
+ * Name: profstack_open
+ ****************************************************************************/
+
+static int profstack_open(FAR struct file *filep, FAR const char *relpath,
+                          int oflags, mode_t mode)
+{
+  FAR struct profstack_file_s *attr;
+
+  finfo("Open '%s'\n", relpath);
+
+  /* Allocate a container to hold the file attributes */
+
+  attr = kmm_zalloc(sizeof(struct profstack_file_s));
+  if (!attr)
+    {
+      ferr("ERROR: Failed to allocate file attributes\n");
+      return -ENOMEM;
+    }
+
+  /* Save the attributes as the open-specific state in filep->f_priv */
+
+  filep->f_priv = (FAR void *)attr;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: profstack_close
+ ****************************************************************************/
+
+static int profstack_close(FAR struct file *filep)
+{
+  FAR struct profstack_file_s *attr;
+
+  /* Recover our private data from the struct file instance */
+
+  attr = (FAR struct profstack_file_s *)filep->f_priv;
+  DEBUGASSERT(attr);
+
+  /* Release the file attributes structure */
+
+  kmm_free(attr);
+  filep->f_priv = NULL;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: profstack_copy
+ ****************************************************************************/
+
+static bool profstack_copy(FAR struct profstack_file_s *attr,
+                           size_t linesize)
+{
+  size_t copysize;
+
+  if (linesize >= PROFSTACK_LINELEN)
+    {
+      linesize = PROFSTACK_LINELEN - 1;
+    }
+
+  copysize = procfs_memcpy(attr->line, linesize, attr->buffer,
+                           attr->remaining, &attr->offset);
+
+  attr->ncopied   += copysize;
+  attr->buffer    += copysize;
+  attr->remaining -= copysize;
+  return attr->remaining > 0;
+}
+
+/****************************************************************************
+ * Name: profstack_read
+ *
+ * Description:
+ *   Output the stack table in the folded format of flamegraph.pl: the task
+ *   name and the frames from the outermost caller to the sampled PC,
+ *   separated by semicolons, followed by the number of samples.
+ *
+ ****************************************************************************/
+
+static ssize_t profstack_read(FAR struct file *filep, FAR char *buffer,
+                              size_t buflen)
+{
+  FAR struct profstack_s *prof = &g_profstack;
+  FAR struct profstack_file_s *attr;
+  struct profstack_entry_s entry;
+  FAR struct tcb_s *tcb;
+  irqstate_t flags;
+  size_t linesize;
+  int i;
+  int j;
+
+  finfo("buffer=%p buflen=%d\n", buffer, (int)buflen);
+
+  /* Recover our private data from the struct file instance */
+
+  attr = (FAR struct profstack_file_s *)filep->f_priv;
+  DEBUGASSERT(attr);
+
+  /* Save the file offset and the user buffer information */
+
+  attr->offset    = filep->f_pos;
+  attr->buffer    = buffer;
+  attr->remaining = buflen;
+  attr->ncopied   = 0;
+
+  for (i = 0; i < PROFSTACK_NENTRIES; i++)
+    {
+      flags = spin_lock_irqsave(&prof->lock);
+      memcpy(&entry, &prof->entries[i], sizeof(entry));
+      spin_unlock_irqrestore(&prof->lock, flags);
+
+      if (entry.depth == 0)
+        {
+          continue;
+        }
+
+      tcb = nxsched_get_tcb(entry.pid);
+#if CONFIG_TASK_NAME_SIZE > 0
+      if (tcb != NULL && tcb->name[0] != '\0')
+        {
+          linesize = snprintf(attr->line, PROFSTACK_LINELEN, "%s",
+                              tcb->name);
+        }
+      else
+#endif
+        {
+          linesize = snprintf(attr->line, PROFSTACK_LINELEN, "%d",
+                              entry.pid);
+        }
+
+      for (j = entry.depth - 1; j >= 0 && linesize < PROFSTACK_LINELEN;
+           j--)
+        {
+          linesize += snprintf(attr->line + linesize,
+                               PROFSTACK_LINELEN - linesize, ";%ps",
+                               (FAR void *)entry.frames[j]);
+        }
+
+      if (linesize < PROFSTACK_LINELEN)
+        {
+          linesize += snprintf(attr->line + linesize,
+                               PROFSTACK_LINELEN - linesize, " %" PRIu32
+                               "\n", entry.count);
+        }
+
+      if (!profstack_copy(attr, linesize))
+        {
+          break;
+        }
+    }
+
+  /* Samples lost to a full table show up as a stack of their own */
+
+  if (i >= PROFSTACK_NENTRIES && prof->dropped > 0)
+    {
+      linesize = snprintf(attr->line, PROFSTACK_LINELEN,
+                          "[dropped] %" PRIu32 "\n", prof->dropped);
+      profstack_copy(attr, linesize);
+    }
+
+  /* Update the file position */
+
+  filep->f_pos += attr->ncopied;
+  return attr->ncopied;
+}
+
+/****************************************************************************
+ * Name: profstack_write
+ *
+ * Description:
+ *   "start" begins sampling, "stop" ends it and "reset" clears the table.
+ *
+ ****************************************************************************/
+
+static ssize_t profstack_write(FAR struct file *filep,
+                               FAR const char *buffer, size_t buflen)
+{
+  FAR struct profstack_s *prof = &g_profstack;
+  irqstate_t flags;
+
+  if (buflen >= 5 && strncmp(buffer, "start", 5) == 0)
+    {
+      if (!prof->running)
+        {
+          prof->running = true;
+          wd_start(&prof->timer, PROFTICK, profstack_timer_handler,
+                   (wdparm_t)(uintptr_t)prof);
+        }
+    }
+  else if (buflen >= 4 && strncmp(buffer, "stop", 4) == 0)
+    {
+      prof->running = false;
+      wd_cancel(&prof->timer);
+    }
+  else if (buflen >= 5 && strncmp(buffer, "reset", 5) == 0)
+    {
+      flags = spin_lock_irqsave(&prof->lock);
+      memset(prof->entries, 0, sizeof(prof->entries));
+      prof->dropped = 0;
+      spin_unlock_irqrestore(&prof->lock, flags);
+    }
+  else
+    {
+      return -EINVAL;
+    }
+
+  return buflen;
+}
+
+/****************************************************************************
+ * Name: profstack_dup
+ *
+ * Description:
+ *   Duplicate open file data in the new file structure.
+ *
+ ****************************************************************************/
+
+static int profstack_dup(FAR const struct file *oldp, FAR struct file *newp)
+{
+  FAR struct profstack_file_s *oldattr;
+  FAR struct profstack_file_s *newattr;
+
+  finfo("Dup %p->%p\n", oldp, newp);
+
+  /* Recover our private data from the old struct file instance */
+
+  oldattr = (FAR struct profstack_file_s *)oldp->f_priv;
+  DEBUGASSERT(oldattr);
+
+  /* Allocate a new container to hold the task and attribute selection */
+
+  newattr = kmm_malloc(sizeof(struct profstack_file_s));
+  if (!newattr)
+    {
+      ferr("ERROR: Failed to allocate file attributes\n");
+      return -ENOMEM;
+    }
+
+  /* The copy the file attributes from the old attributes to the new */
+
+  memcpy(newattr, oldattr, sizeof(struct profstack_file_s));
+
+  /* Save the new attributes in the new file structure */
+
+  newp->f_priv = (FAR void *)newattr;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: profstack_stat
+ *
+ * Description: Return information about a file or directory
+ *
+ ****************************************************************************/
+
+static int profstack_stat(FAR const char *relpath, FAR struct stat *buf)
+{
+  memset(buf, 0, sizeof(struct stat));
+  buf->st_mode = S_IFREG | S_IROTH | S_IRGRP | S_IRUSR | S_IWUSR;
+  return OK;
+}
+
+#endif /* !CONFIG_DISABLE_MOUNTPOINT && CONFIG_FS_PROCFS */
@@ -0,0 +1,252 @@
+/****************************************************************************
+ * sched/sched/sched_rtrlist.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <strings.h>
+#include <sched.h>
+#include <assert.h>
+
+#include <nuttx/queue.h>
+
+#include "sched/sched.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define RTRMAP_NWORDS   ((SCHED_PRIORITY_MAX + 32) >> 5)
+#define RTRMAP_WORD(p)  ((p) >> 5)
+#define RTRMAP_BIT(p)   (UINT32_C(1) << ((p) & 31))
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* g_rtrtail[prio] is the last TCB of priority 'prio' in the ready-to-run
+ * list, or NULL if there is no such TCB.  g_rtrmap has a bit set for each
+ * priority whose g_rtrtail[] entry is non-NULL.
+ */
+
+static FAR struct tcb_s *g_rtrtail[SCHED_PRIORITY_MAX + 1];
+static uint32_t g_rtrmap[RTRMAP_NWORDS];
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: nxsched_rtrmap_higher
+ *
+ * Description:
+ *   Return the lowest priority present in the ready-to-run list that is
+ *   strictly higher than 'priority', or -1 if there is none.
+ *
+ ****************************************************************************/
+
+static int nxsched_rtrmap_higher(int priority)
+{
+  int word = RTRMAP_WORD(priority);
+  uint32_t map;
+
+  /* Mask off 'priority' and every priority below it in the first word.
+   * NOTE: (2 << 31) is zero for an unsigned 32-bit value.
+   */
+
+  map = g_rtrmap[word] & ~((UINT32_C(2) << (priority & 31)) - 1);
+
+  for (; ; )
+    {
+      if (map != 0)
+        {
+          return (word << 5) + ffs(map) - 1;
+        }
+
+      if (++word >= RTRMAP_NWORDS)
+        {
+          return -1;
+        }
+
+      map = g_rtrmap[word];
+    }
+}
+
+/****************************************************************************
+ * Name: nxsched_rtrlist_unindex
+ *
+ * Description:
+ *   Drop the TCB from the priority index.  The TCB must still be linked
+ *   into the ready-to-run list.
+ *
+ ****************************************************************************/
+
+static void nxsched_rtrlist_unindex(FAR struct tcb_s *tcb)
+{
+  int priority = tcb->sched_priority;
+  FAR struct tcb_s *prev;
+
+  if (g_rtrtail[priority] == tcb)
+    {
+      prev = tcb->blink;
+      if (prev != NULL && prev->sched_priority == priority)
+        {
+          g_rtrtail[priority] = prev;
+        }
+      else
+        {
+          g_rtrtail[priority] = NULL;
+          g_rtrmap[RTRMAP_WORD(priority)] &= ~RTRMAP_BIT(priority);
+        }
+    }
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: nxsched_add_rtrlist
+ *
+ * Description:
+ *   Insert a TCB into the prioritized ready-to-run list.  The TCB is placed
+ *   after all other TCBs of higher or equal priority, exactly as
+ *   nxsched_add_prioritized() would place it, but without walking the list.
+ *
+ * Input Parameters:
+ *   tcb - The TCB to be inserted.
+ *
+ * Returned Value:
+ *   true if the TCB was inserted at the head of the list.
+ *
+ * Assumptions:
+ * - The caller has established a critical section.
+ *
+ ****************************************************************************/
+
+bool nxsched_add_rtrlist(FAR struct tcb_s *tcb)
+{
+  int priority = tcb->sched_priority;
+  FAR struct tcb_s *prev;
+  int higher;
+
+  DEBUGASSERT(priority >= SCHED_PRIORITY_MIN &&
+              priority <= SCHED_PRIORITY_MAX);
+
+  /* Go after the last TCB of the same priority.  If there is none, go after
+   * the last TCB of the nearest higher priority.
+   */
+
+  prev = g_rtrtail[priority];
+  if (prev == NULL)
+    {
+      higher = nxsched_rtrmap_higher(priority);
+      if (higher >= 0)
+        {
+          prev = g_rtrtail[higher];
+        }
+
+      g_rtrmap[RTRMAP_WORD(priority)] |= RTRMAP_BIT(priority);
+    }
+
+  g_rtrtail[priority] = tcb;
+
+  if (prev == NULL)
+    {
+      dq_addfirst((FAR dq_entry_t *)tcb, list_readytorun());
+      return true;
+    }
+
+  dq_addafter((FAR dq_entry_t *)prev, (FAR dq_entry_t *)tcb,
+              list_readytorun());
+  return false;
+}
+
+/****************************************************************************
+ * Name: nxsched_remove_rtrlist
+ *
+ * Description:
+ *   Remove a TCB from the ready-to-run list and from the priority index.
+ *
+ * Input Parameters:
+ *   tcb - The TCB to be removed.
+ *
+ * Returned Value:
+ *   None
+ *
+ * Assumptions:
+ * - The caller has established a critical section.
+ *
+ ****************************************************************************/
+
+void nxsched_remove_rtrlist(FAR struct tcb_s *tcb)
+{
+  nxsched_rtrlist_unindex(tcb);
+  dq_rem((FAR dq_entry_t *)tcb, list_readytorun());
+}
+
+#ifndef CONFIG_SMP
+/****************************************************************************
+ * Name: nxsched_setprio_rtrlist
+ *
+ * Description:
+ *   Change the priority of the task at the head of the ready-to-run list
+ *   without moving it.  This is only valid if the new priority is still
+ *   higher than or equal to the priority of the next task in the list.
+ *
+ * Input Parameters:
+ *   tcb      - The TCB at the head of the ready-to-run list.
+ *   priority - The new priority of the task.
+ *
+ * Returned Value:
+ *   None
+ *
+ * Assumptions:
+ * - The caller has established a critical section.
+ *
+ ****************************************************************************/
+
+void nxsched_setprio_rtrlist(FAR struct tcb_s *tcb, int priority)
+{
+  DEBUGASSERT(tcb->blink == NULL &&
+              (tcb->flink == NULL ||
+               priority >= tcb->flink->sched_priority));
+
+  nxsched_rtrlist_unindex(tcb);
+  tcb->sched_priority = (uint8_t)priority;
+
+  /* Any other TCB of this priority follows the head, so the head can only
+   * become the tail of its priority if it is the only one.
+   */
+
+  if (g_rtrtail[priority] == NULL)
+    {
+      g_rtrtail[priority] = tcb;
+      g_rtrmap[RTRMAP_WORD(priority)] |= RTRMAP_BIT(priority);
+    }
+}
+#endif
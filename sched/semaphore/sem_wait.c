@@ -145,6 +145,8 @@ int nxsem_wait_slow(FAR sem_t *sem)
         {
           nxsem_add_holder(sem);
         }
+
+      nxsched_lockstat_sem(sem, false, 0);
     }
 
   /* The semaphore is NOT available, We will have to block the
@@ -156,6 +158,9 @@ int nxsem_wait_slow(FAR sem_t *sem)
 #ifdef CONFIG_PRIORITY_INHERITANCE
       uint8_t prioinherit = sem->flags & SEM_PRIO_MASK;
 #endif
+#ifdef CONFIG_SCHED_LOCKSTAT
+      clock_t start = perf_gettime();
+#endif
 
       /* First, verify that the task is not already waiting on a
        * semaphore
@@ -258,6 +263,13 @@ int nxsem_wait_slow(FAR sem_t *sem)
 
       ret = rtcb->errcode != OK ? -rtcb->errcode : OK;
 
+      /* Only waits that ended with the semaphore taken are counted */
+
+      if (ret == OK)
+        {
+          nxsched_lockstat_sem(sem, true, perf_gettime() - start);
+        }
+
 #ifdef CONFIG_MM_KMAP
       kmm_unmap(sem);
 #endif
@@ -80,7 +80,11 @@ int wd_cancel(FAR struct wdog_s *wdog)
    * cancellation is complete
    */
 
+#ifdef CONFIG_WDOG_TIMER_WHEEL
+  head = wd_wheel_isnext(wdog);
+#else
   head = list_is_head(&g_wdactivelist, &wdog->node);
+#endif
 
   /* Now, remove the watchdog from the timer queue */
 
@@ -97,6 +97,43 @@ static unsigned int g_wdtimernested;
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: wd_call
+ *
+ * Description:
+ *   Execute the function of an expired watchdog that has been removed from
+ *   the active watchdogs.  The watchdog lock is released during the call.
+ *
+ * Input Parameters:
+ *   wdog  - The expired watchdog
+ *   flags - The interrupt state saved when the lock was taken
+ *
+ * Returned Value:
+ *   The interrupt state saved when the lock was taken again.
+ *
+ ****************************************************************************/
+
+static inline_function irqstate_t wd_call(FAR struct wdog_s *wdog,
+                                          irqstate_t flags)
+{
+  wdentry_t func;
+  wdparm_t  arg;
+
+  /* Indicate that the watchdog is no longer active. */
+
+  func = wdog->func;
+  arg  = wdog->arg;
+
+  /* Execute the watchdog function */
+
+  up_setpicbase(wdog->picbase);
+  spin_unlock_irqrestore(&g_wdspinlock, flags);
+
+  CALL_FUNC(func, arg);
+
+  return spin_lock_irqsave(&g_wdspinlock);
+}
+
 /****************************************************************************
  * Name: wd_expiration
  *
@@ -116,8 +153,6 @@ static inline_function void wd_expiration(clock_t ticks)
 {
   FAR struct wdog_s *wdog;
   irqstate_t         flags;
-  wdentry_t          func;
-  wdparm_t           arg;
 
   flags = spin_lock_irqsave(&g_wdspinlock);
 
@@ -129,6 +164,33 @@ static inline_function void wd_expiration(clock_t ticks)
   g_wdtimernested++;
 #endif
 
+#ifdef CONFIG_WDOG_TIMER_WHEEL
+  /* Process every watchdog in the wheel that has expired by now */
+
+  for (; ; )
+    {
+      wdog = wd_wheel_expired(ticks);
+      if (wdog == NULL)
+        {
+          /* Re-evaluate after updating current ticks, so that watchdogs
+           * that came due while the callbacks ran are not left for the
+           * next tick.
+           */
+
+          clock_t now = clock_systime_ticks();
+
+          if (now == ticks)
+            {
+              break;
+            }
+
+          ticks = now;
+          continue;
+        }
+
+      flags = wd_call(wdog, flags);
+    }
+#else
   /* Process the watchdog at the head of the list as well as any
    * other watchdogs that became ready to run at this time
    */
@@ -158,20 +220,9 @@ static inline_function void wd_expiration(clock_t ticks)
 
       list_delete(&wdog->node);
 
-      /* Indicate that the watchdog is no longer active. */
-
-      func = wdog->func;
-      arg  = wdog->arg;
-
-      /* Execute the watchdog function */
-
-      up_setpicbase(wdog->picbase);
-      spin_unlock_irqrestore(&g_wdspinlock, flags);
-
-      CALL_FUNC(func, arg);
-
-      flags = spin_lock_irqsave(&g_wdspinlock);
+      flags = wd_call(wdog, flags);
     }
+#endif
 
 #ifdef CONFIG_SCHED_TICKLESS
   /* Decrement the nested watchdog timer count */
@@ -207,6 +258,16 @@ static inline_function
 bool wd_insert(FAR struct wdog_s *wdog, clock_t expired,
                wdentry_t wdentry, wdparm_t arg)
 {
+#ifdef CONFIG_WDOG_TIMER_WHEEL
+  wdog->func = wdentry;
+  up_getpicbase(&wdog->picbase);
+  wdog->arg = arg;
+  wdog->expired = expired;
+
+  /* The wheel reports whether the timer needs to be reassessed */
+
+  return wd_wheel_insert(wdog);
+#else
   FAR struct wdog_s *curr;
   FAR struct wdog_s *head;
 
@@ -241,6 +302,7 @@ bool wd_insert(FAR struct wdog_s *wdog, clock_t expired,
   /* Return whether the head of the watchdog list has changed. */
 
   return head == curr;
+#endif
 }
 
 /****************************************************************************
@@ -307,7 +369,11 @@ int wd_start_abstick(FAR struct wdog_s *wdog, clock_t ticks,
 
   if (WDOG_ISACTIVE(wdog))
     {
+#ifdef CONFIG_WDOG_TIMER_WHEEL
+      reassess |= wd_wheel_isnext(wdog);
+#else
       reassess |= list_is_head(&g_wdactivelist, &wdog->node);
+#endif
       list_delete(&wdog->node);
     }
 
@@ -374,7 +440,11 @@ int wd_start_abstick(FAR struct wdog_s *wdog, clock_t ticks,
 #ifdef CONFIG_SCHED_TICKLESS
 clock_t wd_timer(clock_t ticks, bool noswitches)
 {
+#ifdef CONFIG_WDOG_TIMER_WHEEL
+  clock_t next;
+#else
   FAR struct wdog_s *wdog;
+#endif
   irqstate_t flags;
   sclock_t ret;
 
@@ -389,6 +459,19 @@ clock_t wd_timer(clock_t ticks, bool noswitches)
 
   /* Return the delay for the next watchdog to expire */
 
+#ifdef CONFIG_WDOG_TIMER_WHEEL
+  /* The wheel may report a cascade point before the real expiration.  The
+   * timer then fires early and the next call computes a closer value.
+   */
+
+  if (!wd_wheel_nexttick(&next))
+    {
+      spin_unlock_irqrestore(&g_wdspinlock, flags);
+      return 0;
+    }
+
+  ret = next - ticks;
+#else
   if (list_is_empty(&g_wdactivelist))
     {
       spin_unlock_irqrestore(&g_wdspinlock, flags);
@@ -401,6 +484,7 @@ clock_t wd_timer(clock_t ticks, bool noswitches)
 
   wdog = list_first_entry(&g_wdactivelist, struct wdog_s, node);
   ret = wdog->expired - ticks;
+#endif
 
   spin_unlock_irqrestore(&g_wdspinlock, flags);
 
@@ -0,0 +1,444 @@
+/****************************************************************************
+ * sched/wdog/wd_wheel.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <strings.h>
+
+#include <nuttx/clock.h>
+#include <nuttx/list.h>
+#include <nuttx/wdog.h>
+
+#include "wdog/wdog.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Each level of the wheel has 32 slots.  A slot of level 'n' covers
+ * 32^n ticks, so five levels cover 2^25 ticks.  Watchdogs further out are
+ * kept on an overflow list that is re-sorted every 2^25 ticks.
+ */
+
+#define WHEEL_BITS       5
+#define WHEEL_SIZE       (1 << WHEEL_BITS)
+#define WHEEL_MASK       (WHEEL_SIZE - 1)
+#define WHEEL_LEVELS     5
+
+#define WHEEL_SHIFT(l)   ((l) * WHEEL_BITS)
+#define WHEEL_SPAN(l)    ((clock_t)1 << WHEEL_SHIFT(l))
+#define WHEEL_BIT(i)     (UINT32_C(1) << (i))
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* A slot list head is only valid while its bit is set in g_wdwheelmap.
+ * A set bit does not imply that the slot is non-empty: wd_cancel() just
+ * unlinks the watchdog, and the bit is cleared the next time the slot is
+ * looked at.
+ */
+
+static struct list_node g_wdwheel[WHEEL_LEVELS][WHEEL_SIZE];
+static uint32_t g_wdwheelmap[WHEEL_LEVELS];
+
+/* Watchdogs more than WHEEL_SPAN(WHEEL_LEVELS) ticks ahead */
+
+static struct list_node g_wdoverflow = LIST_INITIAL_VALUE(g_wdoverflow);
+
+/* Watchdogs that have expired but whose callback has not run yet */
+
+static struct list_node g_wdexpired = LIST_INITIAL_VALUE(g_wdexpired);
+
+/* The last tick whose level 0 slot has been processed */
+
+static clock_t g_wdbase;
+
+/* The next event reported by wd_wheel_nexttick(), i.e. the time the timer
+ * is programmed for in tickless mode.
+ */
+
+static clock_t g_wdnext;
+static bool g_wdnextvalid;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static inline_function uint32_t wd_wheel_ror(uint32_t map,
+                                             unsigned int n)
+{
+  return (map >> n) | (map << ((32 - n) & 31));
+}
+
+/****************************************************************************
+ * Name: wd_wheel_splice
+ *
+ * Description:
+ *   Move all entries of list 'src' to the tail of list 'dst'.
+ *
+ ****************************************************************************/
+
+static void wd_wheel_splice(FAR struct list_node *dst,
+                            FAR struct list_node *src)
+{
+  if (!list_is_empty(src))
+    {
+      src->next->prev = dst->prev;
+      dst->prev->next = src->next;
+      src->prev->next = dst;
+      dst->prev       = src->prev;
+      list_initialize(src);
+    }
+}
+
+/****************************************************************************
+ * Name: wd_wheel_place
+ *
+ * Description:
+ *   Link the watchdog into the slot covering its expiration time, relative
+ *   to the next tick to be processed.  Watchdogs already due are placed in
+ *   the slot of that next tick.
+ *
+ ****************************************************************************/
+
+static void wd_wheel_place(FAR struct wdog_s *wdog)
+{
+  clock_t base = g_wdbase + 1;
+  clock_t expired = wdog->expired;
+  FAR struct list_node *slot;
+  unsigned int index;
+  clock_t delta;
+  int level;
+
+  if ((sclock_t)(expired - base) < 0)
+    {
+      expired = base;
+    }
+
+  delta = expired - base;
+
+  for (level = 0; level < WHEEL_LEVELS; level++)
+    {
+      if (delta < WHEEL_SPAN(level + 1))
+        {
+          index = (expired >> WHEEL_SHIFT(level)) & WHEEL_MASK;
+          slot  = &g_wdwheel[level][index];
+
+          if ((g_wdwheelmap[level] & WHEEL_BIT(index)) == 0)
+            {
+              list_initialize(slot);
+              g_wdwheelmap[level] |= WHEEL_BIT(index);
+            }
+
+          list_add_tail(slot, &wdog->node);
+          return;
+        }
+    }
+
+  list_add_tail(&g_wdoverflow, &wdog->node);
+}
+
+/****************************************************************************
+ * Name: wd_wheel_nextevent
+ *
+ * Description:
+ *   Find the first tick after g_wdbase at which there is work to do: either
+ *   a level 0 slot with expired watchdogs or a higher level slot (or the
+ *   overflow list) that must be cascaded down.  This is a lower bound of
+ *   the next expiration time.
+ *
+ * Returned Value:
+ *   false if there are no active watchdogs.
+ *
+ ****************************************************************************/
+
+static bool wd_wheel_nextevent(FAR clock_t *next)
+{
+  clock_t base = g_wdbase + 1;
+  clock_t event = 0;
+  clock_t tick;
+  clock_t cur;
+  bool found = false;
+  unsigned int start;
+  unsigned int index;
+  unsigned int bit;
+  uint32_t map;
+  int level;
+  int slot;
+
+  for (level = 0; level < WHEEL_LEVELS; level++)
+    {
+      /* A slot is cascaded when its range is entered.  The current slot of
+       * a level can only be pending if 'base' is the start of its range.
+       */
+
+      cur   = base >> WHEEL_SHIFT(level);
+      start = (level == 0 ||
+               (base & (WHEEL_SPAN(level) - 1)) == 0) ? 0 : 1;
+      index = (cur + start) & WHEEL_MASK;
+
+      while ((map = wd_wheel_ror(g_wdwheelmap[level], index)) != 0)
+        {
+          bit  = ffs(map) - 1;
+          slot = (index + bit) & WHEEL_MASK;
+          if (list_is_empty(&g_wdwheel[level][slot]))
+            {
+              g_wdwheelmap[level] &= ~WHEEL_BIT(slot);
+              continue;
+            }
+
+          tick = (cur + start + bit) << WHEEL_SHIFT(level);
+          if (!found || (sclock_t)(tick - event) < 0)
+            {
+              event = tick;
+              found = true;
+            }
+
+          break;
+        }
+    }
+
+  if (!list_is_empty(&g_wdoverflow))
+    {
+      tick = (base + WHEEL_SPAN(WHEEL_LEVELS) - 1) &
+             ~(WHEEL_SPAN(WHEEL_LEVELS) - 1);
+      if (!found || (sclock_t)(tick - event) < 0)
+        {
+          event = tick;
+          found = true;
+        }
+    }
+
+  *next = event;
+  return found;
+}
+
+/****************************************************************************
+ * Name: wd_wheel_cascade
+ *
+ * Description:
+ *   Redistribute the watchdogs of every higher level slot (and of the
+ *   overflow list) whose range starts at 'tick'.  g_wdbase must be
+ *   tick - 1.  The watchdogs always move to a lower level, never into
+ *   another slot that is cascaded at 'tick'.
+ *
+ ****************************************************************************/
+
+static void wd_wheel_cascade(clock_t tick)
+{
+  struct list_node pending = LIST_INITIAL_VALUE(pending);
+  FAR struct wdog_s *wdog;
+  unsigned int index;
+  int level;
+
+  if ((tick & (WHEEL_SPAN(WHEEL_LEVELS) - 1)) == 0)
+    {
+      wd_wheel_splice(&pending, &g_wdoverflow);
+    }
+
+  for (level = WHEEL_LEVELS - 1; level > 0; level--)
+    {
+      if ((tick & (WHEEL_SPAN(level) - 1)) == 0)
+        {
+          index = (tick >> WHEEL_SHIFT(level)) & WHEEL_MASK;
+          if ((g_wdwheelmap[level] & WHEEL_BIT(index)) != 0)
+            {
+              wd_wheel_splice(&pending, &g_wdwheel[level][index]);
+              g_wdwheelmap[level] &= ~WHEEL_BIT(index);
+            }
+        }
+    }
+
+  while (!list_is_empty(&pending))
+    {
+      wdog = list_first_entry(&pending, struct wdog_s, node);
+      list_delete(&wdog->node);
+      wd_wheel_place(wdog);
+    }
+}
+
+/****************************************************************************
+ * Name: wd_wheel_isempty
+ ****************************************************************************/
+
+static bool wd_wheel_isempty(void)
+{
+  int level;
+
+  for (level = 0; level < WHEEL_LEVELS; level++)
+    {
+      if (g_wdwheelmap[level] != 0)
+        {
+          return false;
+        }
+    }
+
+  return list_is_empty(&g_wdoverflow) && list_is_empty(&g_wdexpired);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: wd_wheel_insert
+ *
+ * Description:
+ *   Add a watchdog to the timer wheel.  wdog->expired must already be set.
+ *
+ * Returned Value:
+ *   true if the watchdog expires before the next event last reported by
+ *   wd_wheel_nexttick(), so that the timer needs to be reassessed.
+ *
+ * Assumptions:
+ *   g_wdspinlock is held.
+ *
+ ****************************************************************************/
+
+bool wd_wheel_insert(FAR struct wdog_s *wdog)
+{
+  /* With no watchdogs active, g_wdbase may lag far behind in tickless
+   * mode.  Catch up so that the new watchdog lands in the right slot.
+   */
+
+  if (wd_wheel_isempty())
+    {
+      g_wdbase = clock_systime_ticks();
+    }
+
+  wd_wheel_place(wdog);
+
+  if (!g_wdnextvalid || (sclock_t)(wdog->expired - g_wdnext) < 0)
+    {
+      g_wdnext      = wdog->expired;
+      g_wdnextvalid = true;
+      return true;
+    }
+
+  return false;
+}
+
+/****************************************************************************
+ * Name: wd_wheel_isnext
+ *
+ * Description:
+ *   Return true if the watchdog is the event the timer is programmed for.
+ *
+ ****************************************************************************/
+
+bool wd_wheel_isnext(FAR struct wdog_s *wdog)
+{
+  return g_wdnextvalid && wdog->expired == g_wdnext;
+}
+
+/****************************************************************************
+ * Name: wd_wheel_expired
+ *
+ * Description:
+ *   Advance the wheel up to 'ticks' and return the next watchdog that has
+ *   expired, removed from the wheel.  Empty slots are skipped using the
+ *   slot bitmaps, so the cost depends on the number of events rather than
+ *   on the number of ticks elapsed.
+ *
+ * Returned Value:
+ *   The expired watchdog, or NULL if there is none.
+ *
+ * Assumptions:
+ *   g_wdspinlock is held.
+ *
+ ****************************************************************************/
+
+FAR struct wdog_s *wd_wheel_expired(clock_t ticks)
+{
+  FAR struct wdog_s *wdog;
+  unsigned int index;
+  clock_t next;
+
+  while (list_is_empty(&g_wdexpired))
+    {
+      if ((sclock_t)(ticks - g_wdbase) <= 0)
+        {
+          return NULL;
+        }
+
+      if (!wd_wheel_nextevent(&next) || (sclock_t)(next - ticks) > 0)
+        {
+          g_wdbase = ticks;
+          return NULL;
+        }
+
+      g_wdbase = next - 1;
+      wd_wheel_cascade(next);
+
+      index = next & WHEEL_MASK;
+      if ((g_wdwheelmap[0] & WHEEL_BIT(index)) != 0)
+        {
+          wd_wheel_splice(&g_wdexpired, &g_wdwheel[0][index]);
+          g_wdwheelmap[0] &= ~WHEEL_BIT(index);
+        }
+
+      g_wdbase = next;
+    }
+
+  wdog = list_first_entry(&g_wdexpired, struct wdog_s, node);
+  list_delete(&wdog->node);
+  return wdog;
+}
+
+/****************************************************************************
+ * Name: wd_wheel_nexttick
+ *
+ * Description:
+ *   Return the time of the next event of the wheel, which is never later
+ *   than the next expiration time.  The value is remembered for
+ *   wd_wheel_insert() and wd_wheel_isnext().
+ *
+ * Returned Value:
+ *   false if there are no active watchdogs.
+ *
+ * Assumptions:
+ *   g_wdspinlock is held.
+ *
+ ****************************************************************************/
+
+bool wd_wheel_nexttick(FAR clock_t *next)
+{
+  if (!list_is_empty(&g_wdexpired))
+    {
+      *next = g_wdbase;
+      g_wdnextvalid = true;
+    }
+  else
+    {
+      g_wdnextvalid = wd_wheel_nextevent(next);
+    }
+
+  g_wdnext = *next;
+  return g_wdnextvalid;
+}
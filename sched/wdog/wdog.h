@@ -59,7 +59,9 @@ extern "C"
  * this linked list are removed and the function is called.
  */
 
+#ifndef CONFIG_WDOG_TIMER_WHEEL
 extern struct list_node g_wdactivelist;
+#endif
 extern spinlock_t g_wdspinlock;
 
 /****************************************************************************
@@ -120,6 +122,24 @@ void wd_timer(clock_t ticks);
 struct tcb_s;
 void wd_recover(FAR struct tcb_s *tcb);
 
+/****************************************************************************
+ * Name: wd_wheel_insert, wd_wheel_isnext, wd_wheel_expired,
+ *       wd_wheel_nexttick
+ *
+ * Description:
+ *   Timer wheel backend of the active watchdogs, used in place of
+ *   g_wdactivelist when CONFIG_WDOG_TIMER_WHEEL is selected.  See
+ *   wd_wheel.c.  All of these must be called with g_wdspinlock held.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_WDOG_TIMER_WHEEL
+bool wd_wheel_insert(FAR struct wdog_s *wdog);
+bool wd_wheel_isnext(FAR struct wdog_s *wdog);
+FAR struct wdog_s *wd_wheel_expired(clock_t ticks);
+bool wd_wheel_nexttick(FAR clock_t *next);
+#endif
+
 #undef EXTERN
 #ifdef __cplusplus
 }
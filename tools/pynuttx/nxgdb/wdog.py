@@ -47,11 +47,44 @@ class WDog(Value, p.WDog):
         return self.__repr__()
 
 
+def get_wheel_lists():
+    """Return the lists that hold the watchdogs of the timer wheel"""
+
+    wheel = utils.gdb_eval_or_none("g_wdwheel")
+    if wheel is None:
+        return None
+
+    # A slot list head is only valid while its bit is set in g_wdwheelmap
+
+    wheelmap = utils.parse_and_eval("g_wdwheelmap")
+    levels = utils.nitems(wheel)
+    slots = utils.nitems(wheel[0])
+    heads = [
+        wheel[level][slot]
+        for level in range(levels)
+        for slot in range(slots)
+        if int(wheelmap[level]) & (1 << slot)
+    ]
+
+    heads.append(utils.parse_and_eval("g_wdexpired"))
+    heads.append(utils.parse_and_eval("g_wdoverflow"))
+    return heads
+
+
 def get_wdog_list() -> List[WDog]:
     wdogs = []
-    active = utils.parse_and_eval("g_wdactivelist")
-    for wdog in lists.NxList(active, "struct wdog_s", "node"):
-        wdogs.append(WDog(wdog))
+    heads = get_wheel_lists()
+    if heads is None:
+        heads = [utils.parse_and_eval("g_wdactivelist")]
+
+    for head in heads:
+        for wdog in lists.NxList(head, "struct wdog_s", "node"):
+            wdogs.append(WDog(wdog))
+
+    # The wheel keeps no global order, so sort by expiration time
+
+    if len(heads) > 1:
+        wdogs.sort(key=lambda wdog: int(wdog.expired))
 
     return wdogs
 